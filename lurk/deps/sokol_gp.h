@@ -4,6 +4,17 @@ sokol_gp - v0.2.1 - 31/Oct/2023
 Eduardo Bart - edub4rt@gmail.com
 https://github.com/edubart/sokol_gp
 
+Vendored for lurk, with these changes from upstream v0.2.1:
+- The draw color is written into each vertex (attribute 1, 4 UBYTE4N bytes) instead of
+  a fragment uniform, so it's clamped to [0,1] and custom shaders on D3D11 must give
+  attribute 1 a TEXCOORD1 semantic. See "Color modulation".
+- `sgp_draw_callback()` and `sgp_flush_scaled()`. See "Custom draw callbacks".
+- Rects are drawn as indexed quads, 4 vertices each through a shared index buffer.
+- Vertices are transformed in batches by SSE2, AVX2 or NEON kernels picked at runtime.
+  See "Vertex transform kernels".
+- Array draws cull each primitive against the viewport and scissor, except with a custom
+  pipeline. See "Primitive culling".
+
 # Sokol GP
 
 Minimal efficient cross platform 2D graphics painter in pure C
@@ -68,6 +79,10 @@ thus the programmer does not need to manage batched draw calls manually,
 nor he needs to sort batched texture draw calls,
 the library will do this seamlessly behind the scenes.
 
+Rects (filled, textured and clears) are written as 4 vertices each and drawn through
+a static index buffer shared by every quad, instead of 6 vertices per rect,
+so they upload a third less vertex data. Rects drawn with a custom pipeline still use 6.
+
 The batching algorithm is fast, but it has `O(n)` CPU complexity for every new draw command added,
 where `n` is the `SGP_BATCH_OPTIMIZER_DEPTH` configuration.
 In experiments using `8` as the default is a good default,
@@ -316,6 +331,15 @@ All common pipelines have color modulation, and you can modulate
 a color before a draw by setting the current state color with `sgp_set_color(r,g,b,a)`,
 later you should reset the color to default (white) with `sgp_reset_color()`.
 
+The color is written into every vertex of the draw (as 4 normalized bytes, attribute 1)
+rather than a uniform, so draws that only differ in color are still batched together.
+Custom shaders can read it from the `color` attribute, and on D3D11 they have to give
+attribute 1 a semantic (`TEXCOORD1`) even when they don't use it.
+
+Because of the packing each channel is clamped to [0,1] and quantized to 1/255. A color
+above 1 saturates instead of brightening the texture, and one below 0 is black, so
+effects that relied on overbright modulation need a custom shader with their own uniform.
+
 ## Custom shaders
 
 When using a custom shader, you must create a pipeline for it with `sgp_make_pipeline(desc)`,
@@ -339,6 +363,19 @@ and increasing a larger value means more overhead.
 If you are using custom shaders please increase this value to be large enough to hold
 the number of uniforms of your largest shader.
 
+## Custom draw callbacks
+
+Draws that don't fit SGP's vertex format, like instanced ones, can be issued to Sokol GFX
+directly by queueing a callback with `sgp_draw_callback(callback, user_data)`. The callback
+is called by `sgp_flush()` in order with the other draws, inside the same render pass, and
+the batch optimizer never merges a draw queued after it into one before it. The callback
+can apply its own pipeline, bindings and uniforms, SGP applies its own again for the next
+draw. It must leave the viewport and scissor as they were.
+
+`sgp_flush_scaled(sx, sy)` flushes like `sgp_flush()` with every viewport and scissor rect
+scaled, for drawing a queue recorded at one size into a pass of another. Vertices are
+already in clip space, so they don't need to change.
+
 ## Library configuration
 
 The following macros can be defined before including to change the library behavior:
@@ -346,6 +383,27 @@ The following macros can be defined before including to change the library behav
 - `SGP_BATCH_OPTIMIZER_DEPTH` - Number of draw commands that the batch optimizer looks back at. Default is 8.
 - `SGP_UNIFORM_CONTENT_SLOTS` - Maximum number of floats that can be stored in each draw call uniform buffer. Default is 4.
 - `SGP_TEXTURE_SLOTS` - Maximum number of textures that can be bound per draw call. Default is 4.
+- `SGP_DISABLE_SIMD` - Always transform vertices with the scalar code, see below.
+
+## Vertex transform kernels
+
+Vertices are transformed by the current matrix and bounded for the batch optimizer in blocks,
+with SSE2 or AVX2 on x86 and NEON on ARM64. The kernel is picked once in `sgp_setup()` from
+the features of the CPU the program runs on, so builds don't need `-mavx2`,
+and the scalar code is used everywhere else. Draws of only a few vertices, like a single
+rect, always use the scalar code. `sgp_query_transform_kernel()` names the one in use.
+
+## Primitive culling
+
+The array draw functions (`sgp_draw_filled_rects`, `sgp_draw_textured_rects`, `sgp_draw_lines`,
+`sgp_draw_points` and `sgp_draw_filled_triangles`) test each primitive against the viewport
+and scissor before writing its vertices, so a large array that's mostly off-screen only
+transforms and uploads the part that can be seen. The test is done on the untransformed
+primitives against the visible area mapped back through the current transform, it's exact
+unless the transform rotates, when some primitives just off-screen are still drawn. Strips
+are kept whole, only the batch is rejected when it's off-screen. `sgp_query_culled()`
+returns how many primitives were culled since the outermost `sgp_begin()`.
+Nothing is culled while a custom pipeline is set, as its vertex shader can move vertices anywhere.
 
 ## License
 
@@ -425,6 +483,7 @@ typedef enum sgp_error {
     SGP_ERROR_STATE_STACK_UNDERFLOW,
     SGP_ERROR_ALLOC_FAILED,
     SGP_ERROR_MAKE_VERTEX_BUFFER_FAILED,
+    SGP_ERROR_MAKE_INDEX_BUFFER_FAILED,
     SGP_ERROR_MAKE_WHITE_IMAGE_FAILED,
     SGP_ERROR_MAKE_NEAREST_SAMPLER_FAILED,
     SGP_ERROR_MAKE_COMMON_SHADER_FAILED,
@@ -489,6 +548,10 @@ typedef struct sgp_color {
     float r, g, b, a;
 } sgp_color;
 
+typedef struct sgp_color_ub4 {
+    uint8_t r, g, b, a;
+} sgp_color_ub4;
+
 typedef struct sgp_uniform {
     uint32_t size;
     float content[SGP_UNIFORM_CONTENT_SLOTS];
@@ -519,6 +582,9 @@ typedef struct sgp_state {
     uint32_t _base_command;
 } sgp_state;
 
+/* Called by sgp_flush() to issue custom Sokol GFX draws in order with the queued ones. */
+typedef void (*sgp_callback)(void* user_data);
+
 /* Structure that defines SGP setup parameters. */
 typedef struct sgp_desc {
     uint32_t max_vertices;
@@ -547,9 +613,10 @@ SOKOL_GP_API_DECL const char* sgp_get_error_message(sgp_error error);   /* Retur
 SOKOL_GP_API_DECL sg_pipeline sgp_make_pipeline(const sgp_pipeline_desc* desc); /* Creates a custom shader pipeline to be used with SGP. */
 
 /* Draw command queue management. */
-SOKOL_GP_API_DECL void sgp_begin(int width, int height);    /* Begins a new SGP draw command queue. */
-SOKOL_GP_API_DECL void sgp_flush(void);                     /* Dispatch current Sokol GFX draw commands. */
-SOKOL_GP_API_DECL void sgp_end(void);                       /* End current draw command queue, discarding it. */
+SOKOL_GP_API_DECL void sgp_begin(int width, int height);        /* Begins a new SGP draw command queue. */
+SOKOL_GP_API_DECL void sgp_flush(void);                         /* Dispatch current Sokol GFX draw commands. */
+SOKOL_GP_API_DECL void sgp_flush_scaled(float sx, float sy);    /* Dispatch current Sokol GFX draw commands, with viewport and scissor rects scaled. */
+SOKOL_GP_API_DECL void sgp_end(void);                           /* End current draw command queue, discarding it. */
 
 /* 2D coordinate space projection */
 SOKOL_GP_API_DECL void sgp_project(float left, float right, float top, float bottom); /* Set the coordinate space boundary in the current viewport. */
@@ -569,7 +636,7 @@ SOKOL_GP_API_DECL void sgp_scale_at(float sx, float sy, float x, float y);  /* S
 SOKOL_GP_API_DECL void sgp_set_pipeline(sg_pipeline pipeline);              /* Sets current draw pipeline. */
 SOKOL_GP_API_DECL void sgp_reset_pipeline(void);                            /* Resets to the current draw pipeline to default (builtin pipelines). */
 SOKOL_GP_API_DECL void sgp_set_uniform(const void* data, uint32_t size);    /* Sets uniform buffer for a custom pipeline. */
-SOKOL_GP_API_DECL void sgp_reset_uniform(void);                             /* Resets uniform buffer to default (current state color). */
+SOKOL_GP_API_DECL void sgp_reset_uniform(void);                             /* Resets uniform buffer to empty. */
 
 /* State change functions for the common pipelines. */
 SOKOL_GP_API_DECL void sgp_set_blend_mode(sgp_blend_mode blend_mode);       /* Sets current blend mode. */
@@ -603,10 +670,13 @@ SOKOL_GP_API_DECL void sgp_draw_filled_rects(const sgp_rect* rects, uint32_t cou
 SOKOL_GP_API_DECL void sgp_draw_filled_rect(float x, float y, float w, float h);                                /* Draws a single rectangle. */
 SOKOL_GP_API_DECL void sgp_draw_textured_rects(int channel, const sgp_textured_rect* rects, uint32_t count);    /* Draws a batch textured rectangle, each from a source region. */
 SOKOL_GP_API_DECL void sgp_draw_textured_rect(int channel, sgp_rect dest_rect, sgp_rect src_rect);              /* Draws a single textured rectangle from a source region. */
+SOKOL_GP_API_DECL void sgp_draw_callback(sgp_callback callback, void* user_data);                               /* Queues a callback that issues its own Sokol GFX draws when flushed. */
 
 /* Querying functions. */
 SOKOL_GP_API_DECL sgp_state* sgp_query_state(void); /* Returns the current draw state. */
 SOKOL_GP_API_DECL sgp_desc sgp_query_desc(void);    /* Returns description of the current SGP context. */
+SOKOL_GP_API_DECL const char* sgp_query_transform_kernel(void); /* Returns the name of the vertex transform kernel in use. */
+SOKOL_GP_API_DECL uint32_t sgp_query_culled(void);  /* Returns how many primitives were culled since the outermost sgp_begin(). */
 
 #ifdef __cplusplus
 } // extern "C"
@@ -646,12 +716,21 @@ enum {
 typedef struct _sgp_vertex {
     sgp_vec2 position;
     sgp_vec2 texcoord;
+    sgp_color_ub4 color;
 } _sgp_vertex;
 
 typedef struct _sgp_region {
     float x1, y1, x2, y2;
 } _sgp_region;
 
+typedef void (*_sgp_transform_func)(const sgp_mat2x3* m, _sgp_vertex* vertices, uint32_t count, _sgp_region* region);
+
+typedef struct _sgp_transform_kernel {
+    const char* name;
+    _sgp_transform_func transform;
+    bool (*supported)(void); // NULL when every CPU the target runs on has it
+} _sgp_transform_kernel;
+
 typedef struct _sgp_draw_args {
     sg_pipeline pip;
     sgp_textures_uniform textures;
@@ -661,17 +740,24 @@ typedef struct _sgp_draw_args {
     uint32_t num_vertices;
 } _sgp_draw_args;
 
+typedef struct _sgp_callback_args {
+    sgp_callback func;
+    void* user_data;
+} _sgp_callback_args;
+
 typedef union _sgp_command_args {
     _sgp_draw_args draw;
     sgp_irect viewport;
     sgp_irect scissor;
+    _sgp_callback_args callback;
 } _sgp_command_args;
 
 typedef enum _sgp_command_type {
     SGP_COMMAND_NONE = 0,
     SGP_COMMAND_DRAW,
     SGP_COMMAND_VIEWPORT,
-    SGP_COMMAND_SCISSOR
+    SGP_COMMAND_SCISSOR,
+    SGP_COMMAND_CALLBACK
 } _sgp_command_type;
 
 typedef struct _sgp_command {
@@ -687,9 +773,13 @@ typedef struct _sgp_context {
     // resources
     sg_shader shader;
     sg_buffer vertex_buf;
+    sg_buffer quad_index_buf;
+    sg_index_type quad_index_type;
     sg_image white_img;
     sg_sampler nearest_smp;
     sg_pipeline pipelines[_SG_PRIMITIVETYPE_NUM*_SGP_BLENDMODE_NUM];
+    sg_pipeline quad_pipelines[_SGP_BLENDMODE_NUM];
+    _sgp_transform_kernel transform;
 
     // command queue
     uint32_t cur_vertex;
@@ -701,6 +791,7 @@ typedef struct _sgp_context {
     _sgp_vertex* vertices;
     sgp_uniform* uniforms;
     _sgp_command* commands;
+    uint32_t num_culled;
 
     // state tracking
     sgp_state state;
@@ -721,6 +812,236 @@ static const sgp_mat2x3 _sgp_mat3_identity = {{
 
 static const sgp_color _sgp_white_color = {1.0f, 1.0f, 1.0f, 1.0f};
 
+////////////////////////////////////////////////////////////////////////////////
+// Vertex transform kernels
+
+// Every kernel gives the same results as the scalar code only while the compiler
+// doesn't fuse their multiplies and adds, which GCC does by default outside ISO
+// mode and clang does on ARM64 (and anywhere with -ffp-contract=fast). Contraction
+// is turned off for the kernels alone, GCC takes it as a function attribute and
+// clang as a pragma at the top of the body. MSVC only contracts with /fp:fast or
+// /fp:contract, where the results aren't expected to match anyway.
+#if defined(__clang__)
+#define _SGP_NO_FP_CONTRACT
+#define _SGP_FP_CONTRACT_OFF _Pragma("STDC FP_CONTRACT OFF")
+#elif defined(__GNUC__)
+#define _SGP_NO_FP_CONTRACT __attribute__((optimize("fp-contract=off")))
+#define _SGP_FP_CONTRACT_OFF
+#else
+#define _SGP_NO_FP_CONTRACT
+#define _SGP_FP_CONTRACT_OFF
+#endif
+
+// Transforms the positions of `count` vertices by `m` in place and grows
+// `region` to bound them. The SIMD kernels work on blocks of 4 or 8 vertices
+// and leave the remainder to the scalar one.
+_SGP_NO_FP_CONTRACT static void _sgp_transform_vertices_scalar(const sgp_mat2x3* m, _sgp_vertex* vertices, uint32_t count, _sgp_region* region) {
+    _SGP_FP_CONTRACT_OFF
+    sgp_mat2x3 mvp = *m; // copy to stack for more efficiency
+    _sgp_region r = *region;
+    for(uint32_t i=0;i<count;++i) {
+        sgp_vec2 v = vertices[i].position;
+        sgp_vec2 p = {
+            mvp.v[0][0]*v.x + mvp.v[0][1]*v.y + mvp.v[0][2],
+            mvp.v[1][0]*v.x + mvp.v[1][1]*v.y + mvp.v[1][2]
+        };
+        r.x1 = _sg_min(r.x1, p.x);
+        r.y1 = _sg_min(r.y1, p.y);
+        r.x2 = _sg_max(r.x2, p.x);
+        r.y2 = _sg_max(r.y2, p.y);
+        vertices[i].position = p;
+    }
+    *region = r;
+}
+
+static void _sgp_region_reduce(_sgp_region* region, const float* x1, const float* y1, const float* x2, const float* y2, int lanes) {
+    for(int i=0;i<lanes;++i) {
+        region->x1 = _sg_min(region->x1, x1[i]);
+        region->y1 = _sg_min(region->y1, y1[i]);
+        region->x2 = _sg_max(region->x2, x2[i]);
+        region->y2 = _sg_max(region->y2, y2[i]);
+    }
+}
+
+#if !defined(SGP_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define _SGP_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define _SGP_TARGET_SSE2
+#define _SGP_TARGET_AVX2
+#else
+#define _SGP_TARGET_SSE2 __attribute__((target("sse2")))
+#define _SGP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// positions are 8 bytes inside each vertex, so they're loaded and stored a pair of floats at a time
+_SGP_TARGET_SSE2 _SGP_NO_FP_CONTRACT static void _sgp_transform_vertices_sse2(const sgp_mat2x3* m, _sgp_vertex* vertices, uint32_t count, _sgp_region* region) {
+    _SGP_FP_CONTRACT_OFF
+    const __m128 m00 = _mm_set1_ps(m->v[0][0]), m01 = _mm_set1_ps(m->v[0][1]), m02 = _mm_set1_ps(m->v[0][2]);
+    const __m128 m10 = _mm_set1_ps(m->v[1][0]), m11 = _mm_set1_ps(m->v[1][1]), m12 = _mm_set1_ps(m->v[1][2]);
+    __m128 x1 = _mm_set1_ps(region->x1), y1 = _mm_set1_ps(region->y1);
+    __m128 x2 = _mm_set1_ps(region->x2), y2 = _mm_set1_ps(region->y2);
+    uint32_t blocks = count / 4;
+    for(uint32_t i=0;i<blocks;++i) {
+        _sgp_vertex* v = &vertices[i*4];
+        __m128 a = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)&v[0].position), (const __m64*)&v[1].position);
+        __m128 b = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)&v[2].position), (const __m64*)&v[3].position);
+        __m128 x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 px = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m01, y)), m02);
+        __m128 py = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, x), _mm_mul_ps(m11, y)), m12);
+        x1 = _mm_min_ps(x1, px); y1 = _mm_min_ps(y1, py);
+        x2 = _mm_max_ps(x2, px); y2 = _mm_max_ps(y2, py);
+        __m128 lo = _mm_unpacklo_ps(px, py), hi = _mm_unpackhi_ps(px, py);
+        _mm_storel_pi((__m64*)&v[0].position, lo);
+        _mm_storeh_pi((__m64*)&v[1].position, lo);
+        _mm_storel_pi((__m64*)&v[2].position, hi);
+        _mm_storeh_pi((__m64*)&v[3].position, hi);
+    }
+    float rx1[4], ry1[4], rx2[4], ry2[4];
+    _mm_storeu_ps(rx1, x1); _mm_storeu_ps(ry1, y1);
+    _mm_storeu_ps(rx2, x2); _mm_storeu_ps(ry2, y2);
+    _sgp_region_reduce(region, rx1, ry1, rx2, ry2, 4);
+    _sgp_transform_vertices_scalar(m, &vertices[blocks*4], count - blocks*4, region);
+}
+
+// the strided positions are gathered 8 at a time
+_SGP_TARGET_AVX2 _SGP_NO_FP_CONTRACT static void _sgp_transform_vertices_avx2(const sgp_mat2x3* m, _sgp_vertex* vertices, uint32_t count, _sgp_region* region) {
+    _SGP_FP_CONTRACT_OFF
+    const __m256 m00 = _mm256_set1_ps(m->v[0][0]), m01 = _mm256_set1_ps(m->v[0][1]), m02 = _mm256_set1_ps(m->v[0][2]);
+    const __m256 m10 = _mm256_set1_ps(m->v[1][0]), m11 = _mm256_set1_ps(m->v[1][1]), m12 = _mm256_set1_ps(m->v[1][2]);
+    __m256 x1 = _mm256_set1_ps(region->x1), y1 = _mm256_set1_ps(region->y1);
+    __m256 x2 = _mm256_set1_ps(region->x2), y2 = _mm256_set1_ps(region->y2);
+    const int stride = (int)(sizeof(_sgp_vertex) / sizeof(float));
+    const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+    uint32_t blocks = count / 8;
+    for(uint32_t i=0;i<blocks;++i) {
+        _sgp_vertex* v = &vertices[i*8];
+        __m256 x = _mm256_i32gather_ps(&v[0].position.x, offsets, 4);
+        __m256 y = _mm256_i32gather_ps(&v[0].position.y, offsets, 4);
+        __m256 px = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m01, y)), m02);
+        __m256 py = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m10, x), _mm256_mul_ps(m11, y)), m12);
+        x1 = _mm256_min_ps(x1, px); y1 = _mm256_min_ps(y1, py);
+        x2 = _mm256_max_ps(x2, px); y2 = _mm256_max_ps(y2, py);
+        // each 128 bit lane interleaves to {0,1,2,3} and {4,5,6,7}
+        __m256 lo = _mm256_unpacklo_ps(px, py), hi = _mm256_unpackhi_ps(px, py);
+        __m128 lo0 = _mm256_castps256_ps128(lo), lo1 = _mm256_extractf128_ps(lo, 1);
+        __m128 hi0 = _mm256_castps256_ps128(hi), hi1 = _mm256_extractf128_ps(hi, 1);
+        _mm_storel_pi((__m64*)&v[0].position, lo0);
+        _mm_storeh_pi((__m64*)&v[1].position, lo0);
+        _mm_storel_pi((__m64*)&v[2].position, hi0);
+        _mm_storeh_pi((__m64*)&v[3].position, hi0);
+        _mm_storel_pi((__m64*)&v[4].position, lo1);
+        _mm_storeh_pi((__m64*)&v[5].position, lo1);
+        _mm_storel_pi((__m64*)&v[6].position, hi1);
+        _mm_storeh_pi((__m64*)&v[7].position, hi1);
+    }
+    float rx1[8], ry1[8], rx2[8], ry2[8];
+    _mm256_storeu_ps(rx1, x1); _mm256_storeu_ps(ry1, y1);
+    _mm256_storeu_ps(rx2, x2); _mm256_storeu_ps(ry2, y2);
+    _sgp_region_reduce(region, rx1, ry1, rx2, ry2, 8);
+    // clear the upper halves before going back to SSE code, the compiler doesn't on the tail call
+    _mm256_zeroupper();
+    _sgp_transform_vertices_scalar(m, &vertices[blocks*8], count - blocks*8, region);
+}
+
+static bool _sgp_cpu_has_sse2(void) {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true; // part of the x86-64 baseline
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] >> 26) & 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static bool _sgp_cpu_has_avx2(void) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    // the OS has to save the ymm registers too
+    bool avx = ((info[2] >> 27) & 1) && ((info[2] >> 28) & 1) && (_xgetbv(0) & 6) == 6;
+    if(!avx)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] >> 5) & 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif !defined(SGP_DISABLE_SIMD) && (defined(__aarch64__) || defined(_M_ARM64))
+#define _SGP_SIMD_NEON
+#include <arm_neon.h>
+
+// NEON is part of the ARM64 baseline, no detection needed
+_SGP_NO_FP_CONTRACT static void _sgp_transform_vertices_neon(const sgp_mat2x3* m, _sgp_vertex* vertices, uint32_t count, _sgp_region* region) {
+    _SGP_FP_CONTRACT_OFF
+    const float32x4_t m00 = vdupq_n_f32(m->v[0][0]), m01 = vdupq_n_f32(m->v[0][1]), m02 = vdupq_n_f32(m->v[0][2]);
+    const float32x4_t m10 = vdupq_n_f32(m->v[1][0]), m11 = vdupq_n_f32(m->v[1][1]), m12 = vdupq_n_f32(m->v[1][2]);
+    float32x4_t x1 = vdupq_n_f32(region->x1), y1 = vdupq_n_f32(region->y1);
+    float32x4_t x2 = vdupq_n_f32(region->x2), y2 = vdupq_n_f32(region->y2);
+    uint32_t blocks = count / 4;
+    for(uint32_t i=0;i<blocks;++i) {
+        _sgp_vertex* v = &vertices[i*4];
+        float32x4_t a = vcombine_f32(vld1_f32(&v[0].position.x), vld1_f32(&v[1].position.x));
+        float32x4_t b = vcombine_f32(vld1_f32(&v[2].position.x), vld1_f32(&v[3].position.x));
+        float32x4x2_t xy = vuzpq_f32(a, b);
+        // separate multiplies and adds, a fused multiply-add would round differently to the scalar code
+        float32x4_t px = vaddq_f32(vaddq_f32(vmulq_f32(m00, xy.val[0]), vmulq_f32(m01, xy.val[1])), m02);
+        float32x4_t py = vaddq_f32(vaddq_f32(vmulq_f32(m10, xy.val[0]), vmulq_f32(m11, xy.val[1])), m12);
+        x1 = vminq_f32(x1, px); y1 = vminq_f32(y1, py);
+        x2 = vmaxq_f32(x2, px); y2 = vmaxq_f32(y2, py);
+        float32x4x2_t p = vzipq_f32(px, py);
+        vst1_f32(&v[0].position.x, vget_low_f32(p.val[0]));
+        vst1_f32(&v[1].position.x, vget_high_f32(p.val[0]));
+        vst1_f32(&v[2].position.x, vget_low_f32(p.val[1]));
+        vst1_f32(&v[3].position.x, vget_high_f32(p.val[1]));
+    }
+    region->x1 = _sg_min(region->x1, vminvq_f32(x1));
+    region->y1 = _sg_min(region->y1, vminvq_f32(y1));
+    region->x2 = _sg_max(region->x2, vmaxvq_f32(x2));
+    region->y2 = _sg_max(region->y2, vmaxvq_f32(y2));
+    _sgp_transform_vertices_scalar(m, &vertices[blocks*4], count - blocks*4, region);
+}
+#endif
+
+// Every kernel built for this target, best first, the first the CPU supports is used
+static const _sgp_transform_kernel _sgp_transform_kernels[] = {
+#if defined(_SGP_SIMD_X86)
+    {"avx2", _sgp_transform_vertices_avx2, _sgp_cpu_has_avx2},
+    {"sse2", _sgp_transform_vertices_sse2, _sgp_cpu_has_sse2},
+#elif defined(_SGP_SIMD_NEON)
+    {"neon", _sgp_transform_vertices_neon, NULL},
+#endif
+    {"scalar", _sgp_transform_vertices_scalar, NULL}
+};
+
+static _sgp_transform_kernel _sgp_select_transform_kernel(void) {
+    uint32_t count = sizeof(_sgp_transform_kernels) / sizeof(_sgp_transform_kernels[0]);
+    for(uint32_t i=0;i<count-1;++i) {
+        if(!_sgp_transform_kernels[i].supported || _sgp_transform_kernels[i].supported())
+            return _sgp_transform_kernels[i];
+    }
+    return _sgp_transform_kernels[count-1];
+}
+
+// Below this many vertices setting up a SIMD kernel costs more than it saves,
+// single rects and lines stay on the scalar path
+#define _SGP_TRANSFORM_SIMD_MIN 16
+
+static inline void _sgp_transform_vertices(const sgp_mat2x3* m, _sgp_vertex* vertices, uint32_t count, _sgp_region* region) {
+    if(count < _SGP_TRANSFORM_SIMD_MIN)
+        _sgp_transform_vertices_scalar(m, vertices, count, region);
+    else
+        _sgp.transform.transform(m, vertices, count, region);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Shaders
 
@@ -728,136 +1049,154 @@ static const sgp_color _sgp_white_color = {1.0f, 1.0f, 1.0f, 1.0f};
     #version 330
 
     layout(location = 0) in vec4 coord;
+    layout(location = 1) in vec4 color;
     out vec2 texUV;
+    out vec4 iColor;
 
     void main()
     {
         gl_Position = vec4(coord.xy, 0.0, 1.0);
         texUV = coord.zw;
+        iColor = color;
     }
 
 */
-static const char sgp_vs_source_glsl330[151] = {
+static const char sgp_vs_source_glsl330[224] = {
     0x23,0x76,0x65,0x72,0x73,0x69,0x6f,0x6e,0x20,0x33,0x33,0x30,0x0a,0x0a,0x6c,0x61,
     0x79,0x6f,0x75,0x74,0x28,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,
     0x30,0x29,0x20,0x69,0x6e,0x20,0x76,0x65,0x63,0x34,0x20,0x63,0x6f,0x6f,0x72,0x64,
-    0x3b,0x0a,0x6f,0x75,0x74,0x20,0x76,0x65,0x63,0x32,0x20,0x74,0x65,0x78,0x55,0x56,
-    0x3b,0x0a,0x0a,0x76,0x6f,0x69,0x64,0x20,0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,0x7b,
-    0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,
-    0x20,0x3d,0x20,0x76,0x65,0x63,0x34,0x28,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x78,0x79,
-    0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,
-    0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,0x20,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x7a,
-    0x77,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x3b,0x0a,0x6c,0x61,0x79,0x6f,0x75,0x74,0x28,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,
+    0x6e,0x20,0x3d,0x20,0x31,0x29,0x20,0x69,0x6e,0x20,0x76,0x65,0x63,0x34,0x20,0x63,
+    0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x6f,0x75,0x74,0x20,0x76,0x65,0x63,0x32,0x20,0x74,
+    0x65,0x78,0x55,0x56,0x3b,0x0a,0x6f,0x75,0x74,0x20,0x76,0x65,0x63,0x34,0x20,0x69,
+    0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x0a,0x76,0x6f,0x69,0x64,0x20,0x6d,0x61,0x69,
+    0x6e,0x28,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,
+    0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x76,0x65,0x63,0x34,0x28,0x63,0x6f,0x6f,
+    0x72,0x64,0x2e,0x78,0x79,0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,0x2e,0x30,0x29,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,0x20,0x63,0x6f,
+    0x6f,0x72,0x64,0x2e,0x7a,0x77,0x3b,0x0a,0x20,0x20,0x20,0x20,0x69,0x43,0x6f,0x6c,
+    0x6f,0x72,0x20,0x3d,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+
 };
 /*
     #version 330
 
-    uniform vec4 fs_params[1];
     uniform sampler2D iTexChannel0_iSmpChannel0;
 
     layout(location = 0) out vec4 fragColor;
     in vec2 texUV;
+    in vec4 iColor;
 
     void main()
     {
-        fragColor = texture(iTexChannel0_iSmpChannel0, texUV) * fs_params[0];
+        fragColor = texture(iTexChannel0_iSmpChannel0, texUV) * iColor;
     }
 
 */
-static const char sgp_fs_source_glsl330[236] = {
+static const char sgp_fs_source_glsl330[219] = {
     0x23,0x76,0x65,0x72,0x73,0x69,0x6f,0x6e,0x20,0x33,0x33,0x30,0x0a,0x0a,0x75,0x6e,
-    0x69,0x66,0x6f,0x72,0x6d,0x20,0x76,0x65,0x63,0x34,0x20,0x66,0x73,0x5f,0x70,0x61,
-    0x72,0x61,0x6d,0x73,0x5b,0x31,0x5d,0x3b,0x0a,0x75,0x6e,0x69,0x66,0x6f,0x72,0x6d,
-    0x20,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x32,0x44,0x20,0x69,0x54,0x65,0x78,0x43,
+    0x69,0x66,0x6f,0x72,0x6d,0x20,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x32,0x44,0x20,
+    0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x5f,0x69,0x53,0x6d,
+    0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x3b,0x0a,0x0a,0x6c,0x61,0x79,0x6f,
+    0x75,0x74,0x28,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x30,0x29,
+    0x20,0x6f,0x75,0x74,0x20,0x76,0x65,0x63,0x34,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,
+    0x6c,0x6f,0x72,0x3b,0x0a,0x69,0x6e,0x20,0x76,0x65,0x63,0x32,0x20,0x74,0x65,0x78,
+    0x55,0x56,0x3b,0x0a,0x69,0x6e,0x20,0x76,0x65,0x63,0x34,0x20,0x69,0x43,0x6f,0x6c,
+    0x6f,0x72,0x3b,0x0a,0x0a,0x76,0x6f,0x69,0x64,0x20,0x6d,0x61,0x69,0x6e,0x28,0x29,
+    0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,
+    0x20,0x3d,0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x28,0x69,0x54,0x65,0x78,0x43,
     0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x5f,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,
-    0x6e,0x65,0x6c,0x30,0x3b,0x0a,0x0a,0x6c,0x61,0x79,0x6f,0x75,0x74,0x28,0x6c,0x6f,
-    0x63,0x61,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x30,0x29,0x20,0x6f,0x75,0x74,0x20,
-    0x76,0x65,0x63,0x34,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,
-    0x69,0x6e,0x20,0x76,0x65,0x63,0x32,0x20,0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x0a,
-    0x76,0x6f,0x69,0x64,0x20,0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,0x7b,0x0a,0x20,0x20,
-    0x20,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x74,0x65,
-    0x78,0x74,0x75,0x72,0x65,0x28,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,
-    0x6c,0x30,0x5f,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2c,
-    0x20,0x74,0x65,0x78,0x55,0x56,0x29,0x20,0x2a,0x20,0x66,0x73,0x5f,0x70,0x61,0x72,
-    0x61,0x6d,0x73,0x5b,0x30,0x5d,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x6e,0x65,0x6c,0x30,0x2c,0x20,0x74,0x65,0x78,0x55,0x56,0x29,0x20,0x2a,0x20,0x69,
+    0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
 };
 /*
     #version 300 es
 
     layout(location = 0) in vec4 coord;
+    layout(location = 1) in vec4 color;
     out vec2 texUV;
+    out vec4 iColor;
 
     void main()
     {
         gl_Position = vec4(coord.xy, 0.0, 1.0);
         texUV = coord.zw;
+        iColor = color;
     }
 
 */
-static const char sgp_vs_source_glsl300es[154] = {
+static const char sgp_vs_source_glsl300es[227] = {
     0x23,0x76,0x65,0x72,0x73,0x69,0x6f,0x6e,0x20,0x33,0x30,0x30,0x20,0x65,0x73,0x0a,
     0x0a,0x6c,0x61,0x79,0x6f,0x75,0x74,0x28,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,
     0x20,0x3d,0x20,0x30,0x29,0x20,0x69,0x6e,0x20,0x76,0x65,0x63,0x34,0x20,0x63,0x6f,
-    0x6f,0x72,0x64,0x3b,0x0a,0x6f,0x75,0x74,0x20,0x76,0x65,0x63,0x32,0x20,0x74,0x65,
-    0x78,0x55,0x56,0x3b,0x0a,0x0a,0x76,0x6f,0x69,0x64,0x20,0x6d,0x61,0x69,0x6e,0x28,
-    0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,
-    0x69,0x6f,0x6e,0x20,0x3d,0x20,0x76,0x65,0x63,0x34,0x28,0x63,0x6f,0x6f,0x72,0x64,
-    0x2e,0x78,0x79,0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,
-    0x20,0x20,0x20,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,0x20,0x63,0x6f,0x6f,0x72,
-    0x64,0x2e,0x7a,0x77,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x6f,0x72,0x64,0x3b,0x0a,0x6c,0x61,0x79,0x6f,0x75,0x74,0x28,0x6c,0x6f,0x63,0x61,
+    0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x31,0x29,0x20,0x69,0x6e,0x20,0x76,0x65,0x63,
+    0x34,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x6f,0x75,0x74,0x20,0x76,0x65,0x63,
+    0x32,0x20,0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x6f,0x75,0x74,0x20,0x76,0x65,0x63,
+    0x34,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x0a,0x76,0x6f,0x69,0x64,0x20,
+    0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,0x5f,
+    0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x76,0x65,0x63,0x34,0x28,
+    0x63,0x6f,0x6f,0x72,0x64,0x2e,0x78,0x79,0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,
+    0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,
+    0x20,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x7a,0x77,0x3b,0x0a,0x20,0x20,0x20,0x20,0x69,
+    0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x7d,
+    0x0a,0x0a,0x00,
 };
 /*
     #version 300 es
     precision mediump float;
     precision highp int;
 
-    uniform highp vec4 fs_params[1];
     uniform highp sampler2D iTexChannel0_iSmpChannel0;
 
     layout(location = 0) out highp vec4 fragColor;
     in highp vec2 texUV;
+    in highp vec4 iColor;
 
     void main()
     {
-        fragColor = texture(iTexChannel0_iSmpChannel0, texUV) * fs_params[0];
+        fragColor = texture(iTexChannel0_iSmpChannel0, texUV) * iColor;
     }
 
 */
-static const char sgp_fs_source_glsl300es[309] = {
+static const char sgp_fs_source_glsl300es[292] = {
     0x23,0x76,0x65,0x72,0x73,0x69,0x6f,0x6e,0x20,0x33,0x30,0x30,0x20,0x65,0x73,0x0a,
     0x70,0x72,0x65,0x63,0x69,0x73,0x69,0x6f,0x6e,0x20,0x6d,0x65,0x64,0x69,0x75,0x6d,
     0x70,0x20,0x66,0x6c,0x6f,0x61,0x74,0x3b,0x0a,0x70,0x72,0x65,0x63,0x69,0x73,0x69,
     0x6f,0x6e,0x20,0x68,0x69,0x67,0x68,0x70,0x20,0x69,0x6e,0x74,0x3b,0x0a,0x0a,0x75,
-    0x6e,0x69,0x66,0x6f,0x72,0x6d,0x20,0x68,0x69,0x67,0x68,0x70,0x20,0x76,0x65,0x63,
-    0x34,0x20,0x66,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x5b,0x31,0x5d,0x3b,0x0a,
-    0x75,0x6e,0x69,0x66,0x6f,0x72,0x6d,0x20,0x68,0x69,0x67,0x68,0x70,0x20,0x73,0x61,
-    0x6d,0x70,0x6c,0x65,0x72,0x32,0x44,0x20,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,
-    0x6e,0x65,0x6c,0x30,0x5f,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,
-    0x30,0x3b,0x0a,0x0a,0x6c,0x61,0x79,0x6f,0x75,0x74,0x28,0x6c,0x6f,0x63,0x61,0x74,
-    0x69,0x6f,0x6e,0x20,0x3d,0x20,0x30,0x29,0x20,0x6f,0x75,0x74,0x20,0x68,0x69,0x67,
-    0x68,0x70,0x20,0x76,0x65,0x63,0x34,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,
-    0x72,0x3b,0x0a,0x69,0x6e,0x20,0x68,0x69,0x67,0x68,0x70,0x20,0x76,0x65,0x63,0x32,
-    0x20,0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x0a,0x76,0x6f,0x69,0x64,0x20,0x6d,0x61,
-    0x69,0x6e,0x28,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x72,0x61,0x67,0x43,
-    0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x28,0x69,
-    0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x5f,0x69,0x53,0x6d,0x70,
-    0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2c,0x20,0x74,0x65,0x78,0x55,0x56,0x29,
-    0x20,0x2a,0x20,0x66,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x5b,0x30,0x5d,0x3b,
-    0x0a,0x7d,0x0a,0x0a,0x00,
+    0x6e,0x69,0x66,0x6f,0x72,0x6d,0x20,0x68,0x69,0x67,0x68,0x70,0x20,0x73,0x61,0x6d,
+    0x70,0x6c,0x65,0x72,0x32,0x44,0x20,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,
+    0x65,0x6c,0x30,0x5f,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,
+    0x3b,0x0a,0x0a,0x6c,0x61,0x79,0x6f,0x75,0x74,0x28,0x6c,0x6f,0x63,0x61,0x74,0x69,
+    0x6f,0x6e,0x20,0x3d,0x20,0x30,0x29,0x20,0x6f,0x75,0x74,0x20,0x68,0x69,0x67,0x68,
+    0x70,0x20,0x76,0x65,0x63,0x34,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,
+    0x3b,0x0a,0x69,0x6e,0x20,0x68,0x69,0x67,0x68,0x70,0x20,0x76,0x65,0x63,0x32,0x20,
+    0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x69,0x6e,0x20,0x68,0x69,0x67,0x68,0x70,0x20,
+    0x76,0x65,0x63,0x34,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x0a,0x76,0x6f,
+    0x69,0x64,0x20,0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,
+    0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x74,0x65,0x78,0x74,
+    0x75,0x72,0x65,0x28,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,
+    0x5f,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2c,0x20,0x74,
+    0x65,0x78,0x55,0x56,0x29,0x20,0x2a,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,
+    0x7d,0x0a,0x0a,0x00,
 };
 /*
     static float4 gl_Position;
     static float4 coord;
     static float2 texUV;
+    static float4 iColor;
+    static float4 color;
 
     struct SPIRV_Cross_Input
     {
         float4 coord : TEXCOORD0;
+        float4 color : TEXCOORD1;
     };
 
     struct SPIRV_Cross_Output
     {
         float2 texUV : TEXCOORD0;
+        float4 iColor : TEXCOORD1;
         float4 gl_Position : SV_Position;
     };
 
@@ -865,71 +1204,83 @@ static const char sgp_fs_source_glsl300es[309] = {
     {
         gl_Position = float4(coord.xy, 0.0f, 1.0f);
         texUV = coord.zw;
+        iColor = color;
     }
 
     SPIRV_Cross_Output main(SPIRV_Cross_Input stage_input)
     {
         coord = stage_input.coord;
+        color = stage_input.color;
         vert_main();
         SPIRV_Cross_Output stage_output;
         stage_output.gl_Position = gl_Position;
         stage_output.texUV = texUV;
+        stage_output.iColor = iColor;
         return stage_output;
     }
 */
-static const char sgp_vs_source_hlsl4[569] = {
+static const char sgp_vs_source_hlsl4[758] = {
     0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x67,0x6c,
     0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,
     0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6f,0x72,0x64,0x3b,0x0a,
     0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,0x65,
-    0x78,0x55,0x56,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x53,0x50,0x49,
-    0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x49,0x6e,0x70,0x75,0x74,0x0a,0x7b,
-    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6f,0x72,
-    0x64,0x20,0x3a,0x20,0x54,0x45,0x58,0x43,0x4f,0x4f,0x52,0x44,0x30,0x3b,0x0a,0x7d,
-    0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x53,0x50,0x49,0x52,0x56,0x5f,
-    0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,0x75,0x74,0x70,0x75,0x74,0x0a,0x7b,0x0a,0x20,
-    0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,0x65,0x78,0x55,0x56,0x20,
-    0x3a,0x20,0x54,0x45,0x58,0x43,0x4f,0x4f,0x52,0x44,0x30,0x3b,0x0a,0x20,0x20,0x20,
-    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,
-    0x69,0x6f,0x6e,0x20,0x3a,0x20,0x53,0x56,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,
-    0x6e,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x76,0x6f,0x69,0x64,0x20,0x76,0x65,0x72,0x74,
-    0x5f,0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,
-    0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,
-    0x74,0x34,0x28,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x78,0x79,0x2c,0x20,0x30,0x2e,0x30,
-    0x66,0x2c,0x20,0x31,0x2e,0x30,0x66,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x74,0x65,
-    0x78,0x55,0x56,0x20,0x3d,0x20,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x7a,0x77,0x3b,0x0a,
-    0x7d,0x0a,0x0a,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,
-    0x75,0x74,0x70,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x28,0x53,0x50,0x49,0x52,0x56,
-    0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x49,0x6e,0x70,0x75,0x74,0x20,0x73,0x74,0x61,
-    0x67,0x65,0x5f,0x69,0x6e,0x70,0x75,0x74,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,
-    0x63,0x6f,0x6f,0x72,0x64,0x20,0x3d,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,
-    0x70,0x75,0x74,0x2e,0x63,0x6f,0x6f,0x72,0x64,0x3b,0x0a,0x20,0x20,0x20,0x20,0x76,
-    0x65,0x72,0x74,0x5f,0x6d,0x61,0x69,0x6e,0x28,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,
-    0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,0x75,0x74,0x70,
-    0x75,0x74,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,0x74,0x3b,
-    0x0a,0x20,0x20,0x20,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,
-    0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,
-    0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x20,0x20,0x20,
-    0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,0x74,0x2e,0x74,0x65,
-    0x78,0x55,0x56,0x20,0x3d,0x20,0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x20,0x20,0x20,
-    0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,
-    0x74,0x70,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x00,
+    0x78,0x55,0x56,0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,
+    0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,
+    0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,
+    0x6f,0x73,0x73,0x5f,0x49,0x6e,0x70,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,
+    0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6f,0x72,0x64,0x20,0x3a,0x20,0x54,
+    0x45,0x58,0x43,0x4f,0x4f,0x52,0x44,0x30,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x54,0x45,0x58,
+    0x43,0x4f,0x4f,0x52,0x44,0x31,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,
+    0x63,0x74,0x20,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,
+    0x75,0x74,0x70,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x32,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3a,0x20,0x54,0x45,0x58,0x43,0x4f,
+    0x4f,0x52,0x44,0x30,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x54,0x45,0x58,0x43,0x4f,0x4f,
+    0x52,0x44,0x31,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,
+    0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3a,0x20,0x53,0x56,
+    0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x76,
+    0x6f,0x69,0x64,0x20,0x76,0x65,0x72,0x74,0x5f,0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,
+    0x7b,0x0a,0x20,0x20,0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,
+    0x6e,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x63,0x6f,0x6f,0x72,0x64,
+    0x2e,0x78,0x79,0x2c,0x20,0x30,0x2e,0x30,0x66,0x2c,0x20,0x31,0x2e,0x30,0x66,0x29,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,0x20,0x63,0x6f,
+    0x6f,0x72,0x64,0x2e,0x7a,0x77,0x3b,0x0a,0x20,0x20,0x20,0x20,0x69,0x43,0x6f,0x6c,
+    0x6f,0x72,0x20,0x3d,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x7d,0x0a,0x0a,0x53,
+    0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,0x75,0x74,0x70,0x75,
+    0x74,0x20,0x6d,0x61,0x69,0x6e,0x28,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,
+    0x73,0x73,0x5f,0x49,0x6e,0x70,0x75,0x74,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,
+    0x6e,0x70,0x75,0x74,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x63,0x6f,0x6f,0x72,
+    0x64,0x20,0x3d,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x70,0x75,0x74,0x2e,
+    0x63,0x6f,0x6f,0x72,0x64,0x3b,0x0a,0x20,0x20,0x20,0x20,0x63,0x6f,0x6c,0x6f,0x72,
+    0x20,0x3d,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x70,0x75,0x74,0x2e,0x63,
+    0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,0x20,0x76,0x65,0x72,0x74,0x5f,0x6d,
+    0x61,0x69,0x6e,0x28,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x53,0x50,0x49,0x52,0x56,
+    0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,0x75,0x74,0x70,0x75,0x74,0x20,0x73,0x74,
+    0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,0x74,0x3b,0x0a,0x20,0x20,0x20,0x20,
+    0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,0x74,0x2e,0x67,0x6c,0x5f,
+    0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x67,0x6c,0x5f,0x50,0x6f,
+    0x73,0x69,0x74,0x69,0x6f,0x6e,0x3b,0x0a,0x20,0x20,0x20,0x20,0x73,0x74,0x61,0x67,
+    0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,0x74,0x2e,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,
+    0x20,0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x20,0x20,0x20,0x20,0x73,0x74,0x61,0x67,
+    0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,0x74,0x2e,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,
+    0x3d,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,
+    0x74,0x75,0x72,0x6e,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,
+    0x74,0x3b,0x0a,0x7d,0x0a,0x00,
 };
 /*
-    cbuffer fs_params : register(b0)
-    {
-        float4 _27_iColor : packoffset(c0);
-    };
-
     Texture2D<float4> iTexChannel0 : register(t0);
     SamplerState iSmpChannel0 : register(s0);
 
     static float4 fragColor;
     static float2 texUV;
+    static float4 iColor;
 
     struct SPIRV_Cross_Input
     {
         float2 texUV : TEXCOORD0;
+        float4 iColor : TEXCOORD1;
     };
 
     struct SPIRV_Cross_Output
@@ -939,60 +1290,61 @@ static const char sgp_vs_source_hlsl4[569] = {
 
     void frag_main()
     {
-        fragColor = iTexChannel0.Sample(iSmpChannel0, texUV) * _27_iColor;
+        fragColor = iTexChannel0.Sample(iSmpChannel0, texUV) * iColor;
     }
 
     SPIRV_Cross_Output main(SPIRV_Cross_Input stage_input)
     {
         texUV = stage_input.texUV;
+        iColor = stage_input.iColor;
         frag_main();
         SPIRV_Cross_Output stage_output;
         stage_output.fragColor = fragColor;
         return stage_output;
     }
 */
-static const char sgp_fs_source_hlsl4[647] = {
-    0x63,0x62,0x75,0x66,0x66,0x65,0x72,0x20,0x66,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,
-    0x73,0x20,0x3a,0x20,0x72,0x65,0x67,0x69,0x73,0x74,0x65,0x72,0x28,0x62,0x30,0x29,
-    0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x5f,0x32,
-    0x37,0x5f,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x70,0x61,0x63,0x6b,0x6f,
-    0x66,0x66,0x73,0x65,0x74,0x28,0x63,0x30,0x29,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x54,
-    0x65,0x78,0x74,0x75,0x72,0x65,0x32,0x44,0x3c,0x66,0x6c,0x6f,0x61,0x74,0x34,0x3e,
-    0x20,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x3a,0x20,
-    0x72,0x65,0x67,0x69,0x73,0x74,0x65,0x72,0x28,0x74,0x30,0x29,0x3b,0x0a,0x53,0x61,
-    0x6d,0x70,0x6c,0x65,0x72,0x53,0x74,0x61,0x74,0x65,0x20,0x69,0x53,0x6d,0x70,0x43,
-    0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x3a,0x20,0x72,0x65,0x67,0x69,0x73,0x74,
-    0x65,0x72,0x28,0x73,0x30,0x29,0x3b,0x0a,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,
-    0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,
-    0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,
-    0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x53,
+static const char sgp_fs_source_hlsl4[650] = {
+    0x54,0x65,0x78,0x74,0x75,0x72,0x65,0x32,0x44,0x3c,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x3e,0x20,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x3a,
+    0x20,0x72,0x65,0x67,0x69,0x73,0x74,0x65,0x72,0x28,0x74,0x30,0x29,0x3b,0x0a,0x53,
+    0x61,0x6d,0x70,0x6c,0x65,0x72,0x53,0x74,0x61,0x74,0x65,0x20,0x69,0x53,0x6d,0x70,
+    0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x3a,0x20,0x72,0x65,0x67,0x69,0x73,
+    0x74,0x65,0x72,0x28,0x73,0x30,0x29,0x3b,0x0a,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,
+    0x72,0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,
+    0x20,0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x73,0x74,0x61,0x74,0x69,0x63,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x0a,0x73,
+    0x74,0x72,0x75,0x63,0x74,0x20,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,
+    0x73,0x5f,0x49,0x6e,0x70,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,
+    0x6f,0x61,0x74,0x32,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3a,0x20,0x54,0x45,0x58,
+    0x43,0x4f,0x4f,0x52,0x44,0x30,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
+    0x74,0x34,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x54,0x45,0x58,0x43,
+    0x4f,0x4f,0x52,0x44,0x31,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,
+    0x74,0x20,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,0x75,
+    0x74,0x70,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,
+    0x34,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x53,0x56,
+    0x5f,0x54,0x61,0x72,0x67,0x65,0x74,0x30,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x76,0x6f,
+    0x69,0x64,0x20,0x66,0x72,0x61,0x67,0x5f,0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,0x7b,
+    0x0a,0x20,0x20,0x20,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,
+    0x20,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2e,0x53,0x61,
+    0x6d,0x70,0x6c,0x65,0x28,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,
+    0x30,0x2c,0x20,0x74,0x65,0x78,0x55,0x56,0x29,0x20,0x2a,0x20,0x69,0x43,0x6f,0x6c,
+    0x6f,0x72,0x3b,0x0a,0x7d,0x0a,0x0a,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,
+    0x73,0x73,0x5f,0x4f,0x75,0x74,0x70,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x28,0x53,
     0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x49,0x6e,0x70,0x75,0x74,
-    0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,0x65,
-    0x78,0x55,0x56,0x20,0x3a,0x20,0x54,0x45,0x58,0x43,0x4f,0x4f,0x52,0x44,0x30,0x3b,
-    0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x53,0x50,0x49,0x52,
-    0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,0x75,0x74,0x70,0x75,0x74,0x0a,0x7b,
-    0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x66,0x72,0x61,0x67,
-    0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x53,0x56,0x5f,0x54,0x61,0x72,0x67,0x65,
-    0x74,0x30,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x76,0x6f,0x69,0x64,0x20,0x66,0x72,0x61,
-    0x67,0x5f,0x6d,0x61,0x69,0x6e,0x28,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
-    0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x69,0x54,0x65,0x78,0x43,
-    0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2e,0x53,0x61,0x6d,0x70,0x6c,0x65,0x28,0x69,
-    0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2c,0x20,0x74,0x65,0x78,
-    0x55,0x56,0x29,0x20,0x2a,0x20,0x5f,0x32,0x37,0x5f,0x69,0x43,0x6f,0x6c,0x6f,0x72,
-    0x3b,0x0a,0x7d,0x0a,0x0a,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,
-    0x5f,0x4f,0x75,0x74,0x70,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x28,0x53,0x50,0x49,
-    0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x49,0x6e,0x70,0x75,0x74,0x20,0x73,
-    0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x70,0x75,0x74,0x29,0x0a,0x7b,0x0a,0x20,0x20,
-    0x20,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,
-    0x69,0x6e,0x70,0x75,0x74,0x2e,0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x20,0x20,0x20,
-    0x20,0x66,0x72,0x61,0x67,0x5f,0x6d,0x61,0x69,0x6e,0x28,0x29,0x3b,0x0a,0x20,0x20,
-    0x20,0x20,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,0x5f,0x4f,0x75,
-    0x74,0x70,0x75,0x74,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,0x75,
-    0x74,0x3b,0x0a,0x20,0x20,0x20,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,
-    0x70,0x75,0x74,0x2e,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,
-    0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,
-    0x65,0x74,0x75,0x72,0x6e,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,0x74,0x70,
-    0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x00,
+    0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x70,0x75,0x74,0x29,0x0a,0x7b,0x0a,
+    0x20,0x20,0x20,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,0x20,0x73,0x74,0x61,0x67,
+    0x65,0x5f,0x69,0x6e,0x70,0x75,0x74,0x2e,0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x20,
+    0x20,0x20,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x73,0x74,0x61,0x67,
+    0x65,0x5f,0x69,0x6e,0x70,0x75,0x74,0x2e,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,
+    0x20,0x20,0x20,0x20,0x66,0x72,0x61,0x67,0x5f,0x6d,0x61,0x69,0x6e,0x28,0x29,0x3b,
+    0x0a,0x20,0x20,0x20,0x20,0x53,0x50,0x49,0x52,0x56,0x5f,0x43,0x72,0x6f,0x73,0x73,
+    0x5f,0x4f,0x75,0x74,0x70,0x75,0x74,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,0x75,
+    0x74,0x70,0x75,0x74,0x3b,0x0a,0x20,0x20,0x20,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,
+    0x6f,0x75,0x74,0x70,0x75,0x74,0x2e,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,
+    0x20,0x3d,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,
+    0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x73,0x74,0x61,0x67,0x65,0x5f,0x6f,
+    0x75,0x74,0x70,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x00,
 };
 /*
     #include <metal_stdlib>
@@ -1003,12 +1355,14 @@ static const char sgp_fs_source_hlsl4[647] = {
     struct main0_out
     {
         float2 texUV [[user(locn0)]];
+        float4 iColor [[user(locn1)]];
         float4 gl_Position [[position]];
     };
 
     struct main0_in
     {
         float4 coord [[attribute(0)]];
+        float4 color [[attribute(1)]];
     };
 
     vertex main0_out main0(main0_in in [[stage_in]])
@@ -1016,11 +1370,12 @@ static const char sgp_fs_source_hlsl4[647] = {
         main0_out out = {};
         out.gl_Position = float4(in.coord.xy, 0.0, 1.0);
         out.texUV = in.coord.zw;
+        out.iColor = in.color;
         return out;
     }
 
 */
-static const char sgp_vs_source_metal_macos[400] = {
+static const char sgp_vs_source_metal_macos[497] = {
     0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,0x20,0x3c,0x6d,0x65,0x74,0x61,0x6c,0x5f,
     0x73,0x74,0x64,0x6c,0x69,0x62,0x3e,0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,
     0x20,0x3c,0x73,0x69,0x6d,0x64,0x2f,0x73,0x69,0x6d,0x64,0x2e,0x68,0x3e,0x0a,0x0a,
@@ -1029,24 +1384,30 @@ static const char sgp_vs_source_metal_macos[400] = {
     0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
     0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x5b,0x5b,0x75,0x73,
     0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,
-    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,
-    0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x5d,0x5d,
-    0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,
-    0x6e,0x30,0x5f,0x69,0x6e,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
-    0x74,0x34,0x20,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,
-    0x62,0x75,0x74,0x65,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x76,
-    0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,
-    0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,
-    0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x5d,0x5d,0x29,0x0a,
-    0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,
-    0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,
-    0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,
-    0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x69,0x6e,0x2e,0x63,0x6f,0x6f,0x72,0x64,0x2e,
-    0x78,0x79,0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,
-    0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,0x20,0x69,
-    0x6e,0x2e,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x7a,0x77,0x3b,0x0a,0x20,0x20,0x20,0x20,
-    0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
-
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x5b,
+    0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x31,0x29,0x5d,0x5d,0x3b,0x0a,
+    0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,
+    0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,
+    0x6e,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,
+    0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x61,0x74,
+    0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,
+    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x5b,
+    0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x31,0x29,0x5d,0x5d,0x3b,
+    0x0a,0x7d,0x3b,0x0a,0x0a,0x76,0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,0x69,0x6e,
+    0x30,0x5f,0x6f,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,
+    0x30,0x5f,0x69,0x6e,0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,
+    0x69,0x6e,0x5d,0x5d,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,
+    0x30,0x5f,0x6f,0x75,0x74,0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,
+    0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,
+    0x69,0x6f,0x6e,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x69,0x6e,0x2e,
+    0x63,0x6f,0x6f,0x72,0x64,0x2e,0x78,0x79,0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,
+    0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x74,0x65,0x78,
+    0x55,0x56,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x7a,0x77,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x69,0x43,0x6f,0x6c,0x6f,0x72,
+    0x20,0x3d,0x20,0x69,0x6e,0x2e,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,
+    0x00,
 };
 /*
     #include <metal_stdlib>
@@ -1054,11 +1415,6 @@ static const char sgp_vs_source_metal_macos[400] = {
 
     using namespace metal;
 
-    struct fs_params
-    {
-        float4 iColor;
-    };
-
     struct main0_out
     {
         float4 fragColor [[color(0)]];
@@ -1067,50 +1423,48 @@ static const char sgp_vs_source_metal_macos[400] = {
     struct main0_in
     {
         float2 texUV [[user(locn0)]];
+        float4 iColor [[user(locn1)]];
     };
 
-    fragment main0_out main0(main0_in in [[stage_in]], constant fs_params& _27 [[buffer(0)]], texture2d<float> iTexChannel0 [[texture(0)]], sampler iSmpChannel0 [[sampler(0)]])
+    fragment main0_out main0(main0_in in [[stage_in]], texture2d<float> iTexChannel0 [[texture(0)]], sampler iSmpChannel0 [[sampler(0)]])
     {
         main0_out out = {};
-        out.fragColor = iTexChannel0.sample(iSmpChannel0, in.texUV) * _27.iColor;
+        out.fragColor = iTexChannel0.sample(iSmpChannel0, in.texUV) * in.iColor;
         return out;
     }
 
 */
-static const char sgp_fs_source_metal_macos[525] = {
+static const char sgp_fs_source_metal_macos[478] = {
     0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,0x20,0x3c,0x6d,0x65,0x74,0x61,0x6c,0x5f,
     0x73,0x74,0x64,0x6c,0x69,0x62,0x3e,0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,
     0x20,0x3c,0x73,0x69,0x6d,0x64,0x2f,0x73,0x69,0x6d,0x64,0x2e,0x68,0x3e,0x0a,0x0a,
     0x75,0x73,0x69,0x6e,0x67,0x20,0x6e,0x61,0x6d,0x65,0x73,0x70,0x61,0x63,0x65,0x20,
-    0x6d,0x65,0x74,0x61,0x6c,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x66,
-    0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
-    0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x7d,0x3b,
-    0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,
-    0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,
-    0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x5b,0x5b,0x63,0x6f,0x6c,0x6f,
-    0x72,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,
-    0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x0a,0x7b,0x0a,0x20,0x20,
-    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x5b,
-    0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,
-    0x7d,0x3b,0x0a,0x0a,0x66,0x72,0x61,0x67,0x6d,0x65,0x6e,0x74,0x20,0x6d,0x61,0x69,
-    0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,
-    0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,
-    0x5f,0x69,0x6e,0x5d,0x5d,0x2c,0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,0x20,
-    0x66,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x26,0x20,0x5f,0x32,0x37,0x20,0x5b,
-    0x5b,0x62,0x75,0x66,0x66,0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,0x2c,0x20,0x74,0x65,
-    0x78,0x74,0x75,0x72,0x65,0x32,0x64,0x3c,0x66,0x6c,0x6f,0x61,0x74,0x3e,0x20,0x69,
-    0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x5b,0x5b,0x74,0x65,
-    0x78,0x74,0x75,0x72,0x65,0x28,0x30,0x29,0x5d,0x5d,0x2c,0x20,0x73,0x61,0x6d,0x70,
-    0x6c,0x65,0x72,0x20,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,
-    0x20,0x5b,0x5b,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,0x29,
-    0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,
-    0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,
-    0x75,0x74,0x2e,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x69,
-    0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2e,0x73,0x61,0x6d,0x70,
-    0x6c,0x65,0x28,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2c,
-    0x20,0x69,0x6e,0x2e,0x74,0x65,0x78,0x55,0x56,0x29,0x20,0x2a,0x20,0x5f,0x32,0x37,
-    0x2e,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,
-    0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x6d,0x65,0x74,0x61,0x6c,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,
+    0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,
+    0x5b,0x5b,0x63,0x6f,0x6c,0x6f,0x72,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,
+    0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,
+    0x6e,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,
+    0x65,0x78,0x55,0x56,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,
+    0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,
+    0x6f,0x63,0x6e,0x31,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x66,0x72,0x61,
+    0x67,0x6d,0x65,0x6e,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,
+    0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,
+    0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x5d,0x5d,0x2c,0x20,
+    0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x32,0x64,0x3c,0x66,0x6c,0x6f,0x61,0x74,0x3e,
+    0x20,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x5b,0x5b,
+    0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x28,0x30,0x29,0x5d,0x5d,0x2c,0x20,0x73,0x61,
+    0x6d,0x70,0x6c,0x65,0x72,0x20,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,
+    0x6c,0x30,0x20,0x5b,0x5b,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x28,0x30,0x29,0x5d,
+    0x5d,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,
+    0x75,0x74,0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x6f,0x75,0x74,0x2e,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,
+    0x20,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2e,0x73,0x61,
+    0x6d,0x70,0x6c,0x65,0x28,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,
+    0x30,0x2c,0x20,0x69,0x6e,0x2e,0x74,0x65,0x78,0x55,0x56,0x29,0x20,0x2a,0x20,0x69,
+    0x6e,0x2e,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,
+    0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
 };
 /*
     #include <metal_stdlib>
@@ -1121,12 +1475,14 @@ static const char sgp_fs_source_metal_macos[525] = {
     struct main0_out
     {
         float2 texUV [[user(locn0)]];
+        float4 iColor [[user(locn1)]];
         float4 gl_Position [[position]];
     };
 
     struct main0_in
     {
         float4 coord [[attribute(0)]];
+        float4 color [[attribute(1)]];
     };
 
     vertex main0_out main0(main0_in in [[stage_in]])
@@ -1134,11 +1490,12 @@ static const char sgp_fs_source_metal_macos[525] = {
         main0_out out = {};
         out.gl_Position = float4(in.coord.xy, 0.0, 1.0);
         out.texUV = in.coord.zw;
+        out.iColor = in.color;
         return out;
     }
 
 */
-static const char sgp_vs_source_metal_ios[400] = {
+static const char sgp_vs_source_metal_ios[497] = {
     0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,0x20,0x3c,0x6d,0x65,0x74,0x61,0x6c,0x5f,
     0x73,0x74,0x64,0x6c,0x69,0x62,0x3e,0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,
     0x20,0x3c,0x73,0x69,0x6d,0x64,0x2f,0x73,0x69,0x6d,0x64,0x2e,0x68,0x3e,0x0a,0x0a,
@@ -1147,24 +1504,30 @@ static const char sgp_vs_source_metal_ios[400] = {
     0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
     0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x5b,0x5b,0x75,0x73,
     0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,
-    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,
-    0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x5d,0x5d,
-    0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,
-    0x6e,0x30,0x5f,0x69,0x6e,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,
-    0x74,0x34,0x20,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x61,0x74,0x74,0x72,0x69,
-    0x62,0x75,0x74,0x65,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x76,
-    0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,
-    0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,
-    0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x5d,0x5d,0x29,0x0a,
-    0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,
-    0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,
-    0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,
-    0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x69,0x6e,0x2e,0x63,0x6f,0x6f,0x72,0x64,0x2e,
-    0x78,0x79,0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,0x2e,0x30,0x29,0x3b,0x0a,0x20,
-    0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,0x20,0x69,
-    0x6e,0x2e,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x7a,0x77,0x3b,0x0a,0x20,0x20,0x20,0x20,
-    0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
-
+    0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x5b,
+    0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x31,0x29,0x5d,0x5d,0x3b,0x0a,
+    0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x67,0x6c,0x5f,0x50,0x6f,
+    0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x5b,0x5b,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,
+    0x6e,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,
+    0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6f,0x72,0x64,0x20,0x5b,0x5b,0x61,0x74,
+    0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,
+    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x5b,
+    0x5b,0x61,0x74,0x74,0x72,0x69,0x62,0x75,0x74,0x65,0x28,0x31,0x29,0x5d,0x5d,0x3b,
+    0x0a,0x7d,0x3b,0x0a,0x0a,0x76,0x65,0x72,0x74,0x65,0x78,0x20,0x6d,0x61,0x69,0x6e,
+    0x30,0x5f,0x6f,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,
+    0x30,0x5f,0x69,0x6e,0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,
+    0x69,0x6e,0x5d,0x5d,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,
+    0x30,0x5f,0x6f,0x75,0x74,0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,
+    0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,
+    0x69,0x6f,0x6e,0x20,0x3d,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x28,0x69,0x6e,0x2e,
+    0x63,0x6f,0x6f,0x72,0x64,0x2e,0x78,0x79,0x2c,0x20,0x30,0x2e,0x30,0x2c,0x20,0x31,
+    0x2e,0x30,0x29,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x74,0x65,0x78,
+    0x55,0x56,0x20,0x3d,0x20,0x69,0x6e,0x2e,0x63,0x6f,0x6f,0x72,0x64,0x2e,0x7a,0x77,
+    0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,0x75,0x74,0x2e,0x69,0x43,0x6f,0x6c,0x6f,0x72,
+    0x20,0x3d,0x20,0x69,0x6e,0x2e,0x63,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,
+    0x00,
 };
 /*
     #include <metal_stdlib>
@@ -1172,11 +1535,6 @@ static const char sgp_vs_source_metal_ios[400] = {
 
     using namespace metal;
 
-    struct fs_params
-    {
-        float4 iColor;
-    };
-
     struct main0_out
     {
         float4 fragColor [[color(0)]];
@@ -1185,50 +1543,48 @@ static const char sgp_vs_source_metal_ios[400] = {
     struct main0_in
     {
         float2 texUV [[user(locn0)]];
+        float4 iColor [[user(locn1)]];
     };
 
-    fragment main0_out main0(main0_in in [[stage_in]], constant fs_params& _27 [[buffer(0)]], texture2d<float> iTexChannel0 [[texture(0)]], sampler iSmpChannel0 [[sampler(0)]])
+    fragment main0_out main0(main0_in in [[stage_in]], texture2d<float> iTexChannel0 [[texture(0)]], sampler iSmpChannel0 [[sampler(0)]])
     {
         main0_out out = {};
-        out.fragColor = iTexChannel0.sample(iSmpChannel0, in.texUV) * _27.iColor;
+        out.fragColor = iTexChannel0.sample(iSmpChannel0, in.texUV) * in.iColor;
         return out;
     }
 
 */
-static const char sgp_fs_source_metal_ios[525] = {
+static const char sgp_fs_source_metal_ios[478] = {
     0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,0x20,0x3c,0x6d,0x65,0x74,0x61,0x6c,0x5f,
     0x73,0x74,0x64,0x6c,0x69,0x62,0x3e,0x0a,0x23,0x69,0x6e,0x63,0x6c,0x75,0x64,0x65,
     0x20,0x3c,0x73,0x69,0x6d,0x64,0x2f,0x73,0x69,0x6d,0x64,0x2e,0x68,0x3e,0x0a,0x0a,
     0x75,0x73,0x69,0x6e,0x67,0x20,0x6e,0x61,0x6d,0x65,0x73,0x70,0x61,0x63,0x65,0x20,
-    0x6d,0x65,0x74,0x61,0x6c,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x66,
-    0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
-    0x6c,0x6f,0x61,0x74,0x34,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x7d,0x3b,
-    0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,
-    0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,0x20,
-    0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x5b,0x5b,0x63,0x6f,0x6c,0x6f,
-    0x72,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,
-    0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x0a,0x7b,0x0a,0x20,0x20,
-    0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x5b,
-    0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,0x30,0x29,0x5d,0x5d,0x3b,0x0a,
-    0x7d,0x3b,0x0a,0x0a,0x66,0x72,0x61,0x67,0x6d,0x65,0x6e,0x74,0x20,0x6d,0x61,0x69,
-    0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,
-    0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,
-    0x5f,0x69,0x6e,0x5d,0x5d,0x2c,0x20,0x63,0x6f,0x6e,0x73,0x74,0x61,0x6e,0x74,0x20,
-    0x66,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x26,0x20,0x5f,0x32,0x37,0x20,0x5b,
-    0x5b,0x62,0x75,0x66,0x66,0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,0x2c,0x20,0x74,0x65,
-    0x78,0x74,0x75,0x72,0x65,0x32,0x64,0x3c,0x66,0x6c,0x6f,0x61,0x74,0x3e,0x20,0x69,
-    0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x5b,0x5b,0x74,0x65,
-    0x78,0x74,0x75,0x72,0x65,0x28,0x30,0x29,0x5d,0x5d,0x2c,0x20,0x73,0x61,0x6d,0x70,
-    0x6c,0x65,0x72,0x20,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,
-    0x20,0x5b,0x5b,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x28,0x30,0x29,0x5d,0x5d,0x29,
-    0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,
-    0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x6f,
-    0x75,0x74,0x2e,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x69,
-    0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2e,0x73,0x61,0x6d,0x70,
-    0x6c,0x65,0x28,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2c,
-    0x20,0x69,0x6e,0x2e,0x74,0x65,0x78,0x55,0x56,0x29,0x20,0x2a,0x20,0x5f,0x32,0x37,
-    0x2e,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,0x74,
-    0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x6d,0x65,0x74,0x61,0x6c,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,
+    0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,
+    0x6c,0x6f,0x61,0x74,0x34,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,
+    0x5b,0x5b,0x63,0x6f,0x6c,0x6f,0x72,0x28,0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,
+    0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,
+    0x6e,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x32,0x20,0x74,
+    0x65,0x78,0x55,0x56,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,0x6f,0x63,0x6e,
+    0x30,0x29,0x5d,0x5d,0x3b,0x0a,0x20,0x20,0x20,0x20,0x66,0x6c,0x6f,0x61,0x74,0x34,
+    0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x5b,0x5b,0x75,0x73,0x65,0x72,0x28,0x6c,
+    0x6f,0x63,0x6e,0x31,0x29,0x5d,0x5d,0x3b,0x0a,0x7d,0x3b,0x0a,0x0a,0x66,0x72,0x61,
+    0x67,0x6d,0x65,0x6e,0x74,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,0x75,0x74,0x20,
+    0x6d,0x61,0x69,0x6e,0x30,0x28,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x69,0x6e,0x20,0x69,
+    0x6e,0x20,0x5b,0x5b,0x73,0x74,0x61,0x67,0x65,0x5f,0x69,0x6e,0x5d,0x5d,0x2c,0x20,
+    0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x32,0x64,0x3c,0x66,0x6c,0x6f,0x61,0x74,0x3e,
+    0x20,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x5b,0x5b,
+    0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x28,0x30,0x29,0x5d,0x5d,0x2c,0x20,0x73,0x61,
+    0x6d,0x70,0x6c,0x65,0x72,0x20,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,
+    0x6c,0x30,0x20,0x5b,0x5b,0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x28,0x30,0x29,0x5d,
+    0x5d,0x29,0x0a,0x7b,0x0a,0x20,0x20,0x20,0x20,0x6d,0x61,0x69,0x6e,0x30,0x5f,0x6f,
+    0x75,0x74,0x20,0x6f,0x75,0x74,0x20,0x3d,0x20,0x7b,0x7d,0x3b,0x0a,0x20,0x20,0x20,
+    0x20,0x6f,0x75,0x74,0x2e,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,
+    0x20,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2e,0x73,0x61,
+    0x6d,0x70,0x6c,0x65,0x28,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,
+    0x30,0x2c,0x20,0x69,0x6e,0x2e,0x74,0x65,0x78,0x55,0x56,0x29,0x20,0x2a,0x20,0x69,
+    0x6e,0x2e,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x20,0x20,0x72,0x65,
+    0x74,0x75,0x72,0x6e,0x20,0x6f,0x75,0x74,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
 };
 /*
     diagnostic(off, derivative_uniformity);
@@ -1237,6 +1593,10 @@ static const char sgp_fs_source_metal_ios[525] = {
 
     var<private> texUV : vec2f;
 
+    var<private> iColor : vec4f;
+
+    var<private> color : vec4f;
+
     var<private> gl_Position : vec4f;
 
     fn main_1() {
@@ -1245,6 +1605,8 @@ static const char sgp_fs_source_metal_ios[525] = {
       gl_Position = vec4f(x_20.x, x_20.y, 0.0f, 1.0f);
       let x_30 : vec4f = coord;
       texUV = vec2f(x_30.z, x_30.w);
+      let x_35 : vec4f = color;
+      iColor = x_35;
       return;
     }
 
@@ -1253,17 +1615,20 @@ static const char sgp_fs_source_metal_ios[525] = {
       gl_Position : vec4f,
       @location(0)
       texUV_1 : vec2f,
+      @location(1)
+      iColor_1 : vec4f,
     }
 
     @vertex
-    fn main(@location(0) coord_param : vec4f) -> main_out {
+    fn main(@location(0) coord_param : vec4f, @location(1) color_param : vec4f) -> main_out {
       coord = coord_param;
+      color = color_param;
       main_1();
-      return main_out(gl_Position, texUV);
+      return main_out(gl_Position, texUV, iColor);
     }
 
 */
-static const char sgp_vs_source_wgsl[586] = {
+static const char sgp_vs_source_wgsl[790] = {
     0x64,0x69,0x61,0x67,0x6e,0x6f,0x73,0x74,0x69,0x63,0x28,0x6f,0x66,0x66,0x2c,0x20,
     0x64,0x65,0x72,0x69,0x76,0x61,0x74,0x69,0x76,0x65,0x5f,0x75,0x6e,0x69,0x66,0x6f,
     0x72,0x6d,0x69,0x74,0x79,0x29,0x3b,0x0a,0x0a,0x76,0x61,0x72,0x3c,0x70,0x72,0x69,
@@ -1271,45 +1636,53 @@ static const char sgp_vs_source_wgsl[586] = {
     0x63,0x34,0x66,0x3b,0x0a,0x0a,0x76,0x61,0x72,0x3c,0x70,0x72,0x69,0x76,0x61,0x74,
     0x65,0x3e,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3a,0x20,0x76,0x65,0x63,0x32,0x66,
     0x3b,0x0a,0x0a,0x76,0x61,0x72,0x3c,0x70,0x72,0x69,0x76,0x61,0x74,0x65,0x3e,0x20,
-    0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3a,0x20,0x76,0x65,
-    0x63,0x34,0x66,0x3b,0x0a,0x0a,0x66,0x6e,0x20,0x6d,0x61,0x69,0x6e,0x5f,0x31,0x28,
-    0x29,0x20,0x7b,0x0a,0x20,0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,0x31,0x39,0x20,0x3a,
-    0x20,0x76,0x65,0x63,0x34,0x66,0x20,0x3d,0x20,0x63,0x6f,0x6f,0x72,0x64,0x3b,0x0a,
-    0x20,0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,0x32,0x30,0x20,0x3a,0x20,0x76,0x65,0x63,
-    0x32,0x66,0x20,0x3d,0x20,0x76,0x65,0x63,0x32,0x66,0x28,0x78,0x5f,0x31,0x39,0x2e,
-    0x78,0x2c,0x20,0x78,0x5f,0x31,0x39,0x2e,0x79,0x29,0x3b,0x0a,0x20,0x20,0x67,0x6c,
-    0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x76,0x65,0x63,0x34,
-    0x66,0x28,0x78,0x5f,0x32,0x30,0x2e,0x78,0x2c,0x20,0x78,0x5f,0x32,0x30,0x2e,0x79,
-    0x2c,0x20,0x30,0x2e,0x30,0x66,0x2c,0x20,0x31,0x2e,0x30,0x66,0x29,0x3b,0x0a,0x20,
-    0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,0x33,0x30,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,
-    0x66,0x20,0x3d,0x20,0x63,0x6f,0x6f,0x72,0x64,0x3b,0x0a,0x20,0x20,0x74,0x65,0x78,
-    0x55,0x56,0x20,0x3d,0x20,0x76,0x65,0x63,0x32,0x66,0x28,0x78,0x5f,0x33,0x30,0x2e,
-    0x7a,0x2c,0x20,0x78,0x5f,0x33,0x30,0x2e,0x77,0x29,0x3b,0x0a,0x20,0x20,0x72,0x65,
-    0x74,0x75,0x72,0x6e,0x3b,0x0a,0x7d,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,
-    0x6d,0x61,0x69,0x6e,0x5f,0x6f,0x75,0x74,0x20,0x7b,0x0a,0x20,0x20,0x40,0x62,0x75,
-    0x69,0x6c,0x74,0x69,0x6e,0x28,0x70,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x29,0x0a,
-    0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3a,0x20,
-    0x76,0x65,0x63,0x34,0x66,0x2c,0x0a,0x20,0x20,0x40,0x6c,0x6f,0x63,0x61,0x74,0x69,
-    0x6f,0x6e,0x28,0x30,0x29,0x0a,0x20,0x20,0x74,0x65,0x78,0x55,0x56,0x5f,0x31,0x20,
-    0x3a,0x20,0x76,0x65,0x63,0x32,0x66,0x2c,0x0a,0x7d,0x0a,0x0a,0x40,0x76,0x65,0x72,
-    0x74,0x65,0x78,0x0a,0x66,0x6e,0x20,0x6d,0x61,0x69,0x6e,0x28,0x40,0x6c,0x6f,0x63,
-    0x61,0x74,0x69,0x6f,0x6e,0x28,0x30,0x29,0x20,0x63,0x6f,0x6f,0x72,0x64,0x5f,0x70,
-    0x61,0x72,0x61,0x6d,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x29,0x20,0x2d,0x3e,
-    0x20,0x6d,0x61,0x69,0x6e,0x5f,0x6f,0x75,0x74,0x20,0x7b,0x0a,0x20,0x20,0x63,0x6f,
-    0x6f,0x72,0x64,0x20,0x3d,0x20,0x63,0x6f,0x6f,0x72,0x64,0x5f,0x70,0x61,0x72,0x61,
-    0x6d,0x3b,0x0a,0x20,0x20,0x6d,0x61,0x69,0x6e,0x5f,0x31,0x28,0x29,0x3b,0x0a,0x20,
-    0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6d,0x61,0x69,0x6e,0x5f,0x6f,0x75,0x74,
-    0x28,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,0x2c,0x20,0x74,0x65,
-    0x78,0x55,0x56,0x29,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x3b,0x0a,
+    0x0a,0x76,0x61,0x72,0x3c,0x70,0x72,0x69,0x76,0x61,0x74,0x65,0x3e,0x20,0x63,0x6f,
+    0x6c,0x6f,0x72,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x3b,0x0a,0x0a,0x76,0x61,
+    0x72,0x3c,0x70,0x72,0x69,0x76,0x61,0x74,0x65,0x3e,0x20,0x67,0x6c,0x5f,0x50,0x6f,
+    0x73,0x69,0x74,0x69,0x6f,0x6e,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x3b,0x0a,
+    0x0a,0x66,0x6e,0x20,0x6d,0x61,0x69,0x6e,0x5f,0x31,0x28,0x29,0x20,0x7b,0x0a,0x20,
+    0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,0x31,0x39,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,
+    0x66,0x20,0x3d,0x20,0x63,0x6f,0x6f,0x72,0x64,0x3b,0x0a,0x20,0x20,0x6c,0x65,0x74,
+    0x20,0x78,0x5f,0x32,0x30,0x20,0x3a,0x20,0x76,0x65,0x63,0x32,0x66,0x20,0x3d,0x20,
+    0x76,0x65,0x63,0x32,0x66,0x28,0x78,0x5f,0x31,0x39,0x2e,0x78,0x2c,0x20,0x78,0x5f,
+    0x31,0x39,0x2e,0x79,0x29,0x3b,0x0a,0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,
+    0x74,0x69,0x6f,0x6e,0x20,0x3d,0x20,0x76,0x65,0x63,0x34,0x66,0x28,0x78,0x5f,0x32,
+    0x30,0x2e,0x78,0x2c,0x20,0x78,0x5f,0x32,0x30,0x2e,0x79,0x2c,0x20,0x30,0x2e,0x30,
+    0x66,0x2c,0x20,0x31,0x2e,0x30,0x66,0x29,0x3b,0x0a,0x20,0x20,0x6c,0x65,0x74,0x20,
+    0x78,0x5f,0x33,0x30,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x20,0x3d,0x20,0x63,
+    0x6f,0x6f,0x72,0x64,0x3b,0x0a,0x20,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,0x20,
+    0x76,0x65,0x63,0x32,0x66,0x28,0x78,0x5f,0x33,0x30,0x2e,0x7a,0x2c,0x20,0x78,0x5f,
+    0x33,0x30,0x2e,0x77,0x29,0x3b,0x0a,0x20,0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,0x33,
+    0x35,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x20,0x3d,0x20,0x63,0x6f,0x6c,0x6f,
+    0x72,0x3b,0x0a,0x20,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x78,0x5f,
+    0x33,0x35,0x3b,0x0a,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x3b,0x0a,0x7d,0x0a,
+    0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x5f,0x6f,0x75,0x74,
+    0x20,0x7b,0x0a,0x20,0x20,0x40,0x62,0x75,0x69,0x6c,0x74,0x69,0x6e,0x28,0x70,0x6f,
+    0x73,0x69,0x74,0x69,0x6f,0x6e,0x29,0x0a,0x20,0x20,0x67,0x6c,0x5f,0x50,0x6f,0x73,
+    0x69,0x74,0x69,0x6f,0x6e,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x2c,0x0a,0x20,
+    0x20,0x40,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,0x28,0x30,0x29,0x0a,0x20,0x20,
+    0x74,0x65,0x78,0x55,0x56,0x5f,0x31,0x20,0x3a,0x20,0x76,0x65,0x63,0x32,0x66,0x2c,
+    0x0a,0x20,0x20,0x40,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,0x28,0x31,0x29,0x0a,
+    0x20,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x5f,0x31,0x20,0x3a,0x20,0x76,0x65,0x63,
+    0x34,0x66,0x2c,0x0a,0x7d,0x0a,0x0a,0x40,0x76,0x65,0x72,0x74,0x65,0x78,0x0a,0x66,
+    0x6e,0x20,0x6d,0x61,0x69,0x6e,0x28,0x40,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,
+    0x28,0x30,0x29,0x20,0x63,0x6f,0x6f,0x72,0x64,0x5f,0x70,0x61,0x72,0x61,0x6d,0x20,
+    0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x2c,0x20,0x40,0x6c,0x6f,0x63,0x61,0x74,0x69,
+    0x6f,0x6e,0x28,0x31,0x29,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x5f,0x70,0x61,0x72,0x61,
+    0x6d,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x29,0x20,0x2d,0x3e,0x20,0x6d,0x61,
+    0x69,0x6e,0x5f,0x6f,0x75,0x74,0x20,0x7b,0x0a,0x20,0x20,0x63,0x6f,0x6f,0x72,0x64,
+    0x20,0x3d,0x20,0x63,0x6f,0x6f,0x72,0x64,0x5f,0x70,0x61,0x72,0x61,0x6d,0x3b,0x0a,
+    0x20,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x63,0x6f,0x6c,0x6f,0x72,0x5f,
+    0x70,0x61,0x72,0x61,0x6d,0x3b,0x0a,0x20,0x20,0x6d,0x61,0x69,0x6e,0x5f,0x31,0x28,
+    0x29,0x3b,0x0a,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6d,0x61,0x69,0x6e,
+    0x5f,0x6f,0x75,0x74,0x28,0x67,0x6c,0x5f,0x50,0x6f,0x73,0x69,0x74,0x69,0x6f,0x6e,
+    0x2c,0x20,0x74,0x65,0x78,0x55,0x56,0x2c,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x29,
+    0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
 };
 /*
     diagnostic(off, derivative_uniformity);
 
-    struct fs_params {
-      /_ @offset(0) _/
-      iColor : vec4f,
-    }
-
     var<private> fragColor : vec4f;
 
     @group(1) @binding(32) var iTexChannel0 : texture_2d<f32>;
@@ -1318,13 +1691,13 @@ static const char sgp_vs_source_wgsl[586] = {
 
     var<private> texUV : vec2f;
 
-    @group(0) @binding(4) var<uniform> x_27 : fs_params;
+    var<private> iColor : vec4f;
 
     fn main_1() {
       let x_23 : vec2f = texUV;
       let x_24 : vec4f = textureSample(iTexChannel0, iSmpChannel0, x_23);
-      let x_32 : vec4f = x_27.iColor;
-      fragColor = (x_24 * x_32);
+      let x_27 : vec4f = iColor;
+      fragColor = (x_24 * x_27);
       return;
     }
 
@@ -1334,59 +1707,58 @@ static const char sgp_vs_source_wgsl[586] = {
     }
 
     @fragment
-    fn main(@location(0) texUV_param : vec2f) -> main_out {
+    fn main(@location(0) texUV_param : vec2f, @location(1) iColor_param : vec4f) -> main_out {
       texUV = texUV_param;
+      iColor = iColor_param;
       main_1();
       return main_out(fragColor);
     }
 
 */
-static const char sgp_fs_source_wgsl[710] = {
+static const char sgp_fs_source_wgsl[682] = {
     0x64,0x69,0x61,0x67,0x6e,0x6f,0x73,0x74,0x69,0x63,0x28,0x6f,0x66,0x66,0x2c,0x20,
     0x64,0x65,0x72,0x69,0x76,0x61,0x74,0x69,0x76,0x65,0x5f,0x75,0x6e,0x69,0x66,0x6f,
-    0x72,0x6d,0x69,0x74,0x79,0x29,0x3b,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,
-    0x66,0x73,0x5f,0x70,0x61,0x72,0x61,0x6d,0x73,0x20,0x7b,0x0a,0x20,0x20,0x2f,0x2a,
-    0x20,0x40,0x6f,0x66,0x66,0x73,0x65,0x74,0x28,0x30,0x29,0x20,0x2a,0x2f,0x0a,0x20,
-    0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x2c,
-    0x0a,0x7d,0x0a,0x0a,0x76,0x61,0x72,0x3c,0x70,0x72,0x69,0x76,0x61,0x74,0x65,0x3e,
-    0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x76,0x65,0x63,
-    0x34,0x66,0x3b,0x0a,0x0a,0x40,0x67,0x72,0x6f,0x75,0x70,0x28,0x31,0x29,0x20,0x40,
-    0x62,0x69,0x6e,0x64,0x69,0x6e,0x67,0x28,0x33,0x32,0x29,0x20,0x76,0x61,0x72,0x20,
-    0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x3a,0x20,0x74,
-    0x65,0x78,0x74,0x75,0x72,0x65,0x5f,0x32,0x64,0x3c,0x66,0x33,0x32,0x3e,0x3b,0x0a,
-    0x0a,0x40,0x67,0x72,0x6f,0x75,0x70,0x28,0x31,0x29,0x20,0x40,0x62,0x69,0x6e,0x64,
-    0x69,0x6e,0x67,0x28,0x34,0x38,0x29,0x20,0x76,0x61,0x72,0x20,0x69,0x53,0x6d,0x70,
-    0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x3a,0x20,0x73,0x61,0x6d,0x70,0x6c,
-    0x65,0x72,0x3b,0x0a,0x0a,0x76,0x61,0x72,0x3c,0x70,0x72,0x69,0x76,0x61,0x74,0x65,
-    0x3e,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3a,0x20,0x76,0x65,0x63,0x32,0x66,0x3b,
-    0x0a,0x0a,0x40,0x67,0x72,0x6f,0x75,0x70,0x28,0x30,0x29,0x20,0x40,0x62,0x69,0x6e,
-    0x64,0x69,0x6e,0x67,0x28,0x34,0x29,0x20,0x76,0x61,0x72,0x3c,0x75,0x6e,0x69,0x66,
-    0x6f,0x72,0x6d,0x3e,0x20,0x78,0x5f,0x32,0x37,0x20,0x3a,0x20,0x66,0x73,0x5f,0x70,
-    0x61,0x72,0x61,0x6d,0x73,0x3b,0x0a,0x0a,0x66,0x6e,0x20,0x6d,0x61,0x69,0x6e,0x5f,
-    0x31,0x28,0x29,0x20,0x7b,0x0a,0x20,0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,0x32,0x33,
-    0x20,0x3a,0x20,0x76,0x65,0x63,0x32,0x66,0x20,0x3d,0x20,0x74,0x65,0x78,0x55,0x56,
-    0x3b,0x0a,0x20,0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,0x32,0x34,0x20,0x3a,0x20,0x76,
-    0x65,0x63,0x34,0x66,0x20,0x3d,0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x53,0x61,
-    0x6d,0x70,0x6c,0x65,0x28,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,
-    0x30,0x2c,0x20,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2c,
-    0x20,0x78,0x5f,0x32,0x33,0x29,0x3b,0x0a,0x20,0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,
-    0x33,0x32,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x20,0x3d,0x20,0x78,0x5f,0x32,
-    0x37,0x2e,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x3b,0x0a,0x20,0x20,0x66,0x72,0x61,0x67,
-    0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x28,0x78,0x5f,0x32,0x34,0x20,0x2a,0x20,
-    0x78,0x5f,0x33,0x32,0x29,0x3b,0x0a,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x3b,
-    0x0a,0x7d,0x0a,0x0a,0x73,0x74,0x72,0x75,0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x5f,
-    0x6f,0x75,0x74,0x20,0x7b,0x0a,0x20,0x20,0x40,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,
-    0x6e,0x28,0x30,0x29,0x0a,0x20,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,
-    0x5f,0x31,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x2c,0x0a,0x7d,0x0a,0x0a,0x40,
-    0x66,0x72,0x61,0x67,0x6d,0x65,0x6e,0x74,0x0a,0x66,0x6e,0x20,0x6d,0x61,0x69,0x6e,
-    0x28,0x40,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,0x28,0x30,0x29,0x20,0x74,0x65,
-    0x78,0x55,0x56,0x5f,0x70,0x61,0x72,0x61,0x6d,0x20,0x3a,0x20,0x76,0x65,0x63,0x32,
-    0x66,0x29,0x20,0x2d,0x3e,0x20,0x6d,0x61,0x69,0x6e,0x5f,0x6f,0x75,0x74,0x20,0x7b,
-    0x0a,0x20,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3d,0x20,0x74,0x65,0x78,0x55,0x56,
-    0x5f,0x70,0x61,0x72,0x61,0x6d,0x3b,0x0a,0x20,0x20,0x6d,0x61,0x69,0x6e,0x5f,0x31,
-    0x28,0x29,0x3b,0x0a,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x20,0x6d,0x61,0x69,
-    0x6e,0x5f,0x6f,0x75,0x74,0x28,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x29,
-    0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
+    0x72,0x6d,0x69,0x74,0x79,0x29,0x3b,0x0a,0x0a,0x76,0x61,0x72,0x3c,0x70,0x72,0x69,
+    0x76,0x61,0x74,0x65,0x3e,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,
+    0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x3b,0x0a,0x0a,0x40,0x67,0x72,0x6f,0x75,0x70,
+    0x28,0x31,0x29,0x20,0x40,0x62,0x69,0x6e,0x64,0x69,0x6e,0x67,0x28,0x33,0x32,0x29,
+    0x20,0x76,0x61,0x72,0x20,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,
+    0x30,0x20,0x3a,0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x5f,0x32,0x64,0x3c,0x66,
+    0x33,0x32,0x3e,0x3b,0x0a,0x0a,0x40,0x67,0x72,0x6f,0x75,0x70,0x28,0x31,0x29,0x20,
+    0x40,0x62,0x69,0x6e,0x64,0x69,0x6e,0x67,0x28,0x34,0x38,0x29,0x20,0x76,0x61,0x72,
+    0x20,0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x20,0x3a,0x20,
+    0x73,0x61,0x6d,0x70,0x6c,0x65,0x72,0x3b,0x0a,0x0a,0x76,0x61,0x72,0x3c,0x70,0x72,
+    0x69,0x76,0x61,0x74,0x65,0x3e,0x20,0x74,0x65,0x78,0x55,0x56,0x20,0x3a,0x20,0x76,
+    0x65,0x63,0x32,0x66,0x3b,0x0a,0x0a,0x76,0x61,0x72,0x3c,0x70,0x72,0x69,0x76,0x61,
+    0x74,0x65,0x3e,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3a,0x20,0x76,0x65,0x63,
+    0x34,0x66,0x3b,0x0a,0x0a,0x66,0x6e,0x20,0x6d,0x61,0x69,0x6e,0x5f,0x31,0x28,0x29,
+    0x20,0x7b,0x0a,0x20,0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,0x32,0x33,0x20,0x3a,0x20,
+    0x76,0x65,0x63,0x32,0x66,0x20,0x3d,0x20,0x74,0x65,0x78,0x55,0x56,0x3b,0x0a,0x20,
+    0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,0x32,0x34,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,
+    0x66,0x20,0x3d,0x20,0x74,0x65,0x78,0x74,0x75,0x72,0x65,0x53,0x61,0x6d,0x70,0x6c,
+    0x65,0x28,0x69,0x54,0x65,0x78,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2c,0x20,
+    0x69,0x53,0x6d,0x70,0x43,0x68,0x61,0x6e,0x6e,0x65,0x6c,0x30,0x2c,0x20,0x78,0x5f,
+    0x32,0x33,0x29,0x3b,0x0a,0x20,0x20,0x6c,0x65,0x74,0x20,0x78,0x5f,0x32,0x37,0x20,
+    0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x20,0x3d,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,
+    0x3b,0x0a,0x20,0x20,0x66,0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,
+    0x28,0x78,0x5f,0x32,0x34,0x20,0x2a,0x20,0x78,0x5f,0x32,0x37,0x29,0x3b,0x0a,0x20,
+    0x20,0x72,0x65,0x74,0x75,0x72,0x6e,0x3b,0x0a,0x7d,0x0a,0x0a,0x73,0x74,0x72,0x75,
+    0x63,0x74,0x20,0x6d,0x61,0x69,0x6e,0x5f,0x6f,0x75,0x74,0x20,0x7b,0x0a,0x20,0x20,
+    0x40,0x6c,0x6f,0x63,0x61,0x74,0x69,0x6f,0x6e,0x28,0x30,0x29,0x0a,0x20,0x20,0x66,
+    0x72,0x61,0x67,0x43,0x6f,0x6c,0x6f,0x72,0x5f,0x31,0x20,0x3a,0x20,0x76,0x65,0x63,
+    0x34,0x66,0x2c,0x0a,0x7d,0x0a,0x0a,0x40,0x66,0x72,0x61,0x67,0x6d,0x65,0x6e,0x74,
+    0x0a,0x66,0x6e,0x20,0x6d,0x61,0x69,0x6e,0x28,0x40,0x6c,0x6f,0x63,0x61,0x74,0x69,
+    0x6f,0x6e,0x28,0x30,0x29,0x20,0x74,0x65,0x78,0x55,0x56,0x5f,0x70,0x61,0x72,0x61,
+    0x6d,0x20,0x3a,0x20,0x76,0x65,0x63,0x32,0x66,0x2c,0x20,0x40,0x6c,0x6f,0x63,0x61,
+    0x74,0x69,0x6f,0x6e,0x28,0x31,0x29,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x5f,0x70,
+    0x61,0x72,0x61,0x6d,0x20,0x3a,0x20,0x76,0x65,0x63,0x34,0x66,0x29,0x20,0x2d,0x3e,
+    0x20,0x6d,0x61,0x69,0x6e,0x5f,0x6f,0x75,0x74,0x20,0x7b,0x0a,0x20,0x20,0x74,0x65,
+    0x78,0x55,0x56,0x20,0x3d,0x20,0x74,0x65,0x78,0x55,0x56,0x5f,0x70,0x61,0x72,0x61,
+    0x6d,0x3b,0x0a,0x20,0x20,0x69,0x43,0x6f,0x6c,0x6f,0x72,0x20,0x3d,0x20,0x69,0x43,
+    0x6f,0x6c,0x6f,0x72,0x5f,0x70,0x61,0x72,0x61,0x6d,0x3b,0x0a,0x20,0x20,0x6d,0x61,
+    0x69,0x6e,0x5f,0x31,0x28,0x29,0x3b,0x0a,0x20,0x20,0x72,0x65,0x74,0x75,0x72,0x6e,
+    0x20,0x6d,0x61,0x69,0x6e,0x5f,0x6f,0x75,0x74,0x28,0x66,0x72,0x61,0x67,0x43,0x6f,
+    0x6c,0x6f,0x72,0x29,0x3b,0x0a,0x7d,0x0a,0x0a,0x00,
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1459,7 +1831,7 @@ static sg_blend_state _sgp_blend_state(sgp_blend_mode blend_mode) {
     return blend;
 }
 
-static sg_pipeline _sgp_make_pipeline(sg_primitive_type primitive_type, sgp_blend_mode blend_mode, sg_pixel_format pixel_format, sg_shader shader) {
+static sg_pipeline _sgp_make_pipeline(sg_primitive_type primitive_type, sgp_blend_mode blend_mode, sg_pixel_format pixel_format, sg_shader shader, sg_index_type index_type) {
     sg_blend_state blend = _sgp_blend_state(blend_mode);
 
     if(primitive_type == _SG_PRIMITIVETYPE_DEFAULT)
@@ -1470,10 +1842,14 @@ static sg_pipeline _sgp_make_pipeline(sg_primitive_type primitive_type, sgp_blen
     memset(&pip_desc, 0, sizeof(sg_pipeline_desc));
     pip_desc.shader = shader;
     pip_desc.layout.buffers[0].stride = sizeof(_sgp_vertex);
+    pip_desc.layout.attrs[0].offset = offsetof(_sgp_vertex, position);
     pip_desc.layout.attrs[0].format = SG_VERTEXFORMAT_FLOAT4;
+    pip_desc.layout.attrs[1].offset = offsetof(_sgp_vertex, color);
+    pip_desc.layout.attrs[1].format = SG_VERTEXFORMAT_UBYTE4N;
     pip_desc.colors[0].pixel_format = pixel_format;
     pip_desc.colors[0].blend = blend;
     pip_desc.primitive_type = primitive_type;
+    pip_desc.index_type = index_type;
 
     sg_pipeline pip = sg_make_pipeline(&pip_desc);
     if(pip.id != SG_INVALID_ID && sg_query_pipeline_state(pip) != SG_RESOURCESTATE_VALID) {
@@ -1488,18 +1864,27 @@ static sg_pipeline _sgp_lookup_pipeline(sg_primitive_type primitive_type, sgp_bl
     if(_sgp.pipelines[pip_index].id != SG_INVALID_ID)
         return _sgp.pipelines[pip_index];
 
-    sg_pipeline pip = _sgp_make_pipeline(primitive_type, blend_mode, _sgp.desc.pixel_format, _sgp.shader);
+    sg_pipeline pip = _sgp_make_pipeline(primitive_type, blend_mode, _sgp.desc.pixel_format, _sgp.shader, SG_INDEXTYPE_NONE);
     if(pip.id != SG_INVALID_ID)
         _sgp.pipelines[pip_index] = pip;
     return pip;
 }
 
+// triangles drawn through the quad index buffer, 4 vertices per rect instead of 6
+static sg_pipeline _sgp_lookup_quad_pipeline(sgp_blend_mode blend_mode) {
+    if(_sgp.quad_pipelines[blend_mode].id != SG_INVALID_ID)
+        return _sgp.quad_pipelines[blend_mode];
+
+    sg_pipeline pip = _sgp_make_pipeline(SG_PRIMITIVETYPE_TRIANGLES, blend_mode, _sgp.desc.pixel_format, _sgp.shader, _sgp.quad_index_type);
+    if(pip.id != SG_INVALID_ID)
+        _sgp.quad_pipelines[blend_mode] = pip;
+    return pip;
+}
+
 static sg_shader _sgp_make_common_shader(void) {
     sg_backend backend = sg_query_backend();
     sg_shader_desc desc;
     memset(&desc, 0, sizeof(desc));
-    desc.fs.uniform_blocks[0].size = sizeof(sgp_color);
-    desc.fs.uniform_blocks[0].layout = SG_UNIFORMLAYOUT_STD140;
     desc.fs.images[0].used = true;
     desc.fs.images[0].multisampled = false;
     desc.fs.images[0].image_type = SG_IMAGETYPE_2D;
@@ -1512,14 +1897,14 @@ static sg_shader _sgp_make_common_shader(void) {
 
     // GLCORE33 / GLES3 only
     desc.attrs[0].name = "coord";
+    desc.attrs[1].name = "color";
     desc.fs.image_sampler_pairs[0].glsl_name = "iTexChannel0_iSmpChannel0";
-    desc.fs.uniform_blocks[0].uniforms[0].name = "fs_params";
-    desc.fs.uniform_blocks[0].uniforms[0].type = SG_UNIFORMTYPE_FLOAT4;
-    desc.fs.uniform_blocks[0].uniforms[0].array_count = 1;
 
     // D3D11 only
     desc.attrs[0].sem_name = "TEXCOORD";
     desc.attrs[0].sem_index = 0;
+    desc.attrs[1].sem_name = "TEXCOORD";
+    desc.attrs[1].sem_index = 1;
     desc.vs.d3d11_target = "vs_4_0";
     desc.fs.d3d11_target = "ps_4_0";
 
@@ -1588,6 +1973,7 @@ void sgp_setup(const sgp_desc* desc) {
     // init
     _sgp.init_cookie = _SGP_INIT_COOKIE;
     _sgp.last_error = SGP_NO_ERROR;
+    _sgp.transform = _sgp_select_transform_kernel();
 
     // set desc default values
     _sgp.desc = *desc;
@@ -1625,6 +2011,43 @@ void sgp_setup(const sgp_desc* desc) {
         return;
     }
 
+    // create quad index buffer, every rect is 2 triangles over 4 vertices and
+    // the indices are relative to the start of the draw, so one buffer covers
+    // any draw that fits in the vertex buffer
+    uint32_t num_quads = _sgp.num_vertices / 4;
+    if(num_quads > 0) {
+        _sgp.quad_index_type = _sgp.num_vertices > 65536 ? SG_INDEXTYPE_UINT32 : SG_INDEXTYPE_UINT16;
+        size_t index_size = _sgp.quad_index_type == SG_INDEXTYPE_UINT32 ? sizeof(uint32_t) : sizeof(uint16_t);
+        void* indices = _sg_malloc(num_quads * 6 * index_size);
+        if(!indices) {
+            sgp_shutdown();
+            _sgp_set_error(SGP_ERROR_ALLOC_FAILED);
+            return;
+        }
+        const uint32_t quad[6] = {0, 1, 2, 3, 0, 2};
+        for(uint32_t i=0;i<num_quads*6;++i) {
+            uint32_t index = (i/6)*4 + quad[i%6];
+            if(_sgp.quad_index_type == SG_INDEXTYPE_UINT32)
+                ((uint32_t*)indices)[i] = index;
+            else
+                ((uint16_t*)indices)[i] = (uint16_t)index;
+        }
+        sg_buffer_desc index_buf_desc;
+        memset(&index_buf_desc, 0, sizeof(sg_buffer_desc));
+        index_buf_desc.type = SG_BUFFERTYPE_INDEXBUFFER;
+        index_buf_desc.usage = SG_USAGE_IMMUTABLE;
+        index_buf_desc.data.ptr = indices;
+        index_buf_desc.data.size = num_quads * 6 * index_size;
+        index_buf_desc.label = "sgp-quad-indices";
+        _sgp.quad_index_buf = sg_make_buffer(&index_buf_desc);
+        _sg_free(indices);
+        if(sg_query_buffer_state(_sgp.quad_index_buf) != SG_RESOURCESTATE_VALID) {
+            sgp_shutdown();
+            _sgp_set_error(SGP_ERROR_MAKE_INDEX_BUFFER_FAILED);
+            return;
+        }
+    }
+
     // create white texture
     uint32_t pixels[4];
     memset(pixels, 0xFF, sizeof(pixels));
@@ -1675,6 +2098,10 @@ void sgp_setup(const sgp_desc* desc) {
     pips_ok = pips_ok && _sgp_lookup_pipeline(SG_PRIMITIVETYPE_TRIANGLE_STRIP, SGP_BLENDMODE_BLEND).id != SG_INVALID_ID;
     pips_ok = pips_ok && _sgp_lookup_pipeline(SG_PRIMITIVETYPE_LINE_STRIP, SGP_BLENDMODE_NONE).id != SG_INVALID_ID;
     pips_ok = pips_ok && _sgp_lookup_pipeline(SG_PRIMITIVETYPE_LINE_STRIP, SGP_BLENDMODE_BLEND).id != SG_INVALID_ID;
+    if(_sgp.quad_index_buf.id != SG_INVALID_ID) {
+        pips_ok = pips_ok && _sgp_lookup_quad_pipeline(SGP_BLENDMODE_NONE).id != SG_INVALID_ID;
+        pips_ok = pips_ok && _sgp_lookup_quad_pipeline(SGP_BLENDMODE_BLEND).id != SG_INVALID_ID;
+    }
     if(!pips_ok) {
         sgp_shutdown();
         _sgp_set_error(SGP_ERROR_MAKE_COMMON_PIPELINE_FAILED);
@@ -1697,10 +2124,17 @@ void sgp_shutdown(void) {
         if(pip.id != SG_INVALID_ID)
             sg_destroy_pipeline(pip);
     }
+    for(uint32_t i=0;i<_SGP_BLENDMODE_NUM;++i) {
+        sg_pipeline pip = _sgp.quad_pipelines[i];
+        if(pip.id != SG_INVALID_ID)
+            sg_destroy_pipeline(pip);
+    }
     if(_sgp.shader.id != SG_INVALID_ID)
         sg_destroy_shader(_sgp.shader);
     if(_sgp.vertex_buf.id != SG_INVALID_ID)
         sg_destroy_buffer(_sgp.vertex_buf);
+    if(_sgp.quad_index_buf.id != SG_INVALID_ID)
+        sg_destroy_buffer(_sgp.quad_index_buf);
     if(_sgp.white_img.id != SG_INVALID_ID)
         sg_destroy_image(_sgp.white_img);
     if(_sgp.nearest_smp.id != SG_INVALID_ID)
@@ -1742,6 +2176,8 @@ const char* sgp_get_error_message(sgp_error error_code) {
             return "SGP failed to allocate buffers";
         case SGP_ERROR_MAKE_VERTEX_BUFFER_FAILED:
             return "SGP failed to create vertex buffer";
+        case SGP_ERROR_MAKE_INDEX_BUFFER_FAILED:
+            return "SGP failed to create quad index buffer";
         case SGP_ERROR_MAKE_WHITE_IMAGE_FAILED:
             return "SGP failed to create white image";
         case SGP_ERROR_MAKE_NEAREST_SAMPLER_FAILED:
@@ -1760,7 +2196,7 @@ sg_pipeline sgp_make_pipeline(const sgp_pipeline_desc* desc) {
     sg_shader shader = sg_make_shader(&desc->shader);
     sg_pixel_format pixel_format = _sg_def(desc->pixel_format, _sgp.desc.pixel_format);
     if(sg_query_shader_state(shader) == SG_RESOURCESTATE_VALID)
-        pip = _sgp_make_pipeline(desc->primitive_type, desc->blend_mode, pixel_format, shader);
+        pip = _sgp_make_pipeline(desc->primitive_type, desc->blend_mode, pixel_format, shader, SG_INDEXTYPE_NONE);
     else if(shader.id != SG_INVALID_ID)
         sg_destroy_shader(shader);
     return pip;
@@ -1785,6 +2221,8 @@ void sgp_begin(int width, int height) {
 
     // begin reset last error
     _sgp.last_error = SGP_NO_ERROR;
+    if(_sgp.cur_state == 0)
+        _sgp.num_culled = 0;
 
     // save current state
     _sgp.state_stack[_sgp.cur_state++] = _sgp.state;
@@ -1801,11 +2239,6 @@ void sgp_begin(int width, int height) {
     _sgp.state.thickness = _sg_max(1.0f / width, 1.0f / height);
     _sgp.state.color = _sgp_white_color;
     memset(&_sgp.state.uniform, 0, sizeof(sgp_uniform));
-    _sgp.state.uniform.size = sizeof(sgp_color);
-    _sgp.state.uniform.content[0] = _sgp_white_color.r;
-    _sgp.state.uniform.content[1] = _sgp_white_color.g;
-    _sgp.state.uniform.content[2] = _sgp_white_color.b;
-    _sgp.state.uniform.content[3] = _sgp_white_color.a;
     _sgp.state.blend_mode = SGP_BLENDMODE_NONE;
     _sgp.state._base_vertex = _sgp.cur_vertex;
     _sgp.state._base_uniform = _sgp.cur_uniform;
@@ -1828,7 +2261,20 @@ static void _sgp_get_pipeline_uniform_count(sg_pipeline pip, int* vs_uniform_cou
     *fs_uniform_count = p ? p->shader->cmn.stage[SG_SHADERSTAGE_FS].num_uniform_blocks : 0;
 }
 
+static sgp_irect _sgp_scale_rect(sgp_irect rect, float sx, float sy) {
+    if(sx == 1.0f && sy == 1.0f)
+        return rect;
+    int x1 = (int)floorf(rect.x*sx + 0.5f), y1 = (int)floorf(rect.y*sy + 0.5f);
+    int x2 = (int)floorf((rect.x + rect.w)*sx + 0.5f), y2 = (int)floorf((rect.y + rect.h)*sy + 0.5f);
+    sgp_irect scaled = {x1, y1, x2 - x1, y2 - y1};
+    return scaled;
+}
+
 void sgp_flush(void) {
+    sgp_flush_scaled(1.0f, 1.0f);
+}
+
+void sgp_flush_scaled(float sx, float sy) {
     SOKOL_ASSERT(_sgp.init_cookie == _SGP_INIT_COOKIE);
     SOKOL_ASSERT(_sgp.cur_state > 0);
 
@@ -1860,6 +2306,7 @@ void sgp_flush(void) {
 
     const uint32_t SG_IMPOSSIBLE_ID = 0xffffffffU;
     uint32_t cur_pip_id = SG_IMPOSSIBLE_ID;
+    bool cur_indexed = false;
     uint32_t cur_uniform_index = SG_IMPOSSIBLE_ID;
     uint32_t cur_imgs_id[SGP_TEXTURE_SLOTS];
     for(int i=0;i<SGP_TEXTURE_SLOTS;++i)
@@ -1876,13 +2323,23 @@ void sgp_flush(void) {
         _sgp_command* cmd = &_sgp.commands[i];
         switch(cmd->cmd) {
             case SGP_COMMAND_VIEWPORT: {
-                sgp_irect* args = &cmd->args.viewport;
-                sg_apply_viewport(args->x, args->y, args->w, args->h, true);
+                sgp_irect args = _sgp_scale_rect(cmd->args.viewport, sx, sy);
+                sg_apply_viewport(args.x, args.y, args.w, args.h, true);
                 break;
             }
             case SGP_COMMAND_SCISSOR: {
-                sgp_irect* args = &cmd->args.scissor;
-                sg_apply_scissor_rect(args->x, args->y, args->w, args->h, true);
+                sgp_irect args = _sgp_scale_rect(cmd->args.scissor, sx, sy);
+                sg_apply_scissor_rect(args.x, args.y, args.w, args.h, true);
+                break;
+            }
+            case SGP_COMMAND_CALLBACK: {
+                _sgp_callback_args* args = &cmd->args.callback;
+                args->func(args->user_data);
+                // the callback may have applied anything, so everything is applied again
+                cur_pip_id = SG_IMPOSSIBLE_ID;
+                cur_uniform_index = SG_IMPOSSIBLE_ID;
+                for(int j=0;j<SGP_TEXTURE_SLOTS;++j)
+                    cur_imgs_id[j] = SG_IMPOSSIBLE_ID;
                 break;
             }
             case SGP_COMMAND_DRAW: {
@@ -1897,6 +2354,15 @@ void sgp_flush(void) {
                     apply_bindings = true;
                     cur_pip_id = args->pip.id;
                     sg_apply_pipeline(args->pip);
+                    _sg_pipeline_t* p = _sg_lookup_pipeline(&_sg.pools, args->pip.id);
+                    cur_indexed = p && p->cmn.index_type != SG_INDEXTYPE_NONE;
+                    bind.index_buffer.id = cur_indexed ? _sgp.quad_index_buf.id : SG_INVALID_ID;
+                    bind.vertex_buffer_offsets[0] = offset;
+                }
+                // indices restart at every quad draw, so its vertices are bound from their start
+                if(cur_indexed) {
+                    bind.vertex_buffer_offsets[0] = offset + (int)((args->vertex_index - base_vertex) * sizeof(_sgp_vertex));
+                    apply_bindings = true;
                 }
                 // bindings
                 for(uint32_t j=0;j<SGP_TEXTURE_SLOTS;++j) {
@@ -1934,7 +2400,10 @@ void sgp_flush(void) {
                     }
                 }
                 //  draw
-                sg_draw((int)(args->vertex_index - base_vertex), (int)args->num_vertices, 1);
+                if(cur_indexed)
+                    sg_draw(0, (int)(args->num_vertices / 4 * 6), 1);
+                else
+                    sg_draw((int)(args->vertex_index - base_vertex), (int)args->num_vertices, 1);
                 break;
             }
             case SGP_COMMAND_NONE: {
@@ -2076,15 +2545,8 @@ void sgp_set_pipeline(sg_pipeline pipeline) {
     SOKOL_ASSERT(_sgp.init_cookie == _SGP_INIT_COOKIE);
     _sgp.state.pipeline = pipeline;
 
-    // restore uniform for the default pipeline
+    // the default pipeline has no uniforms, the color is in the vertices
     memset(&_sgp.state.uniform, 0, sizeof(sgp_uniform));
-    if(pipeline.id == SG_INVALID_ID) {
-        _sgp.state.uniform.size = sizeof(sgp_color);
-        _sgp.state.uniform.content[0] = _sgp.state.color.r;
-        _sgp.state.uniform.content[1] = _sgp.state.color.g;
-        _sgp.state.uniform.content[2] = _sgp.state.color.b;
-        _sgp.state.uniform.content[3] = _sgp.state.color.a;
-    }
 }
 
 void sgp_reset_pipeline(void) {
@@ -2129,16 +2591,6 @@ void sgp_set_color(float r, float g, float b, float a) {
     SOKOL_ASSERT(_sgp.cur_state > 0);
     sgp_color color = {r,g,b,a};
     _sgp.state.color = color;
-
-    // update uniform for the default pipeline
-    if(_sgp.state.pipeline.id == SG_INVALID_ID) {
-        memset(&_sgp.state.uniform, 0, sizeof(sgp_uniform));
-        _sgp.state.uniform.size = sizeof(sgp_color);
-        _sgp.state.uniform.content[0] = color.r;
-        _sgp.state.uniform.content[1] = color.g;
-        _sgp.state.uniform.content[2] = color.b;
-        _sgp.state.uniform.content[3] = color.a;
-    }
 }
 
 void sgp_reset_color(void) {
@@ -2517,37 +2969,142 @@ static void _sgp_queue_draw(sg_pipeline pip, _sgp_region region, uint32_t vertex
     cmd->args.draw.num_vertices = num_vertices;
 }
 
-static inline sgp_vec2 _sgp_mat3_vec2_mul(const sgp_mat2x3* m, const sgp_vec2* v) {
-    sgp_vec2 u = {
-        m->v[0][0]*v->x + m->v[0][1]*v->y + m->v[0][2],
-        m->v[1][0]*v->x + m->v[1][1]*v->y + m->v[1][2]
+// rects are written as 4 vertices for the quad index buffer, custom pipelines
+// aren't indexed so they still get 6
+static inline bool _sgp_indexed_quads(void) {
+    return _sgp.state.pipeline.id == SG_INVALID_ID && _sgp.quad_index_buf.id != SG_INVALID_ID;
+}
+
+static inline sg_pipeline _sgp_lookup_rects_pipeline(bool indexed, sgp_blend_mode blend_mode) {
+    return indexed ? _sgp_lookup_quad_pipeline(blend_mode) : _sgp_lookup_pipeline(SG_PRIMITIVETYPE_TRIANGLES, blend_mode);
+}
+
+static inline uint8_t _sgp_color_channel_ub(float c) {
+    return (uint8_t)(_sg_clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// the state color packed for the vertices, converted once per draw
+static inline sgp_color_ub4 _sgp_state_color_ub4(void) {
+    sgp_color_ub4 color = {
+        _sgp_color_channel_ub(_sgp.state.color.r),
+        _sgp_color_channel_ub(_sgp.state.color.g),
+        _sgp_color_channel_ub(_sgp.state.color.b),
+        _sgp_color_channel_ub(_sgp.state.color.a)
+    };
+    return color;
+}
+
+// the part of the screen that can be drawn to, the viewport cut down by the
+// scissor and widened by pad, mapped back through the inverse of the current
+// transform and bounded, so primitives are tested without transforming them.
+// The bounds are exact for scales and translations and only conservative under
+// rotations. Nothing is culled when the transform can't be inverted, or when a
+// custom pipeline is set, its vertex shader can move vertices anywhere.
+static _sgp_region _sgp_local_clip_region(float pad) {
+    if(_sgp.state.pipeline.id != SG_INVALID_ID) {
+        _sgp_region all = {-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX};
+        return all;
+    }
+    _sgp_region clip = {-1.0f, -1.0f, 1.0f, 1.0f};
+    sgp_irect scissor = _sgp.state.scissor;
+    float w = (float)_sgp.state.viewport.w, h = (float)_sgp.state.viewport.h;
+    if(!(scissor.w < 0 && scissor.h < 0) && w > 0.0f && h > 0.0f) {
+        clip.x1 = _sg_max(clip.x1, -1.0f + 2.0f*(float)scissor.x/w);
+        clip.x2 = _sg_min(clip.x2, -1.0f + 2.0f*(float)(scissor.x + scissor.w)/w);
+        clip.y1 = _sg_max(clip.y1, 1.0f - 2.0f*(float)(scissor.y + scissor.h)/h);
+        clip.y2 = _sg_min(clip.y2, 1.0f - 2.0f*(float)scissor.y/h);
+    }
+    clip.x1 -= pad; clip.y1 -= pad;
+    clip.x2 += pad; clip.y2 += pad;
+
+    const sgp_mat2x3* m = &_sgp.state.mvp;
+    float det = m->v[0][0]*m->v[1][1] - m->v[0][1]*m->v[1][0];
+    _sgp_region local = {-FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX};
+    if(det == 0.0f)
+        return local;
+    float inv_det = 1.0f/det;
+    float ia = m->v[1][1]*inv_det, ib = -m->v[0][1]*inv_det;
+    float ic = -m->v[1][0]*inv_det, id = m->v[0][0]*inv_det;
+    const sgp_vec2 corners[4] = {
+        {clip.x1 - m->v[0][2], clip.y1 - m->v[1][2]},
+        {clip.x2 - m->v[0][2], clip.y1 - m->v[1][2]},
+        {clip.x2 - m->v[0][2], clip.y2 - m->v[1][2]},
+        {clip.x1 - m->v[0][2], clip.y2 - m->v[1][2]}
     };
-    return u;
+    local.x1 = local.y1 = FLT_MAX;
+    local.x2 = local.y2 = -FLT_MAX;
+    for(int i=0;i<4;++i) {
+        float x = ia*corners[i].x + ib*corners[i].y;
+        float y = ic*corners[i].x + id*corners[i].y;
+        local.x1 = _sg_min(local.x1, x); local.y1 = _sg_min(local.y1, y);
+        local.x2 = _sg_max(local.x2, x); local.y2 = _sg_max(local.y2, y);
+    }
+    return local;
 }
 
-static void _sgp_transform_vec2(sgp_mat2x3* matrix, sgp_vec2* dst, const sgp_vec2 *src, uint32_t count) {
-    for(uint32_t i=0;i<count;++i) {
-        dst[i] = _sgp_mat3_vec2_mul(matrix, &src[i]);
+// not short circuited, each side alone is a coin flip for scattered primitives
+static inline bool _sgp_box_culled(_sgp_region clip, float x1, float y1, float x2, float y2) {
+    return (x1 > clip.x2) | (x2 < clip.x1) | (y1 > clip.y2) | (y2 < clip.y1);
+}
+
+static inline bool _sgp_rect_culled(_sgp_region clip, const sgp_rect* rect) {
+    float x2 = rect->x + rect->w, y2 = rect->y + rect->h;
+    return _sgp_box_culled(clip, _sg_min(rect->x, x2), _sg_min(rect->y, y2), _sg_max(rect->x, x2), _sg_max(rect->y, y2));
+}
+
+static inline bool _sgp_points_culled(_sgp_region clip, const sgp_vec2* points, uint32_t count) {
+    float x1 = points[0].x, y1 = points[0].y, x2 = x1, y2 = y1;
+    for(uint32_t i=1;i<count;++i) {
+        x1 = _sg_min(x1, points[i].x); y1 = _sg_min(y1, points[i].y);
+        x2 = _sg_max(x2, points[i].x); y2 = _sg_max(y2, points[i].y);
     }
+    return _sgp_box_culled(clip, x1, y1, x2, y2);
 }
 
-static void _sgp_draw_solid_pip(sg_pipeline pip, const sgp_vec2* vertices, uint32_t num_vertices, float thickness) {
+// primitive_vertices is how many vertices make each primitive, 0 keeps them
+// all (strips can't drop a primitive without breaking the ones around it)
+static void _sgp_draw_solid_pip(sg_pipeline pip, const sgp_vec2* vertices, uint32_t num_vertices, uint32_t primitive_vertices, float thickness) {
     uint32_t vertex_index = _sgp.cur_vertex;
-    _sgp_vertex* transformed_vertices = _sgp_next_vertices(num_vertices);
-    if(SOKOL_UNLIKELY(!vertices)) return;
+    _sgp_vertex* transformed_vertices = &_sgp.vertices[vertex_index];
+    uint32_t max_vertices = _sgp.num_vertices - vertex_index;
+    bool cull = primitive_vertices > 0;
+    if(!cull)
+        primitive_vertices = num_vertices;
+
+    // only the primitives that can be seen are written
+    _sgp_region clip = _sgp_local_clip_region(thickness);
+    sgp_color_ub4 color = _sgp_state_color_ub4();
+    uint32_t written = 0, culled = 0;
+    for(uint32_t i=0;i+primitive_vertices<=num_vertices;i+=primitive_vertices) {
+        if(cull && _sgp_points_culled(clip, &vertices[i], primitive_vertices)) {
+            culled++;
+            continue;
+        }
+        if(SOKOL_UNLIKELY(written + primitive_vertices > max_vertices)) {
+            _sgp_set_error(SGP_ERROR_VERTICES_FULL);
+            return;
+        }
+        _sgp_vertex* v = &transformed_vertices[written];
+        for(uint32_t j=0;j<primitive_vertices;++j) {
+            v[j].position = vertices[i+j];
+            v[j].texcoord.x = 0.0f;
+            v[j].texcoord.y = 0.0f;
+            v[j].color = color;
+        }
+        written += primitive_vertices;
+    }
+    _sgp.num_culled += culled;
+    if(written == 0) return;
+    _sgp.cur_vertex += written;
+    num_vertices = written;
 
-    sgp_mat2x3 mvp = _sgp.state.mvp; // copy to stack for more efficiency
+    // transform in place, the thickness is added once the bounds are known
     _sgp_region region = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
-    for(uint32_t i=0;i<num_vertices;++i) {
-        sgp_vec2 p = _sgp_mat3_vec2_mul(&mvp, &vertices[i]);
-        region.x1 = _sg_min(region.x1, p.x - thickness);
-        region.y1 = _sg_min(region.y1, p.y - thickness);
-        region.x2 = _sg_max(region.x2, p.x + thickness);
-        region.y2 = _sg_max(region.y2, p.y + thickness);
-        transformed_vertices[i].position = p;
-        transformed_vertices[i].texcoord.x = 0.0f;
-        transformed_vertices[i].texcoord.y = 0.0f;
-    }
+    _sgp_transform_vertices(&_sgp.state.mvp, transformed_vertices, num_vertices, &region);
+    region.x1 -= thickness;
+    region.y1 -= thickness;
+    region.x2 += thickness;
+    region.y2 += thickness;
     _sgp_queue_draw(pip, region, vertex_index, num_vertices);
 }
 
@@ -2556,7 +3113,8 @@ void sgp_clear(void) {
     SOKOL_ASSERT(_sgp.cur_state > 0);
 
     // setup vertices
-    uint32_t num_vertices = 6;
+    bool indexed = _sgp_indexed_quads();
+    uint32_t num_vertices = indexed ? 4 : 6;
     uint32_t vertex_index = _sgp.cur_vertex;
     _sgp_vertex* vertices = _sgp_next_vertices(num_vertices);
     if(SOKOL_UNLIKELY(!vertices)) return;
@@ -2570,18 +3128,21 @@ void sgp_clear(void) {
         {-1.0f,  1.0f}, // top left
     };
     const sgp_vec2 texcoord = {0.0f, 0.0f};
+    sgp_color_ub4 color = _sgp_state_color_ub4();
 
     // make a quad composed of 2 triangles
-    v[0].position = quad[0]; v[0].texcoord = texcoord;
-    v[1].position = quad[1]; v[1].texcoord = texcoord;
-    v[2].position = quad[2]; v[2].texcoord = texcoord;
-    v[3].position = quad[3]; v[3].texcoord = texcoord;
-    v[4].position = quad[0]; v[4].texcoord = texcoord;
-    v[5].position = quad[2]; v[5].texcoord = texcoord;
+    v[0].position = quad[0]; v[0].texcoord = texcoord; v[0].color = color;
+    v[1].position = quad[1]; v[1].texcoord = texcoord; v[1].color = color;
+    v[2].position = quad[2]; v[2].texcoord = texcoord; v[2].color = color;
+    v[3].position = quad[3]; v[3].texcoord = texcoord; v[3].color = color;
+    if(!indexed) {
+        v[4].position = quad[0]; v[4].texcoord = texcoord; v[4].color = color;
+        v[5].position = quad[2]; v[5].texcoord = texcoord; v[5].color = color;
+    }
 
     _sgp_region region = {-1.0f, -1.0f, 1.0f, 1.0f};
 
-    sg_pipeline pip = _sgp_lookup_pipeline(SG_PRIMITIVETYPE_TRIANGLES, SGP_BLENDMODE_NONE);
+    sg_pipeline pip = _sgp_lookup_rects_pipeline(indexed, SGP_BLENDMODE_NONE);
     _sgp_queue_draw(pip, region, vertex_index, num_vertices);
 }
 
@@ -2590,7 +3151,7 @@ void sgp_draw_points(const sgp_point* points, uint32_t count) {
     SOKOL_ASSERT(_sgp.cur_state > 0);
     if(SOKOL_UNLIKELY(count == 0)) return;
     sg_pipeline pip = _sgp_lookup_pipeline(SG_PRIMITIVETYPE_POINTS, _sgp.state.blend_mode);
-    _sgp_draw_solid_pip(pip, points, count, _sgp.state.thickness);
+    _sgp_draw_solid_pip(pip, points, count, 1, _sgp.state.thickness);
 }
 
 void sgp_draw_point(float x, float y) {
@@ -2605,7 +3166,7 @@ void sgp_draw_lines(const sgp_line* lines, uint32_t count) {
     SOKOL_ASSERT(_sgp.cur_state > 0);
     if(SOKOL_UNLIKELY(count == 0)) return;
     sg_pipeline pip = _sgp_lookup_pipeline(SG_PRIMITIVETYPE_LINES, _sgp.state.blend_mode);
-    _sgp_draw_solid_pip(pip, (const sgp_point*)lines, count*2, _sgp.state.thickness);
+    _sgp_draw_solid_pip(pip, (const sgp_point*)lines, count*2, 2, _sgp.state.thickness);
 }
 
 void sgp_draw_line(float ax, float ay, float bx, float by) {
@@ -2620,7 +3181,7 @@ void sgp_draw_lines_strip(const sgp_point* points, uint32_t count) {
     SOKOL_ASSERT(_sgp.cur_state > 0);
     if(SOKOL_UNLIKELY(count == 0)) return;
     sg_pipeline pip = _sgp_lookup_pipeline(SG_PRIMITIVETYPE_LINE_STRIP, _sgp.state.blend_mode);
-    _sgp_draw_solid_pip(pip, points, count, _sgp.state.thickness);
+    _sgp_draw_solid_pip(pip, points, count, 0, _sgp.state.thickness);
 }
 
 void sgp_draw_filled_triangles(const sgp_triangle* triangles, uint32_t count) {
@@ -2628,7 +3189,7 @@ void sgp_draw_filled_triangles(const sgp_triangle* triangles, uint32_t count) {
     SOKOL_ASSERT(_sgp.cur_state > 0);
     if(SOKOL_UNLIKELY(count == 0)) return;
     sg_pipeline pip = _sgp_lookup_pipeline(SG_PRIMITIVETYPE_TRIANGLES, _sgp.state.blend_mode);
-    _sgp_draw_solid_pip(pip, (const sgp_point*)triangles, count*3, 0.0f);
+    _sgp_draw_solid_pip(pip, (const sgp_point*)triangles, count*3, 3, 0.0f);
 }
 
 void sgp_draw_filled_triangle(float ax, float ay, float bx, float by, float cx, float cy) {
@@ -2643,7 +3204,7 @@ void sgp_draw_filled_triangles_strip(const sgp_point* points, uint32_t count) {
     SOKOL_ASSERT(_sgp.cur_state > 0);
     if(SOKOL_UNLIKELY(count == 0)) return;
     sg_pipeline pip = _sgp_lookup_pipeline(SG_PRIMITIVETYPE_TRIANGLE_STRIP, _sgp.state.blend_mode);
-    _sgp_draw_solid_pip(pip, points, count, 0.0f);
+    _sgp_draw_solid_pip(pip, points, count, 0, 0.0f);
 }
 
 void sgp_draw_filled_rects(const sgp_rect* rects, uint32_t count) {
@@ -2652,31 +3213,33 @@ void sgp_draw_filled_rects(const sgp_rect* rects, uint32_t count) {
     if(SOKOL_UNLIKELY(count == 0)) return;
 
     // setup vertices
-    uint32_t num_vertices = count * 6;
+    bool indexed = _sgp_indexed_quads();
+    uint32_t quad_vertices = indexed ? 4 : 6;
     uint32_t vertex_index = _sgp.cur_vertex;
-    _sgp_vertex* vertices = _sgp_next_vertices(num_vertices);
-    if(SOKOL_UNLIKELY(!vertices)) return;
+    _sgp_vertex* vertices = &_sgp.vertices[vertex_index];
+    uint32_t max_vertices = _sgp.num_vertices - vertex_index;
 
-    // compute vertices
-    _sgp_vertex* v = vertices;
+    // compute vertices of the rects that can be seen, untransformed
+    _sgp_region clip = _sgp_local_clip_region(0.0f);
+    uint32_t num_vertices = 0;
     const sgp_rect* rect = rects;
-    sgp_mat2x3 mvp = _sgp.state.mvp; // copy to stack for more efficiency
-    _sgp_region region = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
-    for(uint32_t i=0;i<count;v+=6, rect++, i++) {
+    sgp_color_ub4 color = _sgp_state_color_ub4();
+    for(uint32_t i=0;i<count;rect++, i++) {
+        if(_sgp_rect_culled(clip, rect))
+            continue;
+        if(SOKOL_UNLIKELY(num_vertices + quad_vertices > max_vertices)) {
+            _sgp_set_error(SGP_ERROR_VERTICES_FULL);
+            return;
+        }
+        _sgp_vertex* v = &vertices[num_vertices];
+        num_vertices += quad_vertices;
+
         sgp_vec2 quad[4] = {
             {rect->x,           rect->y + rect->h}, // bottom left
             {rect->x + rect->w, rect->y + rect->h}, // bottom right
             {rect->x + rect->w, rect->y}, // top right
             {rect->x,  rect->y}, // top left
         };
-        _sgp_transform_vec2(&mvp, quad, quad, 4);
-
-        for(uint32_t j=0;j<4;++j) {
-            region.x1 = _sg_min(region.x1, quad[j].x);
-            region.y1 = _sg_min(region.y1, quad[j].y);
-            region.x2 = _sg_max(region.x2, quad[j].x);
-            region.y2 = _sg_max(region.y2, quad[j].y);
-        }
 
         const sgp_vec2 vtexquad[4] = {
             {0.0f, 1.0f}, // bottom left
@@ -2686,15 +3249,24 @@ void sgp_draw_filled_rects(const sgp_rect* rects, uint32_t count) {
         };
 
         // make a quad composed of 2 triangles
-        v[0].position = quad[0]; v[0].texcoord = vtexquad[0];
-        v[1].position = quad[1]; v[1].texcoord = vtexquad[1];
-        v[2].position = quad[2]; v[2].texcoord = vtexquad[2];
-        v[3].position = quad[3]; v[3].texcoord = vtexquad[3];
-        v[4].position = quad[0]; v[4].texcoord = vtexquad[0];
-        v[5].position = quad[2]; v[5].texcoord = vtexquad[2];
+        v[0].position = quad[0]; v[0].texcoord = vtexquad[0]; v[0].color = color;
+        v[1].position = quad[1]; v[1].texcoord = vtexquad[1]; v[1].color = color;
+        v[2].position = quad[2]; v[2].texcoord = vtexquad[2]; v[2].color = color;
+        v[3].position = quad[3]; v[3].texcoord = vtexquad[3]; v[3].color = color;
+        if(!indexed) {
+            v[4].position = quad[0]; v[4].texcoord = vtexquad[0]; v[4].color = color;
+            v[5].position = quad[2]; v[5].texcoord = vtexquad[2]; v[5].color = color;
+        }
     }
+    _sgp.num_culled += count - num_vertices/quad_vertices;
+    if(num_vertices == 0) return;
+    _sgp.cur_vertex += num_vertices;
 
-    sg_pipeline pip = _sgp_lookup_pipeline(SG_PRIMITIVETYPE_TRIANGLES, _sgp.state.blend_mode);
+    // transform them all in place and bound them in one pass
+    _sgp_region region = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+    _sgp_transform_vertices(&_sgp.state.mvp, vertices, num_vertices, &region);
+
+    sg_pipeline pip = _sgp_lookup_rects_pipeline(indexed, _sgp.state.blend_mode);
     _sgp_queue_draw(pip, region, vertex_index, num_vertices);
 }
 
@@ -2720,46 +3292,38 @@ void sgp_draw_textured_rects(int channel, const sgp_textured_rect* rects, uint32
     if(SOKOL_UNLIKELY(count == 0 || image.id == SG_INVALID_ID)) return;
 
     // setup vertices
-    uint32_t num_vertices = count * 6;
+    bool indexed = _sgp_indexed_quads();
+    uint32_t quad_vertices = indexed ? 4 : 6;
     uint32_t vertex_index = _sgp.cur_vertex;
-    _sgp_vertex* vertices = _sgp_next_vertices(num_vertices);
-    if(SOKOL_UNLIKELY(!vertices)) return;
+    _sgp_vertex* vertices = &_sgp.vertices[vertex_index];
+    uint32_t max_vertices = _sgp.num_vertices - vertex_index;
 
     // compute image values used for texture coords transform
     sgp_isize image_size = _sgp_query_image_size(image);
     if(SOKOL_UNLIKELY(image_size.w == 0 || image_size.h == 0)) return;
     float iw = 1.0f/(float)image_size.w, ih = 1.0f/(float)image_size.h;
 
-    // compute vertices
-    sgp_mat2x3 mvp = _sgp.state.mvp; // copy to stack for more efficiency
-    _sgp_region region = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+    // compute vertices of the rects that can be seen, untransformed
+    _sgp_region clip = _sgp_local_clip_region(0.0f);
+    uint32_t num_vertices = 0;
+    sgp_color_ub4 color = _sgp_state_color_ub4();
     for(uint32_t i=0;i<count;i++) {
+        if(_sgp_rect_culled(clip, &rects[i].dst))
+            continue;
+        if(SOKOL_UNLIKELY(num_vertices + quad_vertices > max_vertices)) {
+            _sgp_set_error(SGP_ERROR_VERTICES_FULL);
+            return;
+        }
+        _sgp_vertex* v = &vertices[num_vertices];
+        num_vertices += quad_vertices;
+
         sgp_vec2 quad[4] = {
             {rects[i].dst.x,                  rects[i].dst.y + rects[i].dst.h}, // bottom left
             {rects[i].dst.x + rects[i].dst.w, rects[i].dst.y + rects[i].dst.h}, // bottom right
             {rects[i].dst.x + rects[i].dst.w, rects[i].dst.y}, // top right
             {rects[i].dst.x,  rects[i].dst.y}, // top left
         };
-        _sgp_transform_vec2(&mvp, quad, quad, 4);
 
-        for(uint32_t j=0;j<4;++j) {
-            region.x1 = _sg_min(region.x1, quad[j].x);
-            region.y1 = _sg_min(region.y1, quad[j].y);
-            region.x2 = _sg_max(region.x2, quad[j].x);
-            region.y2 = _sg_max(region.y2, quad[j].y);
-        }
-
-        _sgp_vertex* v = &vertices[i*6];
-        v[0].position = quad[0];
-        v[1].position = quad[1];
-        v[2].position = quad[2];
-        v[3].position = quad[3];
-        v[4].position = quad[0];
-        v[5].position = quad[2];
-    }
-
-    // compute texture coords
-    for(uint32_t i=0;i<count;i++) {
         // compute source rect
         float tl = rects[i].src.x*iw;
         float tt = rects[i].src.y*ih;
@@ -2773,16 +3337,24 @@ void sgp_draw_textured_rects(int channel, const sgp_textured_rect* rects, uint32
         };
 
         // make a quad composed of 2 triangles
-        _sgp_vertex* v = &vertices[i*6];
-        v[0].texcoord = vtexquad[0];
-        v[1].texcoord = vtexquad[1];
-        v[2].texcoord = vtexquad[2];
-        v[3].texcoord = vtexquad[3];
-        v[4].texcoord = vtexquad[0];
-        v[5].texcoord = vtexquad[2];
+        v[0].position = quad[0]; v[0].texcoord = vtexquad[0]; v[0].color = color;
+        v[1].position = quad[1]; v[1].texcoord = vtexquad[1]; v[1].color = color;
+        v[2].position = quad[2]; v[2].texcoord = vtexquad[2]; v[2].color = color;
+        v[3].position = quad[3]; v[3].texcoord = vtexquad[3]; v[3].color = color;
+        if(!indexed) {
+            v[4].position = quad[0]; v[4].texcoord = vtexquad[0]; v[4].color = color;
+            v[5].position = quad[2]; v[5].texcoord = vtexquad[2]; v[5].color = color;
+        }
     }
+    _sgp.num_culled += count - num_vertices/quad_vertices;
+    if(num_vertices == 0) return;
+    _sgp.cur_vertex += num_vertices;
 
-    sg_pipeline pip = _sgp_lookup_pipeline(SG_PRIMITIVETYPE_TRIANGLES, _sgp.state.blend_mode);
+    // transform them all in place and bound them in one pass
+    _sgp_region region = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+    _sgp_transform_vertices(&_sgp.state.mvp, vertices, num_vertices, &region);
+
+    sg_pipeline pip = _sgp_lookup_rects_pipeline(indexed, _sgp.state.blend_mode);
     _sgp_queue_draw(pip, region, vertex_index, num_vertices);
 }
 
@@ -2793,6 +3365,19 @@ void sgp_draw_textured_rect(int channel, sgp_rect dest_rect, sgp_rect src_rect)
     sgp_draw_textured_rects(channel, &rect, 1);
 }
 
+void sgp_draw_callback(sgp_callback callback, void* user_data) {
+    SOKOL_ASSERT(_sgp.init_cookie == _SGP_INIT_COOKIE);
+    SOKOL_ASSERT(_sgp.cur_state > 0);
+    SOKOL_ASSERT(callback);
+    // also keeps the batch optimizer from merging across it, it stops at anything but a draw
+    _sgp_command* cmd = _sgp_next_command();
+    if(SOKOL_UNLIKELY(!cmd)) return;
+    memset(cmd, 0, sizeof(_sgp_command));
+    cmd->cmd = SGP_COMMAND_CALLBACK;
+    cmd->args.callback.func = callback;
+    cmd->args.callback.user_data = user_data;
+}
+
 sgp_desc sgp_query_desc(void) {
     return _sgp.desc;
 }
@@ -2801,6 +3386,16 @@ sgp_state* sgp_query_state(void) {
     return &_sgp.state;
 }
 
+const char* sgp_query_transform_kernel(void) {
+    SOKOL_ASSERT(_sgp.init_cookie == _SGP_INIT_COOKIE);
+    return _sgp.transform.name;
+}
+
+uint32_t sgp_query_culled(void) {
+    SOKOL_ASSERT(_sgp.init_cookie == _SGP_INIT_COOKIE);
+    return _sgp.num_culled;
+}
+
 #endif // SOKOL_GP_IMPL_INCLUDED
 #endif // SOKOL_GP_IMPL
 
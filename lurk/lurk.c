@@ -40,13 +40,17 @@
 #if defined(LURK_WINDOW)
 #include "dirent_win32.h"
 #endif
+#if defined(LURK_POSIX)
+#include <pthread.h>
+#endif
 
 #if !defined(LURK_SCENE)
 static lurkTexture* NewTexture(sg_image_desc *desc) {
-    lurkTexture *result = malloc(sizeof(lurkTexture));
+    lurkTexture *result = calloc(1, sizeof(lurkTexture));
     result->internal = sg_make_image(desc);
     result->w = desc->width;
     result->h = desc->height;
+    state.textureMemory += result->w * result->h * 4;
     return result;
 }
 
@@ -60,12 +64,86 @@ static lurkTexture* EmptyTexture(unsigned int w, unsigned int h) {
     return NewTexture(&desc);
 }
 
+static void DestroyRenderTarget(lurkRenderTarget *target);
+
 static void DestroyTexture(lurkTexture *texture) {
-    if (texture) {
+    if (!texture)
+        return;
+    if (texture->target) {
+        DestroyRenderTarget(texture->target);
+        free(texture->target);
+    } else {
+        state.textureMemory -= texture->w * texture->h * 4;
         if (sg_query_image_state(texture->internal) == SG_RESOURCESTATE_VALID)
             sg_destroy_image(texture->internal);
-        free(texture);
     }
+    free(texture);
+}
+
+static void MakeRenderTarget(lurkRenderTarget *target, int w, int h) {
+    sg_desc desc = sg_query_desc();
+    int samples = desc.context.sample_count > 1 ? desc.context.sample_count : 1;
+    sg_image_desc image = {
+        .render_target = true,
+        .width = w,
+        .height = h,
+        .pixel_format = desc.context.color_format,
+        .sample_count = samples
+    };
+    memset(target, 0, sizeof(lurkRenderTarget));
+    target->w = w;
+    target->h = h;
+    target->color = sg_make_image(&image);
+    target->memory = (size_t)w * h * 4 * samples;
+    if (samples > 1) {
+        image.sample_count = 1;
+        target->resolve = sg_make_image(&image);
+        target->memory += (size_t)w * h * 4;
+    }
+    if (desc.context.depth_format != SG_PIXELFORMAT_NONE) {
+        image.pixel_format = desc.context.depth_format;
+        image.sample_count = samples;
+        target->depth = sg_make_image(&image);
+        target->memory += (size_t)w * h * 4 * samples;
+    }
+    target->pass = sg_make_pass(&(sg_pass_desc) {
+        .color_attachments[0].image = target->color,
+        .resolve_attachments[0].image = target->resolve,
+        .depth_stencil_attachment.image = target->depth
+    });
+    state.textureMemory += target->memory;
+}
+
+static void DestroyRenderTarget(lurkRenderTarget *target) {
+    if (!target->w)
+        return;
+    sg_destroy_pass(target->pass);
+    sg_destroy_image(target->color);
+    if (target->resolve.id != SG_INVALID_ID)
+        sg_destroy_image(target->resolve);
+    if (target->depth.id != SG_INVALID_ID)
+        sg_destroy_image(target->depth);
+    state.textureMemory -= target->memory;
+    memset(target, 0, sizeof(lurkRenderTarget));
+}
+
+// The image to sample once the pass is done
+static sg_image RenderTargetImage(lurkRenderTarget *target) {
+    return target->resolve.id != SG_INVALID_ID ? target->resolve : target->color;
+}
+
+#if !defined(LURK_HEADLESS)
+// Draws `w`x`h` pixels from the top left of the target into `dst`. Render
+// targets are upside down when the backend's origin is bottom left (GL).
+static void DrawRenderTarget(lurkRenderTarget *target, int w, int h, sgp_rect dst) {
+    sgp_rect src = {0.f, 0.f, (float)w, (float)h};
+    if (!sg_query_features().origin_top_left) {
+        src.y = (float)target->h;
+        src.h = -src.h;
+    }
+    sgp_set_image(0, RenderTargetImage(target));
+    sgp_draw_textured_rect(0, dst, src);
+    sgp_reset_image(0);
 }
 
 #define QOI_MAGIC (((unsigned int)'q') << 24 | ((unsigned int)'o') << 16 | ((unsigned int)'i') <<  8 | ((unsigned int)'f'))
@@ -102,6 +180,7 @@ static int* LoadImage(unsigned char *data, int sizeOfData, int *w, int *h) {
         *h = _h;
     return buf;
 }
+#endif
 
 static void UpdateTexture(lurkTexture *texture, int *data, int w, int h) {
     if (texture->w != w || texture->h != h) {
@@ -119,12 +198,10 @@ static void UpdateTexture(lurkTexture *texture, int *data, int w, int h) {
 
 lurkState state = {
     .running = false,
-    .desc = (sapp_desc) {
 #define X(NAME, TYPE, VAL, DEFAULT, DOCS) .VAL = DEFAULT,
-        SETTINGS
+    SETTINGS
 #undef X
-        .window_title = DEFAULT_WINDOW_TITLE
-    },
+    .desc.window_title = DEFAULT_WINDOW_TITLE,
     .pass_action = {
         .colors[0] = {
             .load_action = SG_LOADACTION_CLEAR,
@@ -220,938 +297,1771 @@ static void MM86128(const void *key, const int len, uint32_t seed, void *out) {
 }
 
 static uint64_t MurmurHash(const void *data, size_t len, uint32_t seed) {
-    char out[16];
-    MM86128(data, (int)len, (uint32_t)seed, &out);
-    return *(uint64_t*)out;
-}
+    uint32_t out[4];
+    MM86128(data, (int)len, (uint32_t)seed, out);
+    uint64_t hash;
+    memcpy(&hash, out, sizeof(hash));
+    return hash;
+}
+
+// Every command is declared once here, everything else (the command type enum,
+// the payload structs, the public recorder functions and the replay dispatch
+// table) is generated from this list. Columns are:
+//   X(NAME, RECORDER, PARAMS, VALUES, FIELDS, REPLAY)
+// NAME     -- Command name, `lurk##NAME` is the public recorder function
+// RECORDER -- AUTO to generate the recorder, CUSTOM if it's written by hand
+// PARAMS   -- Recorder parameters (excluding the lurkState)
+// VALUES   -- Initializer for the payload struct, built from PARAMS
+// FIELDS   -- Payload struct fields
+// REPLAY   -- Replays the payload (as `data`) into sokol_gp
+// Array payloads are copied inline after the payload struct when recorded, the
+// array pointer is left NULL. The `NoCopy` recorders store the caller's pointer
+// instead, see LURK_PAYLOAD_ARRAY.
+#define LURK_COMMANDS                                                                                                                                        \
+    X(Project, AUTO, (float left, float right, float top, float bottom), (left, right, top, bottom),                                                         \
+      (float left; float right; float top; float bottom;), sgp_project(data->left, data->right, data->top, data->bottom))                                    \
+    X(ResetProject, AUTO, (), (), (), sgp_reset_project())                                                                                                   \
+    X(PushTransform, AUTO, (), (), (), sgp_push_transform())                                                                                                 \
+    X(PopTransform, AUTO, (), (), (), sgp_pop_transform())                                                                                                   \
+    X(ResetTransform, AUTO, (), (), (), sgp_reset_transform())                                                                                               \
+    X(Translate, AUTO, (float x, float y), (x, y), (float x; float y;), sgp_translate(data->x, data->y))                                                     \
+    X(Rotate, AUTO, (float theta), (theta), (float theta;), sgp_rotate(data->theta))                                                                         \
+    X(RotateAt, AUTO, (float theta, float x, float y), (theta, x, y), (float theta; float x; float y;),                                                      \
+      sgp_rotate_at(data->theta, data->x, data->y))                                                                                                          \
+    X(Scale, AUTO, (float sx, float sy), (sx, sy), (float sx; float sy;), sgp_scale(data->sx, data->sy))                                                     \
+    X(ScaleAt, AUTO, (float sx, float sy, float x, float y), (sx, sy, x, y), (float sx; float sy; float x; float y;),                                        \
+      sgp_scale_at(data->sx, data->sy, data->x, data->y))                                                                                                    \
+    X(MultiplyTransform, AUTO, (sgp_mat2x3 matrix), (matrix), (sgp_mat2x3 matrix;), MultiplyTransform(&data->matrix))                                        \
+    X(ResetPipeline, AUTO, (), (), (), sgp_reset_pipeline())                                                                                                 \
+    X(SetUniform, CUSTOM, (void* data, int size), (), (int size;), sgp_set_uniform(data + 1, data->size))                                                    \
+    X(ResetUniform, AUTO, (), (), (), sgp_reset_uniform())                                                                                                   \
+    X(SetBlendMode, AUTO, (sgp_blend_mode blend_mode), (blend_mode), (sgp_blend_mode blend_mode;), sgp_set_blend_mode(data->blend_mode))                     \
+    X(ResetBlendMode, AUTO, (), (), (), sgp_reset_blend_mode())                                                                                              \
+    X(SetColor, AUTO, (float r, float g, float b, float a), (r, g, b, a), (float r; float g; float b; float a;),                                             \
+      sgp_set_color(data->r, data->g, data->b, data->a))                                                                                                     \
+    X(ResetColor, AUTO, (), (), (), sgp_reset_color())                                                                                                       \
+    X(SetImage, CUSTOM, (uint64_t texture_id, int channel), (), (uint64_t texture; int channel; sg_image image;), sgp_set_image(data->channel, data->image)) \
+    X(UnsetImage, AUTO, (int channel), (channel), (int channel;), sgp_unset_image(data->channel))                                                            \
+    X(ResetImage, AUTO, (int channel), (channel), (int channel;), sgp_reset_image(data->channel))                                                            \
+    X(ResetSampler, AUTO, (int channel), (channel), (int channel;), sgp_reset_sampler(data->channel))                                                        \
+    X(Viewport, AUTO, (int x, int y, int w, int h), (x, y, w, h), (int x; int y; int w; int h;),                                                             \
+      sgp_viewport(data->x, data->y, data->w, data->h))                                                                                                      \
+    X(ResetViewport, AUTO, (), (), (), sgp_reset_viewport())                                                                                                 \
+    X(Scissor, AUTO, (int x, int y, int w, int h), (x, y, w, h), (int x; int y; int w; int h;),                                                              \
+      sgp_scissor(data->x, data->y, data->w, data->h))                                                                                                       \
+    X(ResetScissor, AUTO, (), (), (), sgp_reset_scissor())                                                                                                   \
+    X(ResetState, AUTO, (), (), (), sgp_reset_state())                                                                                                       \
+    X(SetLayer, AUTO, (int layer), (layer), (int layer;), SetLayer(data->layer))                                                                             \
+    X(Clear, AUTO, (), (), (), sgp_clear())                                                                                                                  \
+    X(DrawPoints, CUSTOM, (sgp_point* points, int count), (), (const sgp_point* points; int count;),                                                         \
+      sgp_draw_points(LURK_PAYLOAD_ARRAY(data, points), data->count))                                                                                        \
+    X(DrawPoint, AUTO, (float x, float y), (x, y), (float x; float y;), sgp_draw_point(data->x, data->y))                                                    \
+    X(DrawLines, CUSTOM, (sgp_line* lines, int count), (), (const sgp_line* lines; int count;),                                                              \
+      sgp_draw_lines(LURK_PAYLOAD_ARRAY(data, lines), data->count))                                                                                          \
+    X(DrawLine, AUTO, (float ax, float ay, float bx, float by), (ax, ay, bx, by), (float ax; float ay; float bx; float by;),                                 \
+      sgp_draw_line(data->ax, data->ay, data->bx, data->by))                                                                                                 \
+    X(DrawLinesStrip, CUSTOM, (sgp_point* points, int count), (), (const sgp_point* points; int count;),                                                     \
+      sgp_draw_lines_strip(LURK_PAYLOAD_ARRAY(data, points), data->count))                                                                                   \
+    X(DrawFilledTriangles, CUSTOM, (sgp_triangle* triangles, int count), (), (const sgp_triangle* triangles; int count;),                                    \
+      sgp_draw_filled_triangles(LURK_PAYLOAD_ARRAY(data, triangles), data->count))                                                                           \
+    X(DrawFilledTriangle, AUTO, (float ax, float ay, float bx, float by, float cx, float cy), (ax, ay, bx, by, cx, cy),                                      \
+      (float ax; float ay; float bx; float by; float cx; float cy;),                                                                                         \
+      sgp_draw_filled_triangle(data->ax, data->ay, data->bx, data->by, data->cx, data->cy))                                                                  \
+    X(DrawFilledTrianglesStrip, CUSTOM, (sgp_point* points, int count), (), (const sgp_point* points; int count;),                                           \
+      sgp_draw_filled_triangles_strip(LURK_PAYLOAD_ARRAY(data, points), data->count))                                                                        \
+    X(DrawFilledRects, CUSTOM, (sgp_rect* rects, int count), (), (const sgp_rect* rects; int count;),                                                        \
+      sgp_draw_filled_rects(LURK_PAYLOAD_ARRAY(data, rects), data->count))                                                                                   \
+    X(DrawFilledRect, AUTO, (float x, float y, float w, float h), (x, y, w, h), (float x; float y; float w; float h;),                                       \
+      sgp_draw_filled_rect(data->x, data->y, data->w, data->h))                                                                                              \
+    X(DrawTexturedRects, CUSTOM, (int channel, sgp_textured_rect* rects, int count), (),                                                                     \
+      (int channel; const sgp_textured_rect* rects; int count;),                                                                                             \
+      sgp_draw_textured_rects(data->channel, LURK_PAYLOAD_ARRAY(data, rects), data->count))                                                                  \
+    X(DrawTexturedRect, AUTO, (int channel, sgp_rect dest_rect, sgp_rect src_rect), (channel, dest_rect, src_rect),                                          \
+      (int channel; sgp_rect dest_rect; sgp_rect src_rect;), sgp_draw_textured_rect(data->channel, data->dest_rect, data->src_rect))                         \
+    X(CallCommandList, CUSTOM, (lurkCommandList *list), (), (const lurkCommandList *list; bool transformed; sgp_mat2x3 transform;),                          \
+      CallCommandList(data))                                                                                                                                 \
+    X(CreateTexture, AUTO, (const char *name, ezImage *image), (MurmurHash((void*)name, strlen(name), 0), image),                                            \
+      (uint64_t id; ezImage *image;), CreateTexture(data))                                                                                                   \
+    X(CreateRenderTarget, AUTO, (const char *name, int w, int h), (MurmurHash((void*)name, strlen(name), 0), w, h),                                          \
+      (uint64_t id; int w; int h;), CreateRenderTarget(data))                                                                                                \
+    X(BeginRenderTarget, CUSTOM, (uint64_t target_id), (), (uint64_t target; int w; int h;), BeginRenderTarget(data))                                        \
+    X(EndRenderTarget, AUTO, (), (), (), EndRenderTarget())                                                                                                  \
+    X(DrawSpriteBatch, CUSTOM, (lurkSpriteBatch *batch), (), (const lurkSpriteBatch *batch; int count;), DrawSpriteBatch(data))
+
+#define LURK_UNPAREN(...) __VA_ARGS__
+#define LURK_PAYLOAD_ARRAY(DATA, FIELD) ((DATA)->FIELD ? (DATA)->FIELD : (const void*)((DATA) + 1))
+#define LURK_RECORDER_PARAMS(...) (lurkState *state, ##__VA_ARGS__)
 
 typedef enum {
-    lurkCommandProject,
-    lurkCommandResetProject,
-    lurkCommandPushTransform,
-    lurkCommandPopTransform,
-    lurkCommandResetTransform,
-    lurkCommandTranslate,
-    lurkCommandRotate,
-    lurkCommandRotateAt,
-    lurkCommandScale,
-    lurkCommandScaleAt,
-    lurkCommandResetPipeline,
-    lurkCommandSetUniform,
-    lurkCommandResetUniform,
-    lurkCommandSetBlendMode,
-    lurkCommandResetBlendMode,
-    lurkCommandSetColor,
-    lurkCommandResetColor,
-    lurkCommandSetImage,
-    lurkCommandUnsetImage,
-    lurkCommandResetImage,
-    lurkCommandResetSampler,
-    lurkCommandViewport,
-    lurkCommandResetViewport,
-    lurkCommandScissor,
-    lurkCommandResetScissor,
-    lurkCommandResetState,
-    lurkCommandClear,
-    lurkCommandDrawPoints,
-    lurkCommandDrawPoint,
-    lurkCommandDrawLines,
-    lurkCommandDrawLine,
-    lurkCommandDrawLinesStrip,
-    lurkCommandDrawFilledTriangles,
-    lurkCommandDrawFilledTriangle,
-    lurkCommandDrawFilledTrianglesStrip,
-    lurkCommandDrawFilledRects,
-    lurkCommandDrawFilledRect,
-    lurkCommandDrawTexturedRects,
-    lurkCommandDrawTexturedRect,
-    lurkCommandCreateTexture
+#define X(NAME, RECORDER, PARAMS, VALUES, FIELDS, REPLAY) lurkCommand##NAME,
+    LURK_COMMANDS
+#undef X
+    lurkCommandCount
 } lurkCommandType;
 
+#define X(NAME, RECORDER, PARAMS, VALUES, FIELDS, REPLAY) \
+    typedef struct {                                      \
+        LURK_UNPAREN FIELDS                               \
+    } lurk##NAME##Data;
+LURK_COMMANDS
+#undef X
+
+// Commands are bump-allocated into `state->commandBuffer` as a header followed
+// directly by their payload. `size` is the total size of the entry (header +
+// padded payload), so walking the buffer is just `offset += command->size`.
 typedef struct {
-    lurkCommandType type;
-    void* data;
+    uint32_t type;
+    uint32_t size;
 } lurkCommand;
 
-static void PushCommand(lurkState* state, lurkCommand* command) {
-    ezStackAppend(&state->commandQueue, command->type, (void*)command);
-}
-
-typedef struct {
-    float left;
-    float right;
-    float top;
-    float bottom;
-} lurkProjectData;
+#define LURK_COMMAND_ALIGN(SIZE) (((SIZE) + 7) & ~(size_t)7)
 
-void lurkProject(lurkState *state, float left, float right, float top, float bottom) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandProject;
-    lurkProjectData* cmdData = malloc(sizeof(lurkProjectData));
-    cmdData->left = left;
-    cmdData->right = right;
-    cmdData->top = top;
-    cmdData->bottom = bottom;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+static void* CommandData(lurkCommand *command) {
+    return (void*)(command + 1);
 }
 
-void lurkResetProject(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetProject;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+static void GrowCommandBuffer(lurkCommandBuffer *buffer, size_t size) {
+    size_t capacity = buffer->capacity ? buffer->capacity : DEFAULT_COMMAND_BUFFER_SIZE;
+    while (buffer->size + size > capacity)
+        capacity *= 2;
+    buffer->data = realloc(buffer->data, capacity);
+    assert(buffer->data);
+    buffer->capacity = capacity;
 }
 
-void lurkPushTransform(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandPushTransform;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
-}
+// Command buffer the calling thread is recording into, NULL for the frame
+static __thread lurkCommandBuffer *recordTarget = NULL;
+// In immediate mode frame commands are built here one at a time and handed
+// straight to the host's replay table by CommitCommand
+static __thread lurkCommandBuffer immediateBuffer = {0};
+static __thread int immediateType = -1;
 
-void lurkPopTransform(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandPopTransform;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+// Reserves space for a command + its payload and returns the payload to fill
+static void* PushCommand(lurkState *state, lurkCommandType type, size_t size) {
+    if (!recordTarget && state->immediate) {
+        immediateBuffer.size = 0;
+        if (size > immediateBuffer.capacity)
+            GrowCommandBuffer(&immediateBuffer, size);
+        immediateType = type;
+        return immediateBuffer.data;
+    }
+    lurkCommandBuffer *buffer = recordTarget ? recordTarget : &state->commandBuffer;
+    size_t total = sizeof(lurkCommand) + LURK_COMMAND_ALIGN(size);
+    if (buffer->size + total > buffer->capacity)
+        GrowCommandBuffer(buffer, total);
+    lurkCommand *command = (lurkCommand*)(buffer->data + buffer->size);
+    command->type = type;
+    command->size = (uint32_t)total;
+    buffer->size += total;
+    buffer->count++;
+    return CommandData(command);
 }
 
-void lurkResetTransform(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetTransform;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+// Every recorder calls this once its payload is filled in
+static void CommitCommand(lurkState *state) {
+    if (immediateType >= 0) {
+        state->immediate[immediateType](immediateBuffer.data);
+        immediateType = -1;
+    }
 }
 
-typedef struct {
-    float x;
-    float y;
-} lurkTranslateData;
-
-void lurkTranslate(lurkState *state, float x, float y) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandTranslate;
-    lurkTranslateData* cmdData = malloc(sizeof(lurkTranslateData));
-    cmdData->x = x;
-    cmdData->y = y;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+void lurkBeginCommandBuffer(lurkState *state, lurkCommandBuffer *buffer) {
+    assert(!recordTarget && !__atomic_load_n(&buffer->pending, __ATOMIC_ACQUIRE));
+    recordTarget = buffer;
 }
 
-typedef struct {
-    float theta;
-} lurkRotateData;
-
-void lurkRotate(lurkState *state, float theta) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandRotate;
-    lurkRotateData* cmdData = malloc(sizeof(lurkRotateData));
-    cmdData->theta = theta;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+void lurkEndCommandBuffer(lurkState *state) {
+    assert(recordTarget);
+    recordTarget = NULL;
 }
 
-typedef struct {
-    float theta;
-    float x;
-    float y;
-} lurkRotateAtData;
-
-void lurkRotateAt(lurkState *state, float theta, float x, float y) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandRotateAt;
-    lurkRotateAtData* cmdData = malloc(sizeof(lurkRotateAtData));
-    cmdData->theta = theta;
-    cmdData->x = x;
-    cmdData->y = y;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+void lurkSubmitCommandBuffer(lurkState *state, lurkCommandBuffer *buffer, int key) {
+    assert(buffer != recordTarget && !buffer->pending && !buffer->retained);
+    buffer->key = key;
+    buffer->pending = true;
+    // Pushed onto a list in lurkState rather than the frame buffer, which is
+    // copied when the buffers are swapped
+    buffer->next = __atomic_load_n(&state->submitted, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&state->submitted, &buffer->next, buffer, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
 }
 
-typedef struct {
-    float sx;
-    float sy;
-} lurkScaleData;
-
-void lurkScale(lurkState *state, float sx, float sy) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandScale;
-    lurkScaleData* cmdData = malloc(sizeof(lurkScaleData));
-    cmdData->sx = sx;
-    cmdData->sy = sy;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+void lurkFreeCommandBuffer(lurkCommandBuffer *buffer) {
+    assert(!buffer->pending);
+    if (buffer->data)
+        free(buffer->data);
+    memset(buffer, 0, sizeof(lurkCommandBuffer));
 }
 
-typedef struct {
-    float sx;
-    float sy;
-    float x;
-    float y;
-} lurkScaleAtData;
-
-void lurkScaleAt(lurkState *state, float sx, float sy, float x, float y) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandScaleAt;
-    lurkScaleAtData* cmdData = malloc(sizeof(lurkScaleAtData));
-    cmdData->sx = sx;
-    cmdData->sy = sy;
-    cmdData->x = x;
-    cmdData->y = y;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
-}
-
-void lurkResetPipeline(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetPipeline;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+void lurkBeginCommandList(lurkState *state, lurkCommandList *list) {
+    assert(!recordTarget);
+    list->size = 0;
+    list->count = 0;
+    list->retained = true;
+    recordTarget = list;
 }
 
-typedef struct {
-    void* data;
-    int size;
-} lurkSetUniformData;
-
-void lurkSetUniform(lurkState *state, void* data, int size) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandSetUniform;
-    lurkSetUniformData* cmdData = malloc(sizeof(lurkSetUniformData));
-    cmdData->data = data;
-    cmdData->size = size;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+void lurkEndCommandList(lurkState *state) {
+    assert(recordTarget && recordTarget->retained);
+    lurkCommandList *list = recordTarget;
+    // Lists live for a long time, don't keep the slack from growing
+    if (list->size && list->size < list->capacity) {
+        list->data = realloc(list->data, list->size);
+        list->capacity = list->size;
+    }
+    recordTarget = NULL;
 }
 
-void lurkResetUniform(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetUniform;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+void lurkCallCommandList(lurkState *state, lurkCommandList *list) {
+    assert(list->retained && list != recordTarget);
+    lurkCallCommandListData *cmdData = PushCommand(state, lurkCommandCallCommandList, sizeof(lurkCallCommandListData));
+    cmdData->list = list;
+    cmdData->transformed = false;
+    CommitCommand(state);
 }
 
-typedef struct {
-    sgp_blend_mode blend_mode;
-} lurkSetBlendModeData;
-
-void lurkSetBlendMode(lurkState *state, sgp_blend_mode blend_mode) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandSetBlendMode;
-    lurkSetBlendModeData* cmdData = malloc(sizeof(lurkSetBlendModeData));
-    cmdData->blend_mode = blend_mode;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+void lurkCallCommandListTransformed(lurkState *state, lurkCommandList *list, sgp_mat2x3 transform) {
+    assert(list->retained && list != recordTarget);
+    lurkCallCommandListData *cmdData = PushCommand(state, lurkCommandCallCommandList, sizeof(lurkCallCommandListData));
+    cmdData->list = list;
+    cmdData->transformed = true;
+    cmdData->transform = transform;
+    CommitCommand(state);
 }
 
-void lurkResetBlendMode(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetBlendMode;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+void lurkFreeCommandList(lurkCommandList *list) {
+    lurkFreeCommandBuffer(list);
 }
 
-typedef struct {
-    float r;
-    float g;
-    float b;
-    float a;
-} lurkSetColorData;
-
-void lurkSetColor(lurkState *state, float r, float g, float b, float a) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandSetColor;
-    lurkSetColorData* cmdData = malloc(sizeof(lurkSetColorData));
-    cmdData->r = r;
-    cmdData->g = g;
-    cmdData->b = b;
-    cmdData->a = a;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
-}
-
-void lurkResetColor(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetColor;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+// Lists keep their arrays, the caller's memory is long gone by the time they're replayed
+static bool RecordingList(void) {
+    return recordTarget && recordTarget->retained;
 }
 
-typedef struct {
-    int channel;
-    lurkTexture* texture;
-} lurkSetImageData;
+#define LURK_RECORDER_CUSTOM(NAME, PARAMS, VALUES)
+#define LURK_RECORDER_AUTO(NAME, PARAMS, VALUES)                           \
+    void lurk##NAME LURK_RECORDER_PARAMS PARAMS {                          \
+        lurk##NAME##Data *cmdData = PushCommand(state, lurkCommand##NAME,  \
+                                                sizeof(lurk##NAME##Data)); \
+        *cmdData = (lurk##NAME##Data) { LURK_UNPAREN VALUES };             \
+        CommitCommand(state);                                              \
+    }
+#define X(NAME, RECORDER, PARAMS, VALUES, FIELDS, REPLAY) LURK_RECORDER_##RECORDER(NAME, PARAMS, VALUES)
+LURK_COMMANDS
+#undef X
 
-void lurkSetImage(lurkState* state, uint64_t texture_id, int channel) {
+static lurkTexture* FindTexture(lurkState *state, uint64_t texture_id) {
     assert(texture_id);
     imap_slot_t* slot = imap_lookup(state->textureMap, texture_id);
     assert(slot);
     lurkTexture* texture = (lurkTexture*)imap_getval64(state->textureMap, slot);
     assert(texture);
+    return texture;
+}
 
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandSetImage;
-    lurkSetImageData* cmdData = malloc(sizeof(lurkSetImageData));
+void lurkSetImage(lurkState* state, uint64_t texture_id, int channel) {
+    lurkTexture* texture = FindTexture(state, texture_id);
+    lurkSetImageData *cmdData = PushCommand(state, lurkCommandSetImage, sizeof(lurkSetImageData));
+    cmdData->texture = texture_id;
     cmdData->channel = channel;
-    cmdData->texture = texture;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+    cmdData->image = texture->internal;
+    CommitCommand(state);
 }
 
-typedef struct {
-    int channel;
-} lurkUnsetImageData;
-
-void lurkUnsetImage(lurkState *state, int channel) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandUnsetImage;
-    lurkUnsetImageData* cmdData = malloc(sizeof(lurkUnsetImageData));
-    cmdData->channel = channel;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+void lurkBeginRenderTarget(lurkState *state, uint64_t target_id) {
+    lurkTexture *texture = FindTexture(state, target_id);
+    assert(texture->target);
+    texture->dirty = false;
+    lurkBeginRenderTargetData *cmdData = PushCommand(state, lurkCommandBeginRenderTarget, sizeof(lurkBeginRenderTargetData));
+    cmdData->target = target_id;
+    cmdData->w = texture->w;
+    cmdData->h = texture->h;
+    CommitCommand(state);
 }
 
-typedef struct {
-    int channel;
-} lurkResetImageData;
+bool lurkIsRenderTargetDirty(lurkState *state, uint64_t target_id) {
+    return FindTexture(state, target_id)->dirty;
+}
 
-void lurkResetImage(lurkState *state, int channel) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetImage;
-    lurkResetImageData* cmdData = malloc(sizeof(lurkResetImageData));
-    cmdData->channel = channel;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+void lurkInvalidateRenderTarget(lurkState *state, uint64_t target_id) {
+    FindTexture(state, target_id)->dirty = true;
 }
 
-typedef struct {
-    int channel;
-} lurkResetSamplerData;
+void lurkSetUniform(lurkState *state, void* data, int size) {
+    lurkSetUniformData *cmdData = PushCommand(state, lurkCommandSetUniform, sizeof(lurkSetUniformData) + size);
+    cmdData->size = size;
+    memcpy(cmdData + 1, data, size);
+    CommitCommand(state);
+}
+
+// Copy recorders take a snapshot of the array inside the command buffer, so the
+// caller's memory can be reused straight away. NoCopy recorders only keep the
+// pointer, which must stay valid until the end of the frame.
+#define LURK_ARRAY_RECORDERS(NAME, TYPE, FIELD)                                                   \
+    void lurk##NAME(lurkState *state, TYPE *FIELD, int count) {                                   \
+        lurk##NAME##Data *cmdData = PushCommand(state, lurkCommand##NAME,                         \
+                                                sizeof(lurk##NAME##Data) + count * sizeof(TYPE)); \
+        cmdData->FIELD = NULL;                                                                    \
+        cmdData->count = count;                                                                   \
+        memcpy(cmdData + 1, FIELD, count * sizeof(TYPE));                                         \
+        CommitCommand(state);                                                                     \
+    }                                                                                             \
+    void lurk##NAME##NoCopy(lurkState *state, TYPE *FIELD, int count) {                           \
+        if (RecordingList()) {                                                                    \
+            lurk##NAME(state, FIELD, count);                                                      \
+            return;                                                                               \
+        }                                                                                         \
+        lurk##NAME##Data *cmdData = PushCommand(state, lurkCommand##NAME,                         \
+                                                sizeof(lurk##NAME##Data));                        \
+        cmdData->FIELD = FIELD;                                                                   \
+        cmdData->count = count;                                                                   \
+        CommitCommand(state);                                                                     \
+    }
+LURK_ARRAY_RECORDERS(DrawPoints, sgp_point, points)
+LURK_ARRAY_RECORDERS(DrawLines, sgp_line, lines)
+LURK_ARRAY_RECORDERS(DrawLinesStrip, sgp_point, points)
+LURK_ARRAY_RECORDERS(DrawFilledTriangles, sgp_triangle, triangles)
+LURK_ARRAY_RECORDERS(DrawFilledTrianglesStrip, sgp_point, points)
+LURK_ARRAY_RECORDERS(DrawFilledRects, sgp_rect, rects)
 
-void lurkResetSampler(lurkState *state, int channel) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetSampler;
-    lurkResetSamplerData* cmdData = malloc(sizeof(lurkResetSamplerData));
+void lurkDrawTexturedRects(lurkState *state, int channel, sgp_textured_rect* rects, int count) {
+    lurkDrawTexturedRectsData *cmdData = PushCommand(state, lurkCommandDrawTexturedRects,
+                                                     sizeof(lurkDrawTexturedRectsData) + count * sizeof(sgp_textured_rect));
     cmdData->channel = channel;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+    cmdData->rects = NULL;
+    cmdData->count = count;
+    memcpy(cmdData + 1, rects, count * sizeof(sgp_textured_rect));
+    CommitCommand(state);
 }
 
-typedef struct {
-    int x;
-    int y;
-    int w;
-    int h;
-} lurkViewportData;
-
-void lurkViewport(lurkState *state, int x, int y, int w, int h) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandViewport;
-    lurkViewportData* cmdData = malloc(sizeof(lurkViewportData));
-    cmdData->x = x;
-    cmdData->y = y;
-    cmdData->w = w;
-    cmdData->h = h;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
-}
-
-void lurkResetViewport(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetViewport;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+void lurkDrawTexturedRectsNoCopy(lurkState *state, int channel, sgp_textured_rect* rects, int count) {
+    if (RecordingList()) {
+        lurkDrawTexturedRects(state, channel, rects, count);
+        return;
+    }
+    lurkDrawTexturedRectsData *cmdData = PushCommand(state, lurkCommandDrawTexturedRects, sizeof(lurkDrawTexturedRectsData));
+    cmdData->channel = channel;
+    cmdData->rects = rects;
+    cmdData->count = count;
+    CommitCommand(state);
+}
+
+// Every array in a lurkSpriteBatch, with the vertex format it's uploaded as
+// (layers are only used to order the sprites before they're uploaded)
+#define LURK_SPRITE_ARRAYS                        \
+    X(position, sgp_vec2, SG_VERTEXFORMAT_FLOAT2) \
+    X(scale, sgp_vec2, SG_VERTEXFORMAT_FLOAT2)    \
+    X(rotation, float, SG_VERTEXFORMAT_FLOAT)     \
+    X(src, sgp_rect, SG_VERTEXFORMAT_FLOAT4)      \
+    X(color, uint32_t, SG_VERTEXFORMAT_UBYTE4N)   \
+    X(layer, int, SG_VERTEXFORMAT_INVALID)
+
+// Batches copied into a command (in lists and captures) have their arrays
+// inline after the payload, one after another
+static size_t SpriteBatchSize(int count) {
+    size_t size = 0;
+#define X(FIELD, TYPE, FORMAT) size += count * sizeof(TYPE);
+    LURK_SPRITE_ARRAYS
+#undef X
+    return size;
 }
 
-typedef struct {
-    int x;
-    int y;
-    int w;
-    int h;
-} lurkScissorData;
+static void CopySpriteBatch(unsigned char *dst, const lurkSpriteBatch *batch) {
+#define X(FIELD, TYPE, FORMAT)                               \
+    memcpy(dst, batch->FIELD, batch->count * sizeof(TYPE)); \
+    dst += batch->count * sizeof(TYPE);
+    LURK_SPRITE_ARRAYS
+#undef X
+}
 
-void lurkScissor(lurkState *state, int x, int y, int w, int h) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandScissor;
-    lurkScissorData* cmdData = malloc(sizeof(lurkScissorData));
-    cmdData->x = x;
-    cmdData->y = y;
-    cmdData->w = w;
-    cmdData->h = h;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+int lurkAddSprites(lurkSpriteBatch *batch, int count) {
+    int first = batch->count;
+    if (first + count > batch->capacity) {
+        int capacity = batch->capacity ? batch->capacity : 256;
+        while (capacity < first + count)
+            capacity *= 2;
+#define X(FIELD, TYPE, FORMAT) batch->FIELD = realloc(batch->FIELD, capacity * sizeof(TYPE));
+        LURK_SPRITE_ARRAYS
+#undef X
+        batch->capacity = capacity;
+    }
+    for (int i = first; i < first + count; i++) {
+        batch->scale[i] = (sgp_vec2){1.f, 1.f};
+        batch->rotation[i] = 0.f;
+        batch->color[i] = LURK_SPRITE_COLOR(255, 255, 255, 255);
+        batch->layer[i] = 0;
+    }
+    batch->count += count;
+    return first;
 }
 
-void lurkResetScissor(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetScissor;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+void lurkClearSpriteBatch(lurkSpriteBatch *batch) {
+    batch->count = 0;
 }
 
-void lurkResetState(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandResetState;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+void lurkFreeSpriteBatch(lurkSpriteBatch *batch) {
+#define X(FIELD, TYPE, FORMAT) free(batch->FIELD);
+    LURK_SPRITE_ARRAYS
+#undef X
+    memset(batch, 0, sizeof(lurkSpriteBatch));
 }
 
-void lurkClear(lurkState *state) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandClear;
-    cmd->data = NULL;
-    PushCommand(state, cmd);
+void lurkDrawSpriteBatch(lurkState *state, lurkSpriteBatch *batch) {
+    if (!batch->count)
+        return;
+    if (RecordingList()) {
+        lurkDrawSpriteBatchData *cmdData = PushCommand(state, lurkCommandDrawSpriteBatch,
+                                                       sizeof(lurkDrawSpriteBatchData) + SpriteBatchSize(batch->count));
+        cmdData->batch = NULL;
+        cmdData->count = batch->count;
+        CopySpriteBatch((unsigned char*)(cmdData + 1), batch);
+        CommitCommand(state);
+        return;
+    }
+    lurkDrawSpriteBatchData *cmdData = PushCommand(state, lurkCommandDrawSpriteBatch, sizeof(lurkDrawSpriteBatchData));
+    cmdData->batch = batch;
+    cmdData->count = batch->count;
+    CommitCommand(state);
 }
 
+// MARK: Profiler
+
+#if defined(LURK_ENABLE_PROFILER)
 typedef struct {
-    sgp_point* points;
-    int count;
-} lurkDrawPointsData;
+    char name[LURK_PROFILE_NAME_LENGTH]; // empty ends the innermost open zone
+    uint64_t time;
+} lurkProfileEvent;
+
+// Every thread that opens a zone gets a ring that only it writes to. Rings are
+// found through `state->profiler`, not just the thread local, as the host and
+// each scene library have their own copy of this code. Names are copied in, a
+// scene's strings are gone once it's been reloaded.
+struct lurkProfileRing {
+    lurkProfileEvent events[LURK_PROFILE_RING_SIZE];
+    uint64_t head; // events written so far, published with a release store
+    uint64_t thread;
+    struct lurkProfileRing *next;
+};
 
-void lurkDrawPoints(lurkState *state, sgp_point* points, int count) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawPoints;
-    lurkDrawPointsData* cmdData = malloc(sizeof(lurkDrawPointsData));
-    cmdData->points = points;
-    cmdData->count = count;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+static __thread struct lurkProfileRing *profileRing = NULL;
+
+static uint64_t ProfileThreadID(void) {
+#if defined(LURK_POSIX)
+    return (uint64_t)pthread_self();
+#else
+    return (uint64_t)GetCurrentThreadId();
+#endif
 }
 
-typedef struct {
-    float x;
-    float y;
-} lurkDrawPointData;
+static struct lurkProfileRing* ProfileRing(lurkState *state) {
+    if (profileRing)
+        return profileRing;
+    uint64_t thread = ProfileThreadID();
+    struct lurkProfileRing *rings = __atomic_load_n(&state->profiler.rings, __ATOMIC_ACQUIRE);
+    for (struct lurkProfileRing *ring = rings; ring; ring = ring->next)
+        if (ring->thread == thread)
+            return profileRing = ring;
+    struct lurkProfileRing *ring = calloc(1, sizeof(struct lurkProfileRing));
+    assert(ring);
+    ring->thread = thread;
+    ring->next = rings;
+    while (!__atomic_compare_exchange_n(&state->profiler.rings, &ring->next, ring, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    return profileRing = ring;
+}
+
+static void ProfileEvent(lurkState *state, const char *name) {
+    if (!state->profiler.now)
+        return;
+    struct lurkProfileRing *ring = ProfileRing(state);
+    lurkProfileEvent *event = &ring->events[ring->head % LURK_PROFILE_RING_SIZE];
+    strncpy(event->name, name, LURK_PROFILE_NAME_LENGTH - 1);
+    event->name[LURK_PROFILE_NAME_LENGTH - 1] = '\0';
+    event->time = state->profiler.now();
+    __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+}
+
+void lurkProfileBegin(lurkState *state, const char *name) {
+    assert(name && name[0]);
+    ProfileEvent(state, name);
+}
+
+void lurkProfileEnd(lurkState *state) {
+    ProfileEvent(state, "");
+}
+
+bool lurkProfileDump(lurkState *state, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "[FILE ERROR] Failed to open \"%s\"\n", path);
+        return false;
+    }
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    int tid = 0;
+    for (struct lurkProfileRing *ring = __atomic_load_n(&state->profiler.rings, __ATOMIC_ACQUIRE); ring; ring = ring->next, tid++) {
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        int depth = 0;
+        for (uint64_t i = head > LURK_PROFILE_RING_SIZE ? head - LURK_PROFILE_RING_SIZE : 0; i < head; i++) {
+            lurkProfileEvent *event = &ring->events[i % LURK_PROFILE_RING_SIZE];
+            bool begin = event->name[0] != '\0';
+            // The ring may have wrapped in the middle of a zone
+            if (!begin && !depth)
+                continue;
+            depth += begin ? 1 : -1;
+            fprintf(file, "%s\n{\"ph\":\"%c\",\"pid\":0,\"tid\":%d,\"ts\":%.3f", first ? "" : ",", begin ? 'B' : 'E', tid, event->time / 1000.0);
+            if (begin) {
+                fprintf(file, ",\"name\":\"");
+                for (const char *c = event->name; *c; c++) {
+                    if (*c == '"' || *c == '\\')
+                        fputc('\\', file);
+                    fputc(*c, file);
+                }
+                fputc('"', file);
+            }
+            fputc('}', file);
+            first = false;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
+#endif
 
-void lurkDrawPoint(lurkState *state, float x, float y) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawPoint;
-    lurkDrawPointData* cmdData = malloc(sizeof(lurkDrawPointData));
-    cmdData->x = x;
-    cmdData->y = y;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+// MARK: Timestep
+
+// Derives the fixed timestep loop's state from `tickRate` and starts it over.
+// Deltas close to a multiple (or a fraction) of the tick are snapped to it.
+static void UpdateTimestep(lurkState *state) {
+    if (state->tickRate < 1)
+        state->tickRate = 1;
+    if (state->updateMultiplicity < 1)
+        state->updateMultiplicity = 1;
+    state->desiredFrameTime = state->timerFrequency / state->tickRate;
+    state->fixedDeltaTime = 1.0 / state->tickRate;
+    int64_t tick = state->desiredFrameTime;
+    state->snapFrequencies[0] = tick;
+    state->snapFrequencies[1] = tick*2;
+    state->snapFrequencies[2] = tick*3;
+    state->snapFrequencies[3] = tick*4;
+    state->snapFrequencies[4] = (tick+1)/2;
+    state->snapFrequencies[5] = (tick+2)/3;
+    state->snapFrequencies[6] = (tick+3)/4;
+    state->maxVsyncError = state->timerFrequency * .0002;
+    for (int i = 0; i < 4; i++)
+        state->timeAverager[i] = state->desiredFrameTime;
+    state->resync = true;
 }
 
-typedef struct {
-    sgp_line* lines;
-    int count;
-} lurkDrawLinesData;
+void lurkSetTickRate(lurkState *state, int hz) {
+    state->tickRate = hz;
+    UpdateTimestep(state);
+}
 
-void lurkDrawLines(lurkState *state, sgp_line* lines, int count) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawLines;
-    lurkDrawLinesData* cmdData = malloc(sizeof(lurkDrawLinesData));
-    cmdData->lines = lines;
-    cmdData->count = count;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+void lurkSetUnlockFramerate(lurkState *state, bool unlocked) {
+    state->unlockFramerate = unlocked;
+    UpdateTimestep(state);
 }
 
-typedef struct {
-    float ax;
-    float ay;
-    float bx;
-    float by;
-} lurkDrawLineData;
-
-void lurkDrawLine(lurkState *state, float ax, float ay, float bx, float by) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawLine;
-    lurkDrawLineData* cmdData = malloc(sizeof(lurkDrawLineData));
-    cmdData->ax = ax;
-    cmdData->ay = ay;
-    cmdData->bx = bx;
-    cmdData->by = by;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+void lurkSetUpdateMultiplicity(lurkState *state, int multiplicity) {
+    state->updateMultiplicity = multiplicity;
+    UpdateTimestep(state);
 }
 
-typedef struct {
-    sgp_point* points;
-    int count;
-} lurkDrawLinesStripData;
+void lurkRequestRedraw(lurkState *state) {
+    state->redrawRequested = true;
+}
 
-void lurkDrawLinesStrip(lurkState *state, sgp_point* points, int count) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawLinesStrip;
-    lurkDrawLinesStripData* cmdData = malloc(sizeof(lurkDrawLinesStripData));
-    cmdData->points = points;
-    cmdData->count = count;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+// Only the delay is stored, the scene's copy of sokol_time is never set up.
+// The host turns it into a deadline once the frame is done.
+void lurkRequestRedrawAfter(lurkState *state, double seconds) {
+    if (seconds <= 0.0)
+        state->redrawRequested = true;
+    else if (state->redrawDelay <= 0.0 || seconds < state->redrawDelay)
+        state->redrawDelay = seconds;
 }
 
+#if !defined(LURK_SCENE)
+// New textures are only added to the texture map between frames, the scene may
+// be recording (and looking up textures) on another thread during replay
+static struct {
+    uint64_t id;
+    lurkTexture *texture;
+} *pendingTextures = NULL;
+static int pendingTexturesCount = 0;
+static int pendingTexturesCapacity = 0;
+
+static void CreateTexture(const lurkCreateTextureData *data) {
+    lurkTexture* texture = EmptyTexture(data->image->w, data->image->h);
+    UpdateTexture(texture, data->image->buf, data->image->w, data->image->h);
+    if (pendingTexturesCount == pendingTexturesCapacity) {
+        pendingTexturesCapacity = pendingTexturesCapacity ? pendingTexturesCapacity * 2 : 8;
+        pendingTextures = realloc(pendingTextures, pendingTexturesCapacity * sizeof(*pendingTextures));
+    }
+    pendingTextures[pendingTexturesCount].id = data->id;
+    pendingTextures[pendingTexturesCount++].texture = texture;
+}
+
+static void FlushPendingTextures(void) {
+    for (int i = 0; i < pendingTexturesCount; i++) {
+        state.textureMap = imap_ensure(state.textureMap, 1);
+        imap_slot_t *slot = imap_assign(state.textureMap, pendingTextures[i].id);
+        assert(slot);
+        imap_setval64(state.textureMap, slot, (uint64_t)pendingTextures[i].texture);
+    }
+    pendingTexturesCount = 0;
+}
+
+static void CreateRenderTarget(const lurkCreateRenderTargetData *data) {
+    lurkTexture *texture = calloc(1, sizeof(lurkTexture));
+    texture->target = malloc(sizeof(lurkRenderTarget));
+    MakeRenderTarget(texture->target, data->w, data->h);
+    texture->internal = RenderTargetImage(texture->target);
+    texture->w = data->w;
+    texture->h = data->h;
+    texture->dirty = true;
+    if (pendingTexturesCount == pendingTexturesCapacity) {
+        pendingTexturesCapacity = pendingTexturesCapacity ? pendingTexturesCapacity * 2 : 8;
+        pendingTextures = realloc(pendingTextures, pendingTexturesCapacity * sizeof(*pendingTextures));
+    }
+    pendingTextures[pendingTexturesCount].id = data->id;
+    pendingTextures[pendingTexturesCount++].texture = texture;
+}
+
+// MARK: Sprite batches
+
+// Each sprite is an instance of a quad that the vertex shader expands from the
+// vertex index, the batch's arrays are bound as separate per-instance vertex
+// buffers. The quad is drawn through sokol_gp's quad index buffer, so the
+// vertex shader runs 4 times per sprite rather than 6. Batches are uploaded
+// when they're replayed and queued in sokol_gp as a draw callback, so they're
+// drawn in their place in the frame when it's flushed. The shaders are written
+// by hand, one per backend, the same way sokol_gp embeds its own.
+#define LURK_SPRITE_VS_GLSL                                                                                         \
+    "uniform vec4 vs_params[3];\n"                                                                                  \
+    "layout(location = 0) in vec2 position;\n"                                                                      \
+    "layout(location = 1) in vec2 scale;\n"                                                                         \
+    "layout(location = 2) in float rotation;\n"                                                                     \
+    "layout(location = 3) in vec4 src;\n"                                                                           \
+    "layout(location = 4) in vec4 color;\n"                                                                         \
+    "out vec2 uv;\n"                                                                                                \
+    "out vec4 tint;\n"                                                                                              \
+    "const vec2 corners[4] = vec2[4](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));\n"            \
+    "void main() {\n"                                                                                               \
+    "    vec2 corner = corners[gl_VertexID];\n"                                                                     \
+    "    vec2 p = (corner - 0.5) * src.zw * scale;\n"                                                               \
+    "    float s = sin(rotation), c = cos(rotation);\n"                                                             \
+    "    p = position + vec2(c * p.x - s * p.y, s * p.x + c * p.y);\n"                                              \
+    "    gl_Position = vec4(dot(vs_params[0].xyz, vec3(p, 1.0)), dot(vs_params[1].xyz, vec3(p, 1.0)), 0.0, 1.0);\n" \
+    "    uv = (src.xy + corner * src.zw) * vs_params[2].xy;\n"                                                      \
+    "    tint = color;\n"                                                                                           \
+    "}\n"
+
+#define LURK_SPRITE_FS_GLSL                       \
+    "uniform sampler2D tex;\n"                    \
+    "in vec2 uv;\n"                               \
+    "in vec4 tint;\n"                             \
+    "layout(location = 0) out vec4 frag_color;\n" \
+    "void main() {\n"                             \
+    "    frag_color = texture(tex, uv) * tint;\n" \
+    "}\n"
+
+static const char spriteVertexGLSL330[] = "#version 330\n" LURK_SPRITE_VS_GLSL;
+static const char spriteFragmentGLSL330[] = "#version 330\n" LURK_SPRITE_FS_GLSL;
+static const char spriteVertexGLSL300ES[] = "#version 300 es\n" LURK_SPRITE_VS_GLSL;
+static const char spriteFragmentGLSL300ES[] = "#version 300 es\nprecision mediump float;\n" LURK_SPRITE_FS_GLSL;
+
+static const char spriteVertexHLSL4[] =
+    "cbuffer vs_params : register(b0) {\n"
+    "    float4 row0;\n"
+    "    float4 row1;\n"
+    "    float4 texel;\n"
+    "};\n"
+    "static const float2 corners[4] = {\n"
+    "    float2(0.0, 0.0), float2(1.0, 0.0), float2(1.0, 1.0), float2(0.0, 1.0)\n"
+    "};\n"
+    "struct vs_in {\n"
+    "    float2 position : TEXCOORD0;\n"
+    "    float2 scale : TEXCOORD1;\n"
+    "    float rotation : TEXCOORD2;\n"
+    "    float4 src : TEXCOORD3;\n"
+    "    float4 color : TEXCOORD4;\n"
+    "    uint id : SV_VertexID;\n"
+    "};\n"
+    "struct vs_out {\n"
+    "    float2 uv : TEXCOORD0;\n"
+    "    float4 tint : TEXCOORD1;\n"
+    "    float4 pos : SV_Position;\n"
+    "};\n"
+    "vs_out main(vs_in i) {\n"
+    "    float2 corner = corners[i.id];\n"
+    "    float2 p = (corner - 0.5) * i.src.zw * i.scale;\n"
+    "    float s = sin(i.rotation), c = cos(i.rotation);\n"
+    "    p = i.position + float2(c * p.x - s * p.y, s * p.x + c * p.y);\n"
+    "    vs_out o;\n"
+    "    o.pos = float4(dot(row0.xyz, float3(p, 1.0)), dot(row1.xyz, float3(p, 1.0)), 0.0, 1.0);\n"
+    "    o.uv = (i.src.xy + corner * i.src.zw) * texel.xy;\n"
+    "    o.tint = i.color;\n"
+    "    return o;\n"
+    "}\n";
+
+static const char spriteFragmentHLSL4[] =
+    "Texture2D<float4> tex : register(t0);\n"
+    "SamplerState smp : register(s0);\n"
+    "float4 main(float2 uv : TEXCOORD0, float4 tint : TEXCOORD1) : SV_Target0 {\n"
+    "    return tex.Sample(smp, uv) * tint;\n"
+    "}\n";
+
+static const char spriteVertexMetal[] =
+    "#include <metal_stdlib>\n"
+    "using namespace metal;\n"
+    "struct vs_params {\n"
+    "    float4 row0;\n"
+    "    float4 row1;\n"
+    "    float4 texel;\n"
+    "};\n"
+    "struct main0_in {\n"
+    "    float2 position [[attribute(0)]];\n"
+    "    float2 scale [[attribute(1)]];\n"
+    "    float rotation [[attribute(2)]];\n"
+    "    float4 src [[attribute(3)]];\n"
+    "    float4 color [[attribute(4)]];\n"
+    "};\n"
+    "struct main0_out {\n"
+    "    float2 uv [[user(locn0)]];\n"
+    "    float4 tint [[user(locn1)]];\n"
+    "    float4 position [[position]];\n"
+    "};\n"
+    "constant float2 corners[4] = {\n"
+    "    float2(0.0, 0.0), float2(1.0, 0.0), float2(1.0, 1.0), float2(0.0, 1.0)\n"
+    "};\n"
+    "vertex main0_out main0(main0_in in [[stage_in]], constant vs_params& params [[buffer(0)]],\n"
+    "                       uint id [[vertex_id]]) {\n"
+    "    float2 corner = corners[id];\n"
+    "    float2 p = (corner - 0.5) * in.src.zw * in.scale;\n"
+    "    float s = sin(in.rotation), c = cos(in.rotation);\n"
+    "    p = in.position + float2(c * p.x - s * p.y, s * p.x + c * p.y);\n"
+    "    main0_out out;\n"
+    "    out.position = float4(dot(params.row0.xyz, float3(p, 1.0)), dot(params.row1.xyz, float3(p, 1.0)), 0.0, 1.0);\n"
+    "    out.uv = (in.src.xy + corner * in.src.zw) * params.texel.xy;\n"
+    "    out.tint = in.color;\n"
+    "    return out;\n"
+    "}\n";
+
+static const char spriteFragmentMetal[] =
+    "#include <metal_stdlib>\n"
+    "using namespace metal;\n"
+    "struct main0_in {\n"
+    "    float2 uv [[user(locn0)]];\n"
+    "    float4 tint [[user(locn1)]];\n"
+    "};\n"
+    "fragment float4 main0(main0_in in [[stage_in]], texture2d<float> tex [[texture(0)]], sampler smp [[sampler(0)]]) {\n"
+    "    return tex.sample(smp, in.uv) * in.tint;\n"
+    "}\n";
+
+typedef struct {
+    float rows[2][4]; // the 2x3 mvp, padded for std140
+    float texel[4];   // 1 / texture size
+} lurkSpriteParams;
+
+// A batch waiting for sokol_gp to be flushed up to its callback
 typedef struct {
-    sgp_triangle* triangles;
+    uint32_t level; // sgp_begin depth, render targets flush their own batches
     int count;
-} lurkDrawFilledTrianglesData;
+    int offsets[SG_MAX_VERTEX_BUFFERS];
+    sgp_mat2x3 mvp;
+    sg_image image;
+    sg_sampler sampler;
+    sgp_blend_mode blendMode;
+} lurkSpriteDraw;
+
+static struct {
+    sg_shader shader;
+    sg_pipeline pipelines[_SGP_BLENDMODE_NUM];
+    sg_buffer buffer;
+    bool failed; // no shader for this backend, or the buffer couldn't be made
+    bool full;   // `maxSprites` ran out, only reported once
+    lurkSpriteDraw *draws;
+    int count, capacity;
+    int drawCalls; // this frame, counted when they're queued
+    int *order, *counts;
+    int orderCapacity, countsCapacity;
+    unsigned char *scratch;
+    size_t scratchSize;
+} sprites;
+
+static sg_shader MakeSpriteShader(void) {
+    sg_shader_desc desc = {0};
+    desc.vs.uniform_blocks[0].size = sizeof(lurkSpriteParams);
+    desc.vs.uniform_blocks[0].layout = SG_UNIFORMLAYOUT_STD140;
+    desc.vs.uniform_blocks[0].uniforms[0] = (sg_shader_uniform_desc) {
+        .name = "vs_params",
+        .type = SG_UNIFORMTYPE_FLOAT4,
+        .array_count = 3
+    };
+    desc.fs.images[0] = (sg_shader_image_desc) {
+        .used = true,
+        .image_type = SG_IMAGETYPE_2D,
+        .sample_type = SG_IMAGESAMPLETYPE_FLOAT
+    };
+    desc.fs.samplers[0] = (sg_shader_sampler_desc) {
+        .used = true,
+        .sampler_type = SG_SAMPLERTYPE_FILTERING
+    };
+    desc.fs.image_sampler_pairs[0] = (sg_shader_image_sampler_pair_desc) {
+        .used = true,
+        .image_slot = 0,
+        .sampler_slot = 0,
+        .glsl_name = "tex"
+    };
+    int attr = 0;
+#define X(FIELD, TYPE, FORMAT)                  \
+    if (FORMAT != SG_VERTEXFORMAT_INVALID) {    \
+        desc.attrs[attr].name = #FIELD;         \
+        desc.attrs[attr].sem_name = "TEXCOORD"; \
+        desc.attrs[attr].sem_index = attr;      \
+        attr++;                                 \
+    }
+    LURK_SPRITE_ARRAYS
+#undef X
+    desc.vs.d3d11_target = "vs_4_0";
+    desc.fs.d3d11_target = "ps_4_0";
+    desc.vs.entry = desc.fs.entry = "main";
+    switch (sg_query_backend()) {
+        case SG_BACKEND_GLCORE33:
+            desc.vs.source = spriteVertexGLSL330;
+            desc.fs.source = spriteFragmentGLSL330;
+            break;
+        case SG_BACKEND_GLES3:
+            desc.vs.source = spriteVertexGLSL300ES;
+            desc.fs.source = spriteFragmentGLSL300ES;
+            break;
+        case SG_BACKEND_D3D11:
+            desc.vs.source = spriteVertexHLSL4;
+            desc.fs.source = spriteFragmentHLSL4;
+            break;
+        case SG_BACKEND_METAL_MACOS:
+        case SG_BACKEND_METAL_IOS:
+            desc.vs.source = spriteVertexMetal;
+            desc.fs.source = spriteFragmentMetal;
+            desc.vs.entry = desc.fs.entry = "main0";
+            break;
+        case SG_BACKEND_DUMMY:
+            desc.vs.source = desc.fs.source = "";
+            break;
+        default:
+            return (sg_shader){SG_INVALID_ID};
+    }
+    return sg_make_shader(&desc);
+}
 
-void lurkDrawFilledTriangles(lurkState *state, sgp_triangle* triangles, int count) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawFilledTriangles;
-    lurkDrawFilledTrianglesData* cmdData = malloc(sizeof(lurkDrawFilledTrianglesData));
-    cmdData->triangles = triangles;
-    cmdData->count = count;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+static sg_pipeline SpritePipeline(sgp_blend_mode blendMode) {
+    if (sprites.pipelines[blendMode].id != SG_INVALID_ID)
+        return sprites.pipelines[blendMode];
+    sg_pipeline_desc desc = {
+        .shader = sprites.shader,
+        .primitive_type = SG_PRIMITIVETYPE_TRIANGLES,
+        .index_type = _sgp.quad_index_type,
+        .colors[0] = {
+            .pixel_format = _sgp.desc.pixel_format,
+            .blend = _sgp_blend_state(blendMode)
+        }
+    };
+    int slot = 0;
+#define X(FIELD, TYPE, FORMAT)                                                                    \
+    if (FORMAT != SG_VERTEXFORMAT_INVALID) {                                                      \
+        desc.layout.buffers[slot].stride = sizeof(TYPE);                                          \
+        desc.layout.buffers[slot].step_func = SG_VERTEXSTEP_PER_INSTANCE;                         \
+        desc.layout.attrs[slot] = (sg_vertex_attr_state){.buffer_index = slot, .format = FORMAT}; \
+        slot++;                                                                                   \
+    }
+    LURK_SPRITE_ARRAYS
+#undef X
+    sg_pipeline pipeline = sg_make_pipeline(&desc);
+    if (sg_query_pipeline_state(pipeline) != SG_RESOURCESTATE_VALID) {
+        sg_destroy_pipeline(pipeline);
+        return (sg_pipeline){SG_INVALID_ID};
+    }
+    return sprites.pipelines[blendMode] = pipeline;
 }
 
-typedef struct {
-    float ax;
-    float ay;
-    float bx;
-    float by;
-    float cx;
-    float cy;
-} lurkDrawFilledTriangleData;
-
-void lurkDrawFilledTriangle(lurkState *state, float ax, float ay, float bx, float by, float cx, float cy) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawFilledTriangle;
-    lurkDrawFilledTriangleData* cmdData = malloc(sizeof(lurkDrawFilledTriangleData));
-    cmdData->ax = ax;
-    cmdData->ay = ay;
-    cmdData->bx = bx;
-    cmdData->by = by;
-    cmdData->cx = cx;
-    cmdData->cy = cy;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+// Made the first time a batch is drawn, scenes that don't use them pay nothing
+static bool SpritesReady(void) {
+    if (sprites.failed)
+        return false;
+    if (sprites.buffer.id != SG_INVALID_ID)
+        return true;
+    if (_sgp.quad_index_buf.id == SG_INVALID_ID) {
+        fprintf(stderr, "[SPRITE ERROR] Sprite batches need maxVertices to be at least 4\n");
+        sprites.failed = true;
+        return false;
+    }
+    sprites.shader = MakeSpriteShader();
+    size_t size = 0;
+#define X(FIELD, TYPE, FORMAT) size += FORMAT != SG_VERTEXFORMAT_INVALID ? sizeof(TYPE) : 0;
+    LURK_SPRITE_ARRAYS
+#undef X
+    if (sg_query_shader_state(sprites.shader) != SG_RESOURCESTATE_VALID) {
+        fprintf(stderr, "[SPRITE ERROR] Sprite batches aren't supported by this backend\n");
+        sprites.failed = true;
+        return false;
+    }
+    sprites.buffer = sg_make_buffer(&(sg_buffer_desc) {
+        .size = state.maxSprites * size,
+        .usage = SG_USAGE_STREAM
+    });
+    if (sg_query_buffer_state(sprites.buffer) != SG_RESOURCESTATE_VALID) {
+        fprintf(stderr, "[SPRITE ERROR] Failed to make a buffer for %d sprites\n", state.maxSprites);
+        sprites.failed = true;
+        return false;
+    }
+    return true;
 }
 
-typedef struct {
-    sgp_point* points;
-    int count;
-} lurkDrawFilledTrianglesStripData;
+static lurkSpriteBatch SpriteBatchView(const lurkDrawSpriteBatchData *data) {
+    lurkSpriteBatch result = {.count = data->count, .capacity = data->count};
+    if (data->batch) {
+#define X(FIELD, TYPE, FORMAT) result.FIELD = data->batch->FIELD;
+        LURK_SPRITE_ARRAYS
+#undef X
+        return result;
+    }
+    const unsigned char *array = (const unsigned char*)(data + 1);
+#define X(FIELD, TYPE, FORMAT)           \
+    result.FIELD = (TYPE*)array;         \
+    array += data->count * sizeof(TYPE);
+    LURK_SPRITE_ARRAYS
+#undef X
+    return result;
+}
 
-void lurkDrawFilledTrianglesStrip(lurkState *state, sgp_point* points, int count) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawFilledTrianglesStrip;
-    lurkDrawFilledTrianglesStripData* cmdData = malloc(sizeof(lurkDrawFilledTrianglesStripData));
-    cmdData->points = points;
-    cmdData->count = count;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+// Returns the order to upload the sprites in, or NULL when they're already in
+// layer order. Small layer ranges are counting sorted, anything else is sorted
+// by layer and index packed into one key.
+static int CompareSpriteKeys(const void *a, const void *b) {
+    uint64_t ka = *(const uint64_t*)a, kb = *(const uint64_t*)b;
+    return ka < kb ? -1 : ka > kb;
+}
+
+static const int* SortSprites(const lurkSpriteBatch *batch) {
+    int min = batch->layer[0], max = batch->layer[0];
+    bool sorted = true;
+    for (int i = 1; i < batch->count; i++) {
+        sorted &= batch->layer[i] >= batch->layer[i - 1];
+        min = batch->layer[i] < min ? batch->layer[i] : min;
+        max = batch->layer[i] > max ? batch->layer[i] : max;
+    }
+    if (sorted)
+        return NULL;
+    if (batch->count > sprites.orderCapacity) {
+        sprites.orderCapacity = batch->count;
+        sprites.order = realloc(sprites.order, sprites.orderCapacity * sizeof(int));
+    }
+    int64_t range = (int64_t)max - min + 1;
+    if (range <= 65536) {
+        if (range > sprites.countsCapacity) {
+            sprites.countsCapacity = (int)range;
+            sprites.counts = realloc(sprites.counts, sprites.countsCapacity * sizeof(int));
+        }
+        memset(sprites.counts, 0, range * sizeof(int));
+        for (int i = 0; i < batch->count; i++)
+            sprites.counts[batch->layer[i] - min]++;
+        for (int i = 0, offset = 0; i < range; i++) {
+            int count = sprites.counts[i];
+            sprites.counts[i] = offset;
+            offset += count;
+        }
+        for (int i = 0; i < batch->count; i++)
+            sprites.order[sprites.counts[batch->layer[i] - min]++] = i;
+        return sprites.order;
+    }
+    uint64_t *keys = malloc(batch->count * sizeof(uint64_t));
+    for (int i = 0; i < batch->count; i++)
+        keys[i] = (uint64_t)((int64_t)batch->layer[i] - min) << 32 | (uint32_t)i;
+    qsort(keys, batch->count, sizeof(uint64_t), CompareSpriteKeys);
+    for (int i = 0; i < batch->count; i++)
+        sprites.order[i] = (int)(uint32_t)keys[i];
+    free(keys);
+    return sprites.order;
+}
+
+// Appends one array to the buffer, gathered into `order` first when it's given
+static int UploadSpriteArray(const void *array, size_t size, int count, const int *order) {
+    if (order) {
+        if (count * size > sprites.scratchSize) {
+            sprites.scratchSize = count * size;
+            sprites.scratch = realloc(sprites.scratch, sprites.scratchSize);
+        }
+        if (size == sizeof(sgp_rect))
+            for (int i = 0; i < count; i++)
+                ((sgp_rect*)sprites.scratch)[i] = ((const sgp_rect*)array)[order[i]];
+        else if (size == sizeof(sgp_vec2))
+            for (int i = 0; i < count; i++)
+                ((sgp_vec2*)sprites.scratch)[i] = ((const sgp_vec2*)array)[order[i]];
+        else
+            for (int i = 0; i < count; i++)
+                ((uint32_t*)sprites.scratch)[i] = ((const uint32_t*)array)[order[i]];
+        array = sprites.scratch;
+    }
+    return sg_append_buffer(sprites.buffer, &(sg_range){array, count * size});
 }
 
-typedef struct {
-    sgp_rect* rects;
-    int count;
-} lurkDrawFilledRectsData;
+static void SubmitSprites(void *userData);
 
-void lurkDrawFilledRects(lurkState *state, sgp_rect* rects, int count) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawFilledRects;
-    lurkDrawFilledRectsData* cmdData = malloc(sizeof(lurkDrawFilledRectsData));
-    cmdData->rects = rects;
-    cmdData->count = count;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
-}
+static void DrawSpriteBatch(const lurkDrawSpriteBatchData *data) {
+    if (!data->count || !SpritesReady())
+        return;
+    lurkSpriteBatch batch = SpriteBatchView(data);
+    size_t bytes = 0;
+#define X(FIELD, TYPE, FORMAT) bytes += FORMAT != SG_VERTEXFORMAT_INVALID ? batch.count * sizeof(TYPE) : 0;
+    LURK_SPRITE_ARRAYS
+#undef X
+    if (sg_query_buffer_will_overflow(sprites.buffer, bytes)) {
+        if (!sprites.full)
+            fprintf(stderr, "[SPRITE ERROR] More than %d sprites drawn in a frame, raise maxSprites\n", state.maxSprites);
+        sprites.full = true;
+        return;
+    }
 
-typedef struct {
-    float x;
-    float y;
-    float w;
-    float h;
-} lurkDrawFilledRectData;
-
-void lurkDrawFilledRect(lurkState *state, float x, float y, float w, float h) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawFilledRect;
-    lurkDrawFilledRectData* cmdData = malloc(sizeof(lurkDrawFilledRectData));
-    cmdData->x = x;
-    cmdData->y = y;
-    cmdData->w = w;
-    cmdData->h = h;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+    if (sprites.count == sprites.capacity) {
+        sprites.capacity = sprites.capacity ? sprites.capacity * 2 : 8;
+        sprites.draws = realloc(sprites.draws, sprites.capacity * sizeof(lurkSpriteDraw));
+    }
+    int index = sprites.count++;
+    lurkSpriteDraw *draw = &sprites.draws[index];
+    *draw = (lurkSpriteDraw) {
+        .level = _sgp.cur_state,
+        .count = batch.count,
+        .mvp = _sgp.state.mvp,
+        .image = _sgp.state.textures.images[0],
+        .sampler = _sgp.state.textures.samplers[0],
+        .blendMode = _sgp.state.blend_mode
+    };
+    const int *order = SortSprites(&batch);
+    int slot = 0;
+#define X(FIELD, TYPE, FORMAT)                                                                    \
+    if (FORMAT != SG_VERTEXFORMAT_INVALID)                                                        \
+        draw->offsets[slot++] = UploadSpriteArray(batch.FIELD, sizeof(TYPE), batch.count, order);
+    LURK_SPRITE_ARRAYS
+#undef X
+    // By index, `draws` can move before the frame is flushed
+    sgp_draw_callback(SubmitSprites, (void*)(intptr_t)index);
+    sprites.drawCalls++;
 }
 
-typedef struct {
-    int channel;
-    sgp_textured_rect* rects;
-    int count;
-} lurkDrawTexturedRectsData;
+static void SubmitSprites(void *userData) {
+    const lurkSpriteDraw *draw = &sprites.draws[(intptr_t)userData];
+    sg_pipeline pipeline = SpritePipeline(draw->blendMode);
+    if (pipeline.id == SG_INVALID_ID)
+        return;
+    sg_image image = draw->image.id != SG_INVALID_ID ? draw->image : _sgp.white_img;
+    sgp_isize size = _sgp_query_image_size(image);
+    sg_bindings bindings = {
+        .index_buffer = _sgp.quad_index_buf,
+        .fs.images[0] = image,
+        .fs.samplers[0] = draw->sampler.id != SG_INVALID_ID ? draw->sampler : _sgp.nearest_smp
+    };
+    int slot = 0;
+#define X(FIELD, TYPE, FORMAT)                                      \
+    if (FORMAT != SG_VERTEXFORMAT_INVALID) {                        \
+        bindings.vertex_buffers[slot] = sprites.buffer;             \
+        bindings.vertex_buffer_offsets[slot] = draw->offsets[slot]; \
+        slot++;                                                     \
+    }
+    LURK_SPRITE_ARRAYS
+#undef X
+    lurkSpriteParams params = {
+        .rows = {
+            {draw->mvp.v[0][0], draw->mvp.v[0][1], draw->mvp.v[0][2], 0.f},
+            {draw->mvp.v[1][0], draw->mvp.v[1][1], draw->mvp.v[1][2], 0.f}
+        },
+        .texel = {1.f / size.w, 1.f / size.h, 0.f, 0.f}
+    };
+    sg_apply_pipeline(pipeline);
+    sg_apply_bindings(&bindings);
+    sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, &SG_RANGE(params));
+    sg_draw(0, 6, draw->count);
+}
+
+// sgp_flush, the batches drawn at this sgp_begin level are submitted by their
+// callbacks along the way. Viewport and scissor rects are scaled by `sx`, `sy`
+// when the pass isn't the size the frame was recorded at.
+static void FlushScaledCommands(float sx, float sy) {
+    sgp_flush_scaled(sx, sy);
+    while (sprites.count && sprites.draws[sprites.count - 1].level == _sgp.cur_state)
+        sprites.count--;
+}
+
+static void FlushCommands(void) {
+    FlushScaledCommands(1.f, 1.f);
+}
+
+static void DestroySprites(void) {
+    for (int i = 0; i < _SGP_BLENDMODE_NUM; i++)
+        if (sprites.pipelines[i].id != SG_INVALID_ID)
+            sg_destroy_pipeline(sprites.pipelines[i]);
+    if (sprites.shader.id != SG_INVALID_ID)
+        sg_destroy_shader(sprites.shader);
+    if (sprites.buffer.id != SG_INVALID_ID)
+        sg_destroy_buffer(sprites.buffer);
+    free(sprites.draws);
+    free(sprites.order);
+    free(sprites.counts);
+    free(sprites.scratch);
+    memset(&sprites, 0, sizeof(sprites));
+}
+
+#if !defined(LURK_MAX_RENDER_TARGET_DEPTH)
+#define LURK_MAX_RENDER_TARGET_DEPTH 8
+#endif
 
-void lurkDrawTexturedRects(lurkState *state, int channel, sgp_textured_rect* rects, int count) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawTexturedRects;
-    lurkDrawTexturedRectsData* cmdData = malloc(sizeof(lurkDrawTexturedRectsData));
-    cmdData->channel = channel;
-    cmdData->rects = rects;
-    cmdData->count = count;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+// Replay isn't inside a sokol pass until the frame is submitted, so each target
+// gets its own pass as soon as it's ended. Draws into it are batched in a nested
+// sokol_gp frame, which is flushed and popped by EndRenderTarget. Targets that
+// can't be found (in a capture replay) have their draws thrown away.
+static struct {
+    lurkRenderTarget *stack[LURK_MAX_RENDER_TARGET_DEPTH];
+    int depth;
+    int drawCalls; // into targets this frame, they aren't left in sokol_gp to count
+    sg_pass_action clear;
+} targets = {
+    .clear.colors[0] = {
+        .load_action = SG_LOADACTION_CLEAR,
+        .clear_value = {0.f, 0.f, 0.f, 0.f}
+    }
+};
+
+static void BeginRenderTarget(const lurkBeginRenderTargetData *data) {
+    assert(targets.depth < LURK_MAX_RENDER_TARGET_DEPTH);
+    imap_slot_t *slot = state.textureMap ? imap_lookup(state.textureMap, data->target) : NULL;
+    lurkTexture *texture = slot ? (lurkTexture*)imap_getval64(state.textureMap, slot) : NULL;
+    targets.stack[targets.depth++] = texture ? texture->target : NULL;
+    sgp_begin(data->w, data->h);
+}
+
+// Targets are sampled upside down when the backend's origin is bottom left, so
+// their clip space is flipped before it's flushed. Viewport and scissor rects
+// are flipped to match, sokol_gp keeps them relative to the top left.
+static void FlipRenderTarget(lurkRenderTarget *target) {
+    for (uint32_t i = _sgp.state._base_vertex; i < _sgp.cur_vertex; i++)
+        _sgp.vertices[i].position.y = -_sgp.vertices[i].position.y;
+    for (uint32_t i = _sgp.state._base_command; i < _sgp.cur_command; i++)
+        if (_sgp.commands[i].cmd == SGP_COMMAND_VIEWPORT || _sgp.commands[i].cmd == SGP_COMMAND_SCISSOR) {
+            sgp_irect *rect = _sgp.commands[i].cmd == SGP_COMMAND_VIEWPORT ? &_sgp.commands[i].args.viewport : &_sgp.commands[i].args.scissor;
+            rect->y = target->h - (rect->y + rect->h);
+        }
+    for (int i = sprites.count - 1; i >= 0 && sprites.draws[i].level == _sgp.cur_state; i--)
+        for (int j = 0; j < 3; j++)
+            sprites.draws[i].mvp.v[1][j] = -sprites.draws[i].mvp.v[1][j];
+}
+
+static void EndRenderTarget(void) {
+    assert(targets.depth > 0);
+    lurkRenderTarget *target = targets.stack[--targets.depth];
+    if (!target) {
+        while (sprites.count && sprites.draws[sprites.count - 1].level == _sgp.cur_state)
+            sprites.count--;
+        _sgp.cur_vertex = _sgp.state._base_vertex;
+        _sgp.cur_uniform = _sgp.state._base_uniform;
+        _sgp.cur_command = _sgp.state._base_command;
+        sgp_end();
+        return;
+    }
+    for (uint32_t i = _sgp.state._base_command; i < _sgp.cur_command; i++)
+        targets.drawCalls += _sgp.commands[i].cmd == SGP_COMMAND_DRAW;
+    if (!sg_query_features().origin_top_left)
+        FlipRenderTarget(target);
+    sg_begin_pass(target->pass, &targets.clear);
+    FlushCommands();
+    sgp_end();
+    sg_end_pass();
 }
 
+// Draws waiting to be sorted, along with the sokol_gp state they were recorded in
 typedef struct {
-    int channel;
-    sgp_rect dest_rect;
-    sgp_rect src_rect;
-} lurkDrawTexturedRectData;
-
-void lurkDrawTexturedRect(lurkState *state, int channel, sgp_rect dest_rect, sgp_rect src_rect) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawTexturedRect;
-    lurkDrawTexturedRectData* cmdData = malloc(sizeof(lurkDrawTexturedRectData));
-    cmdData->channel = channel;
-    cmdData->dest_rect = dest_rect;
-    cmdData->src_rect = src_rect;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+    int layer;
+    int sequence;
+    lurkCommand *command;
+    sgp_state state;
+} lurkSortedDraw;
+
+static struct {
+    lurkSortedDraw *draws;
+    lurkSortedDraw **order;
+    int count, capacity;
+    int layer;
+} sorter;
+
+static void SetLayer(int layer) {
+    sorter.layer = layer;
 }
 
-typedef struct {
-    ezImage *image;
-    const char *name;
-} lurkCreateTextureData;
+static void ReplayCommands(const lurkCommandBuffer *buffer);
 
-void lurkCreateTexture(lurkState *state, const char *name, ezImage *image) {
-    lurkCommand* cmd = malloc(sizeof(lurkCommand));
-    cmd->type = lurkCommandDrawTexturedRect;
-    lurkCreateTextureData* cmdData = malloc(sizeof(lurkCreateTextureData));
-    cmdData->name = name;
-    cmdData->image = image;
-    cmd->data = cmdData;
-    PushCommand(state, cmd);
+static sgp_mat2x3 MultiplyMatrix(const sgp_mat2x3 *a, const sgp_mat2x3 *b) {
+    sgp_mat2x3 m = {{
+        {a->v[0][0] * b->v[0][0] + a->v[0][1] * b->v[1][0],
+         a->v[0][0] * b->v[0][1] + a->v[0][1] * b->v[1][1],
+         a->v[0][0] * b->v[0][2] + a->v[0][1] * b->v[1][2] + a->v[0][2]},
+        {a->v[1][0] * b->v[0][0] + a->v[1][1] * b->v[1][0],
+         a->v[1][0] * b->v[0][1] + a->v[1][1] * b->v[1][1],
+         a->v[1][0] * b->v[0][2] + a->v[1][1] * b->v[1][2] + a->v[1][2]}
+    }};
+    return m;
 }
 
-#if !defined(LURK_SCENE)
-static void FreeCommand(lurkCommand* command) {
-    lurkCommandType type = command->type;
-    switch
-(type) {
-    case lurkCommandProject: {
-        lurkProjectData* data = (lurkProjectData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandTranslate: {
-        lurkTranslateData* data = (lurkTranslateData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandRotate: {
-        lurkRotateData* data = (lurkRotateData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandRotateAt: {
-        lurkRotateAtData* data = (lurkRotateAtData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandScale: {
-        lurkScaleData* data = (lurkScaleData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandScaleAt: {
-        lurkScaleAtData* data = (lurkScaleAtData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandSetUniform: {
-        lurkSetUniformData* data = (lurkSetUniformData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandSetBlendMode: {
-        lurkSetBlendModeData* data = (lurkSetBlendModeData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandSetColor: {
-        lurkSetColorData* data = (lurkSetColorData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandSetImage: {
-        lurkSetImageData* data = (lurkSetImageData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandUnsetImage: {
-        lurkUnsetImageData* data = (lurkUnsetImageData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandResetImage: {
-        lurkResetImageData* data = (lurkResetImageData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandResetSampler: {
-        lurkResetSamplerData* data = (lurkResetSamplerData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandViewport: {
-        lurkViewportData* data = (lurkViewportData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandScissor: {
-        lurkScissorData* data = (lurkScissorData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawPoints: {
-        lurkDrawPointsData* data = (lurkDrawPointsData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawPoint: {
-        lurkDrawPointData* data = (lurkDrawPointData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawLines: {
-        lurkDrawLinesData* data = (lurkDrawLinesData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawLine: {
-        lurkDrawLineData* data = (lurkDrawLineData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawLinesStrip: {
-        lurkDrawLinesStripData* data = (lurkDrawLinesStripData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawFilledTriangles: {
-        lurkDrawFilledTrianglesData* data = (lurkDrawFilledTrianglesData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawFilledTriangle: {
-        lurkDrawFilledTriangleData* data = (lurkDrawFilledTriangleData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawFilledTrianglesStrip: {
-        lurkDrawFilledTrianglesStripData* data = (lurkDrawFilledTrianglesStripData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawFilledRects: {
-        lurkDrawFilledRectsData* data = (lurkDrawFilledRectsData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawFilledRect: {
-        lurkDrawFilledRectData* data = (lurkDrawFilledRectData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawTexturedRects: {
-        lurkDrawTexturedRectsData* data = (lurkDrawTexturedRectsData*)command->data;
-        free(data);
-        break;
-    }
-    case lurkCommandDrawTexturedRect: {
-        lurkDrawTexturedRectData* data = (lurkDrawTexturedRectData*)command->data;
-        free(data);
-        break;
+static void MultiplyTransform(const sgp_mat2x3 *matrix) {
+    _sgp.state.transform = MultiplyMatrix(&_sgp.state.transform, matrix);
+    _sgp.state.mvp = _sgp_mul_proj_transform(&_sgp.state.proj, &_sgp.state.transform);
+}
+
+static void CallCommandList(const lurkCallCommandListData *data) {
+    if (!data->transformed) {
+        ReplayCommands(data->list);
+        return;
     }
-    default:
-        break;
+    sgp_push_transform();
+    MultiplyTransform(&data->transform);
+    ReplayCommands(data->list);
+    sgp_pop_transform();
+}
+
+#define X(NAME, RECORDER, PARAMS, VALUES, FIELDS, REPLAY)  \
+    static void Replay##NAME(const void *payload) {        \
+        const lurk##NAME##Data *data = payload;            \
+        (void)data;                                        \
+        REPLAY;                                            \
     }
-    free(command);
+LURK_COMMANDS
+#undef X
+
+static void (*ReplayCommandTable[lurkCommandCount])(const void*) = {
+#define X(NAME, RECORDER, PARAMS, VALUES, FIELDS, REPLAY) [lurkCommand##NAME] = Replay##NAME,
+    LURK_COMMANDS
+#undef X
+};
+
+static void ProcessCommand(lurkCommand *command) {
+    assert(command->type < lurkCommandCount);
+    ReplayCommandTable[command->type](CommandData(command));
 }
 
-static void ProcessCommand(lurkCommand* command) {
-    lurkCommandType type = command->type;
+// Draw commands are the contiguous block DrawPoints ... DrawTexturedRect
+static bool IsDrawCommand(uint32_t type) {
+    return type >= lurkCommandDrawPoints && type <= lurkCommandDrawTexturedRect;
+}
+
+// Commands that queue their own sokol_gp commands, draws can't be moved across them
+static bool IsSortBarrier(uint32_t type) {
     switch (type) {
-    case lurkCommandProject: {
-        lurkProjectData* data = (lurkProjectData*)command->data;
-        sgp_project(data->left, data->right, data->top, data->bottom);
-        break;
-    }
-    case lurkCommandResetProject:
-        sgp_reset_project();
-        break;
-    case lurkCommandPushTransform:
-        sgp_push_transform();
-        break;
-    case lurkCommandPopTransform:
-        sgp_pop_transform();
-        break;
-    case lurkCommandResetTransform:
-        sgp_reset_transform();
-        break;
-    case lurkCommandTranslate: {
-        lurkTranslateData* data = (lurkTranslateData*)command->data;
-        sgp_translate(data->x, data->y);
-        break;
-    }
-    case lurkCommandRotate: {
-        lurkRotateData* data = (lurkRotateData*)command->data;
-        sgp_rotate(data->theta);
-        break;
-    }
-    case lurkCommandRotateAt: {
-        lurkRotateAtData* data = (lurkRotateAtData*)command->data;
-        sgp_rotate_at(data->theta, data->x, data->y);
-        break;
-    }
-    case lurkCommandScale: {
-        lurkScaleData* data = (lurkScaleData*)command->data;
-        sgp_scale(data->sx, data->sy);
-        break;
-    }
-    case lurkCommandScaleAt: {
-        lurkScaleAtData* data = (lurkScaleAtData*)command->data;
-        sgp_scale_at(data->sx, data->sy, data->x, data->y);
-        break;
-    }
-    case lurkCommandResetPipeline:
-        sgp_reset_pipeline();
-        break;
-    case lurkCommandSetUniform: {
-        lurkSetUniformData* data = (lurkSetUniformData*)command->data;
-        sgp_set_uniform(data->data, data->size);
-        break;
-    }
-    case lurkCommandResetUniform:
-        sgp_reset_uniform();
-        break;
-    case lurkCommandSetBlendMode: {
-        lurkSetBlendModeData* data = (lurkSetBlendModeData*)command->data;
-        sgp_set_blend_mode(data->blend_mode);
-        break;
-    }
-    case lurkCommandResetBlendMode:
-        sgp_reset_blend_mode();
-        break;
-    case lurkCommandSetColor: {
-        lurkSetColorData* data = (lurkSetColorData*)command->data;
-        sgp_set_color(data->r, data->g, data->b, data->a);
-        break;
-    }
-    case lurkCommandResetColor:
-        sgp_reset_color();
-        break;
-    case lurkCommandSetImage: {
-        lurkSetImageData* data = (lurkSetImageData*)command->data;
-        sgp_set_image(data->channel, data->texture->internal);
-        break;
-    }
-    case lurkCommandUnsetImage: {
-        lurkUnsetImageData* data = (lurkUnsetImageData*)command->data;
-        sgp_unset_image(data->channel);
-        break;
-    }
-    case lurkCommandResetImage: {
-        lurkResetImageData* data = (lurkResetImageData*)command->data;
-        sgp_reset_image(data->channel);
-        break;
-    }
-    case lurkCommandResetSampler: {
-        lurkResetSamplerData* data = (lurkResetSamplerData*)command->data;
-        sgp_reset_sampler(data->channel);
-        break;
-    }
-    case lurkCommandViewport: {
-        lurkViewportData* data = (lurkViewportData*)command->data;
-        sgp_viewport(data->x, data->y, data->w, data->h);
-        break;
-    }
-    case lurkCommandResetViewport:
-        sgp_reset_viewport();
-        break;
-    case lurkCommandScissor: {
-        lurkScissorData* data = (lurkScissorData*)command->data;
-        sgp_scissor(data->x, data->y, data->w, data->h);
-        break;
-    }
-    case lurkCommandResetScissor:
-        sgp_reset_scissor();
-        break;
-    case lurkCommandResetState:
-        sgp_reset_state();
-        break;
-    case lurkCommandClear:
-        sgp_clear();
-        break;
-    case lurkCommandDrawPoints: {
-        lurkDrawPointsData* data = (lurkDrawPointsData*)command->data;
-        sgp_draw_points(data->points, data->count);
-        break;
-    }
-    case lurkCommandDrawPoint: {
-        lurkDrawPointData* data = (lurkDrawPointData*)command->data;
-        sgp_draw_point(data->x, data->y);
-        break;
-    }
-    case lurkCommandDrawLines: {
-        lurkDrawLinesData* data = (lurkDrawLinesData*)command->data;
-        sgp_draw_lines(data->lines, data->count);
-        break;
-    }
-    case lurkCommandDrawLine: {
-        lurkDrawLineData* data = (lurkDrawLineData*)command->data;
-        sgp_draw_line(data->ax, data->ay, data->bx, data->by);
-        break;
-    }
-    case lurkCommandDrawLinesStrip: {
-        lurkDrawLinesStripData* data = (lurkDrawLinesStripData*)command->data;
-        sgp_draw_lines_strip(data->points, data->count);
-        break;
+        case lurkCommandClear:
+        case lurkCommandViewport:
+        case lurkCommandResetViewport:
+        case lurkCommandScissor:
+        case lurkCommandResetScissor:
+        case lurkCommandResetState:
+        case lurkCommandBeginRenderTarget:
+        case lurkCommandEndRenderTarget:
+        case lurkCommandDrawSpriteBatch:
+            return true;
+        default:
+            return false;
     }
-    case lurkCommandDrawFilledTriangles: {
-        lurkDrawFilledTrianglesData* data = (lurkDrawFilledTrianglesData*)command->data;
-        sgp_draw_filled_triangles(data->triangles, data->count);
-        break;
+}
+
+// Primitive type decides which of sokol_gp's default pipelines a draw ends up in
+static sg_primitive_type DrawPrimitive(uint32_t type) {
+    switch (type) {
+        case lurkCommandDrawPoints:
+        case lurkCommandDrawPoint:
+            return SG_PRIMITIVETYPE_POINTS;
+        case lurkCommandDrawLines:
+        case lurkCommandDrawLine:
+            return SG_PRIMITIVETYPE_LINES;
+        case lurkCommandDrawLinesStrip:
+            return SG_PRIMITIVETYPE_LINE_STRIP;
+        case lurkCommandDrawFilledTrianglesStrip:
+            return SG_PRIMITIVETYPE_TRIANGLE_STRIP;
+        default:
+            return SG_PRIMITIVETYPE_TRIANGLES;
+    }
+}
+
+static int CompareSortedDraws(const void *a, const void *b) {
+    const lurkSortedDraw *da = *(const lurkSortedDraw**)a;
+    const lurkSortedDraw *db = *(const lurkSortedDraw**)b;
+    if (da->layer != db->layer)
+        return da->layer < db->layer ? -1 : 1;
+    if (da->state.pipeline.id != db->state.pipeline.id)
+        return da->state.pipeline.id < db->state.pipeline.id ? -1 : 1;
+    sg_primitive_type pa = DrawPrimitive(da->command->type), pb = DrawPrimitive(db->command->type);
+    if (pa != pb)
+        return pa < pb ? -1 : 1;
+    if (da->state.blend_mode != db->state.blend_mode)
+        return da->state.blend_mode < db->state.blend_mode ? -1 : 1;
+    int result = memcmp(&da->state.textures, &db->state.textures, sizeof(sgp_textures_uniform));
+    if (!result)
+        result = memcmp(&da->state.uniform, &db->state.uniform, sizeof(sgp_uniform));
+    if (!result)
+        result = da->sequence < db->sequence ? -1 : 1;
+    return result;
+}
+
+static void QueueSortedDraw(lurkCommand *command) {
+    if (sorter.count == sorter.capacity) {
+        sorter.capacity = sorter.capacity ? sorter.capacity * 2 : 256;
+        sorter.draws = realloc(sorter.draws, sorter.capacity * sizeof(lurkSortedDraw));
+        sorter.order = realloc(sorter.order, sorter.capacity * sizeof(lurkSortedDraw*));
     }
-    case lurkCommandDrawFilledTriangle: {
-        lurkDrawFilledTriangleData* data = (lurkDrawFilledTriangleData*)command->data;
-        sgp_draw_filled_triangle(data->ax, data->ay, data->bx, data->by, data->cx, data->cy);
-        break;
+    lurkSortedDraw *draw = &sorter.draws[sorter.count];
+    draw->layer = sorter.layer;
+    draw->sequence = sorter.count++;
+    draw->command = command;
+    draw->state = _sgp.state;
+}
+
+// Replays the queued draws grouped by layer then render state. Viewport and
+// scissor are barriers, so they match for every queued draw and restoring the
+// whole sokol_gp state is safe.
+static void FlushSortedDraws(void) {
+    if (!sorter.count)
+        return;
+    for (int i = 0; i < sorter.count; i++)
+        sorter.order[i] = &sorter.draws[i];
+    qsort(sorter.order, sorter.count, sizeof(lurkSortedDraw*), CompareSortedDraws);
+    sgp_state current = _sgp.state;
+    for (int i = 0; i < sorter.count; i++) {
+        _sgp.state = sorter.order[i]->state;
+        ProcessCommand(sorter.order[i]->command);
     }
-    case lurkCommandDrawFilledTrianglesStrip: {
-        lurkDrawFilledTrianglesStripData* data = (lurkDrawFilledTrianglesStripData*)command->data;
-        sgp_draw_filled_triangles_strip(data->points, data->count);
-        break;
+    _sgp.state = current;
+    sorter.count = 0;
+}
+
+static void SortCommand(lurkCommand *command) {
+    if (IsDrawCommand(command->type))
+        QueueSortedDraw(command);
+    else {
+        if (IsSortBarrier(command->type))
+            FlushSortedDraws();
+        ProcessCommand(command);
     }
-    case lurkCommandDrawFilledRects: {
-        lurkDrawFilledRectsData* data = (lurkDrawFilledRectsData*)command->data;
-        sgp_draw_filled_rects(data->rects, data->count);
-        break;
+}
+
+static inline int CountDrawCalls(void) {
+    int count = 0;
+    for (uint32_t i = 0; i < _sgp.cur_command; i++)
+        if (_sgp.commands[i].cmd == SGP_COMMAND_DRAW)
+            count++;
+    return count;
+}
+
+// Matches the sokol_gp transform functions, without updating the mvp
+static void TranslateMatrix(sgp_mat2x3 *m, float x, float y) {
+    m->v[0][2] += x * m->v[0][0] + y * m->v[0][1];
+    m->v[1][2] += x * m->v[1][0] + y * m->v[1][1];
+}
+
+static void RotateMatrix(sgp_mat2x3 *m, float theta) {
+    float sint = sinf(theta), cost = cosf(theta);
+    sgp_mat2x3 r = {{
+        {cost * m->v[0][0] + sint * m->v[0][1], -sint * m->v[0][0] + cost * m->v[0][1], m->v[0][2]},
+        {cost * m->v[1][0] + sint * m->v[1][1], -sint * m->v[1][0] + cost * m->v[1][1], m->v[1][2]}
+    }};
+    *m = r;
+}
+
+static void ScaleMatrix(sgp_mat2x3 *m, float sx, float sy) {
+    m->v[0][0] *= sx;
+    m->v[1][0] *= sx;
+    m->v[0][1] *= sy;
+    m->v[1][1] *= sy;
+}
+
+// Counted while a frame replays. With the pipeline running the scene reads
+// lurkState on the record thread at the same time, so the host copies these
+// into it between frames, see PublishReplayStats
+static struct {
+    int drawCommands, commandCount;
+    int redundant, transforms;
+} replayStats;
+
+static inline void PublishReplayStats(void) {
+    state.drawCommands = replayStats.drawCommands;
+    state.commandCount = replayStats.commandCount;
+    state.filtered.redundant = replayStats.redundant;
+    state.filtered.transforms = replayStats.transforms;
+}
+
+static bool ApplyTransform(sgp_mat2x3 *m, lurkCommand *command) {
+    switch (command->type) {
+        case lurkCommandTranslate: {
+            const lurkTranslateData *data = CommandData(command);
+            TranslateMatrix(m, data->x, data->y);
+            return true;
+        }
+        case lurkCommandRotate: {
+            const lurkRotateData *data = CommandData(command);
+            RotateMatrix(m, data->theta);
+            return true;
+        }
+        case lurkCommandRotateAt: {
+            const lurkRotateAtData *data = CommandData(command);
+            TranslateMatrix(m, data->x, data->y);
+            RotateMatrix(m, data->theta);
+            TranslateMatrix(m, -data->x, -data->y);
+            return true;
+        }
+        case lurkCommandScale: {
+            const lurkScaleData *data = CommandData(command);
+            ScaleMatrix(m, data->sx, data->sy);
+            return true;
+        }
+        case lurkCommandScaleAt: {
+            const lurkScaleAtData *data = CommandData(command);
+            TranslateMatrix(m, data->x, data->y);
+            ScaleMatrix(m, data->sx, data->sy);
+            TranslateMatrix(m, -data->x, -data->y);
+            return true;
+        }
+        case lurkCommandMultiplyTransform: {
+            const lurkMultiplyTransformData *data = CommandData(command);
+            *m = MultiplyMatrix(m, &data->matrix);
+            return true;
+        }
+        default:
+            return false;
     }
-    case lurkCommandDrawFilledRect: {
-        lurkDrawFilledRectData* data = (lurkDrawFilledRectData*)command->data;
-        sgp_draw_filled_rect(data->x, data->y, data->w, data->h);
-        break;
+}
+
+// Applies a run of transform commands as one matrix, so the mvp is only
+// recomputed once. Returns the size of the run in bytes.
+static size_t CollapseTransforms(const lurkCommandBuffer *buffer, size_t offset) {
+    sgp_mat2x3 transform = _sgp.state.transform;
+    size_t start = offset;
+    int count = 0;
+    while (offset < buffer->size) {
+        lurkCommand *command = (lurkCommand*)(buffer->data + offset);
+        if (!ApplyTransform(&transform, command))
+            break;
+        offset += command->size;
+        count++;
     }
-    case lurkCommandDrawTexturedRects: {
-        lurkDrawTexturedRectsData* data = (lurkDrawTexturedRectsData*)command->data;
-        sgp_draw_textured_rects(data->channel, data->rects, data->count);
-        break;
+    _sgp.state.transform = transform;
+    _sgp.state.mvp = _sgp_mul_proj_transform(&_sgp.state.proj, &_sgp.state.transform);
+    replayStats.transforms += count - 1;
+    return offset - start;
+}
+
+// Transform commands are the contiguous block Translate ... MultiplyTransform
+static bool IsTransformCommand(uint32_t type) {
+    return type >= lurkCommandTranslate && type <= lurkCommandMultiplyTransform;
+}
+
+static bool SameColor(sgp_color color, float r, float g, float b, float a) {
+    return color.r == r && color.g == g && color.b == b && color.a == a;
+}
+
+static bool SameRect(sgp_irect rect, int x, int y, int w, int h) {
+    return rect.x == x && rect.y == y && rect.w == w && rect.h == h;
+}
+
+// State commands that would leave the sokol_gp state as it already is
+static bool IsRedundantCommand(lurkCommand *command) {
+    const sgp_state *current = &_sgp.state;
+    switch (command->type) {
+        case lurkCommandSetColor: {
+            const lurkSetColorData *data = CommandData(command);
+            return SameColor(current->color, data->r, data->g, data->b, data->a);
+        }
+        case lurkCommandResetColor:
+            return SameColor(current->color, 1.f, 1.f, 1.f, 1.f);
+        case lurkCommandSetBlendMode: {
+            const lurkSetBlendModeData *data = CommandData(command);
+            return current->blend_mode == data->blend_mode;
+        }
+        case lurkCommandResetBlendMode:
+            return current->blend_mode == SGP_BLENDMODE_NONE;
+        case lurkCommandSetImage: {
+            const lurkSetImageData *data = CommandData(command);
+            return current->textures.images[data->channel].id == data->image.id;
+        }
+        case lurkCommandResetPipeline:
+            return current->pipeline.id == SG_INVALID_ID;
+        case lurkCommandSetUniform: {
+            const lurkSetUniformData *data = CommandData(command);
+            return current->uniform.size == data->size && !memcmp(current->uniform.content, data + 1, data->size);
+        }
+        case lurkCommandProject: {
+            const lurkProjectData *data = CommandData(command);
+            float w = data->right - data->left, h = data->top - data->bottom;
+            return current->proj.v[0][0] == 2.f / w && current->proj.v[0][1] == 0.f &&
+                   current->proj.v[0][2] == -(data->right + data->left) / w &&
+                   current->proj.v[1][0] == 0.f && current->proj.v[1][1] == 2.f / h &&
+                   current->proj.v[1][2] == -(data->top + data->bottom) / h;
+        }
+        case lurkCommandResetProject: {
+            sgp_mat2x3 proj = _sgp_default_proj(current->viewport.w, current->viewport.h);
+            return !memcmp(&current->proj, &proj, sizeof(sgp_mat2x3));
+        }
+        case lurkCommandViewport: {
+            const lurkViewportData *data = CommandData(command);
+            return SameRect(current->viewport, data->x, data->y, data->w, data->h);
+        }
+        case lurkCommandScissor: {
+            const lurkScissorData *data = CommandData(command);
+            return SameRect(current->scissor, data->x, data->y, data->w, data->h);
+        }
+        case lurkCommandSetLayer: {
+            const lurkSetLayerData *data = CommandData(command);
+            return sorter.layer == data->layer;
+        }
+        default:
+            return false;
     }
-    case lurkCommandDrawTexturedRect: {
-        lurkDrawTexturedRectData* data = (lurkDrawTexturedRectData*)command->data;
-        sgp_draw_textured_rect(data->channel, data->dest_rect, data->src_rect);
-        break;
+}
+
+static void ReplayCommands(const lurkCommandBuffer *buffer) {
+    size_t offset = 0;
+    while (offset < buffer->size) {
+        lurkCommand *command = (lurkCommand*)(buffer->data + offset);
+        if (IsTransformCommand(command->type)) {
+            offset += CollapseTransforms(buffer, offset);
+            continue;
+        }
+        offset += command->size;
+        replayStats.drawCommands += IsDrawCommand(command->type);
+        if (IsRedundantCommand(command))
+            replayStats.redundant++;
+        else if (state.sortDraws)
+            SortCommand(command);
+        else
+            ProcessCommand(command);
+    }
+}
+
+// Frame capture, see `captureFrames` and DEFAULT_CAPTURE_KEY. A capture is a
+// header followed by commands laid out the same as in a command buffer, except
+// that arrays are always inline and command lists are expanded. Two extra record
+// types mark the textures referenced (by id and size) and the end of each frame.
+#define LURK_CAPTURE_MAGIC (((uint32_t)'l') << 24 | ((uint32_t)'c') << 16 | ((uint32_t)'a') << 8 | ((uint32_t)'p'))
+#define LURK_CAPTURE_VERSION 1
+
+enum {
+    lurkCaptureTexture = lurkCommandCount,
+    lurkCaptureFrameEnd
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t commandCount; // captures only replay with the same command list
+    uint32_t frames;
+} lurkCaptureHeader;
+
+typedef struct {
+    uint64_t id;
+    int w, h;
+} lurkCaptureTextureData;
+
+static struct {
+    FILE *file;
+    int frames, framesLeft;
+    uint64_t *textures;
+    int textureCount, textureCapacity;
+} capture;
+
+static void WriteCaptureRecord(uint32_t type, const void *payload, size_t size, const void *array, size_t arraySize) {
+    static const unsigned char padding[8] = {0};
+    size_t total = LURK_COMMAND_ALIGN(size + arraySize);
+    lurkCommand header = {type, (uint32_t)(sizeof(lurkCommand) + total)};
+    fwrite(&header, sizeof(lurkCommand), 1, capture.file);
+    if (size)
+        fwrite(payload, size, 1, capture.file);
+    if (arraySize)
+        fwrite(array, arraySize, 1, capture.file);
+    if (total > size + arraySize)
+        fwrite(padding, total - size - arraySize, 1, capture.file);
+}
+
+static void CaptureTexture(uint64_t id, int w, int h) {
+    for (int i = 0; i < capture.textureCount; i++)
+        if (capture.textures[i] == id)
+            return;
+    if (capture.textureCount == capture.textureCapacity) {
+        capture.textureCapacity = capture.textureCapacity ? capture.textureCapacity * 2 : 8;
+        capture.textures = realloc(capture.textures, capture.textureCapacity * sizeof(uint64_t));
+    }
+    capture.textures[capture.textureCount++] = id;
+    lurkCaptureTextureData data = {id, w, h};
+    WriteCaptureRecord(lurkCaptureTexture, &data, sizeof(data), NULL, 0);
+}
+
+static void CaptureCommands(const lurkCommandBuffer *buffer);
+
+#define LURK_CAPTURE_ARRAY(NAME, TYPE, FIELD)                                                       \
+    case lurkCommand##NAME: {                                                                      \
+        const lurk##NAME##Data *payload = CommandData(command);                                    \
+        lurk##NAME##Data data = *payload;                                                          \
+        data.FIELD = NULL;                                                                         \
+        WriteCaptureRecord(command->type, &data, sizeof(data), LURK_PAYLOAD_ARRAY(payload, FIELD), \
+                           data.count * sizeof(TYPE));                                             \
+        return;                                                                                    \
+    }
+
+static void CaptureCommand(lurkCommand *command) {
+    switch (command->type) {
+        LURK_CAPTURE_ARRAY(DrawPoints, sgp_point, points)
+        LURK_CAPTURE_ARRAY(DrawLines, sgp_line, lines)
+        LURK_CAPTURE_ARRAY(DrawLinesStrip, sgp_point, points)
+        LURK_CAPTURE_ARRAY(DrawFilledTriangles, sgp_triangle, triangles)
+        LURK_CAPTURE_ARRAY(DrawFilledTrianglesStrip, sgp_point, points)
+        LURK_CAPTURE_ARRAY(DrawFilledRects, sgp_rect, rects)
+        LURK_CAPTURE_ARRAY(DrawTexturedRects, sgp_textured_rect, rects)
+        case lurkCommandSetImage: {
+            const lurkSetImageData *data = CommandData(command);
+            sg_image_desc desc = sg_query_image_desc(data->image);
+            CaptureTexture(data->texture, desc.width, desc.height);
+            break;
+        }
+        case lurkCommandCreateTexture: {
+            // Replays only need to know the texture exists, see lurkCaptureTexture
+            const lurkCreateTextureData *data = CommandData(command);
+            CaptureTexture(data->id, data->image->w, data->image->h);
+            return;
+        }
+        case lurkCommandCreateRenderTarget: {
+            const lurkCreateRenderTargetData *data = CommandData(command);
+            CaptureTexture(data->id, data->w, data->h);
+            return;
+        }
+        case lurkCommandDrawSpriteBatch: {
+            // Written inline, the same as a batch drawn into a command list
+            lurkSpriteBatch batch = SpriteBatchView(CommandData(command));
+            size_t size = SpriteBatchSize(batch.count);
+            unsigned char *arrays = malloc(size);
+            CopySpriteBatch(arrays, &batch);
+            lurkDrawSpriteBatchData data = {NULL, batch.count};
+            WriteCaptureRecord(command->type, &data, sizeof(data), arrays, size);
+            free(arrays);
+            return;
+        }
+        case lurkCommandCallCommandList: {
+            const lurkCallCommandListData *data = CommandData(command);
+            if (data->transformed) {
+                lurkMultiplyTransformData transform = {data->transform};
+                WriteCaptureRecord(lurkCommandPushTransform, NULL, 0, NULL, 0);
+                WriteCaptureRecord(lurkCommandMultiplyTransform, &transform, sizeof(transform), NULL, 0);
+            }
+            CaptureCommands(data->list);
+            if (data->transformed)
+                WriteCaptureRecord(lurkCommandPopTransform, NULL, 0, NULL, 0);
+            return;
+        }
+        default:
+            break;
     }
-    case lurkCommandCreateTexture: {
-        lurkCreateTextureData* data = (lurkCreateTextureData*)command->data;
-        uint64_t hash = MurmurHash((void*)data->name, strlen(data->name), 0);
-        imap_slot_t *slot = imap_assign(state.textureMap, hash);
-        assert(!slot);
-        lurkTexture* texture = EmptyTexture(data->image->w, data->image->h);
-        UpdateTexture(texture, data->image->buf, data->image->w, data->image->h);
-        imap_setval64(state.textureMap, slot, (uint64_t)texture);
-        break;
+    fwrite(command, command->size, 1, capture.file);
+}
+
+static void CaptureCommands(const lurkCommandBuffer *buffer) {
+    size_t offset = 0;
+    while (offset < buffer->size) {
+        lurkCommand *command = (lurkCommand*)(buffer->data + offset);
+        CaptureCommand(command);
+        offset += command->size;
     }
-    default:
-        abort();
+}
+
+#if !defined(LURK_HEADLESS)
+static void StartCapture(int frames) {
+    if (capture.file || frames <= 0)
+        return;
+    if (!(capture.file = fopen(DEFAULT_CAPTURE_PATH, "wb"))) {
+        fprintf(stderr, "[FILE ERROR] Failed to open \"%s\" for capture\n", DEFAULT_CAPTURE_PATH);
+        return;
     }
+    lurkCaptureHeader header = {LURK_CAPTURE_MAGIC, LURK_CAPTURE_VERSION, lurkCommandCount, frames};
+    fwrite(&header, sizeof(lurkCaptureHeader), 1, capture.file);
+    capture.frames = capture.framesLeft = frames;
+    capture.textureCount = 0;
+}
+#endif
+
+static void EndCaptureFrame(void) {
+    WriteCaptureRecord(lurkCaptureFrameEnd, NULL, 0, NULL, 0);
+    if (--capture.framesLeft)
+        return;
+    fclose(capture.file);
+    capture.file = NULL;
+    printf("Captured %d frames to \"%s\"\n", capture.frames, DEFAULT_CAPTURE_PATH);
+}
+
+// Queued draws point into the buffer, so it's only emptied and not released
+static void ReplayCommandBuffer(lurkCommandBuffer *buffer) {
+    replayStats.commandCount += buffer->count;
+    if (capture.file)
+        CaptureCommands(buffer);
+    ReplayCommands(buffer);
+    buffer->size = 0;
+    buffer->count = 0;
+}
+
+static int CompareSubmittedBuffers(const void *a, const void *b) {
+    const lurkCommandBuffer *ba = *(const lurkCommandBuffer**)a;
+    const lurkCommandBuffer *bb = *(const lurkCommandBuffer**)b;
+    if (ba->key != bb->key)
+        return ba->key < bb->key ? -1 : 1;
+    return ba->index < bb->index ? -1 : ba->index > bb->index;
+}
+
+// Moves the buffers submitted so far onto `frame`, once its callbacks have
+// returned. Anything submitted after goes to the next frame.
+static void CollectSubmitted(lurkCommandBuffer *frame) {
+    frame->submitted = __atomic_exchange_n(&state.submitted, NULL, __ATOMIC_ACQUIRE);
+}
+
+// Replays a frame's commands, merged with any buffers submitted to it
+static void ProcessCommandBuffer(lurkCommandBuffer *buffer) {
+    // Without the pipeline the frame is replayed from the buffer it was just
+    // recorded into, pipelined frames collect theirs at the swap
+    if (buffer == &state.commandBuffer)
+        CollectSubmitted(buffer);
+    static lurkCommandBuffer **submitted = NULL;
+    static int submittedCapacity = 0;
+    int submittedCount = 0;
+    for (lurkCommandBuffer *b = buffer->submitted; b; b = b->next) {
+        if (submittedCount == submittedCapacity) {
+            submittedCapacity = submittedCapacity ? submittedCapacity * 2 : 8;
+            submitted = realloc(submitted, submittedCapacity * sizeof(lurkCommandBuffer*));
+        }
+        submitted[submittedCount++] = b;
+    }
+    buffer->submitted = NULL;
+    // The list is newest first
+    for (int i = 0; i < submittedCount; i++)
+        submitted[i]->index = submittedCount - 1 - i;
+    if (submittedCount > 1)
+        qsort(submitted, submittedCount, sizeof(lurkCommandBuffer*), CompareSubmittedBuffers);
+
+    sorter.layer = 0;
+    replayStats.redundant = 0;
+    replayStats.transforms = 0;
+    replayStats.drawCommands = 0;
+    replayStats.commandCount = 0;
+    int i = 0;
+    for (; i < submittedCount && submitted[i]->key < 0; i++)
+        ReplayCommandBuffer(submitted[i]);
+    ReplayCommandBuffer(buffer);
+    for (; i < submittedCount; i++)
+        ReplayCommandBuffer(submitted[i]);
+    FlushSortedDraws();
+    // Targets left open by the scene end with the frame
+    while (targets.depth)
+        EndRenderTarget();
+    if (capture.file)
+        EndCaptureFrame();
+    for (i = 0; i < submittedCount; i++)
+        __atomic_store_n(&submitted[i]->pending, false, __ATOMIC_RELEASE);
 }
 #endif
 
@@ -1167,7 +2077,19 @@ static FILETIME Win32GetLastWriteTime(char* path) {
 }
 #endif
 
-#if !defined(LURK_SCENE)
+#if !defined(LURK_SCENE)
+static bool LibraryModified(const char *path) {
+#if defined(LURK_DISABLE_HOTRELOAD)
+    return false;
+#elif defined(LURK_WINDOWS)
+    FILETIME newTime = Win32GetLastWriteTime(path);
+    return CompareFileTime(&newTime, &state.libraryWriteTime);
+#else
+    struct stat attr;
+    return !stat(path, &attr) && state.libraryHandleID != attr.st_ino;
+#endif
+}
+
 static bool ReloadLibrary(const char *path) {
 #if defined(LURK_DISABLE_HOTRELOAD)
     return true;
@@ -1226,6 +2148,7 @@ static bool ReloadLibrary(const char *path) {
     } else {
         if (state.libraryScene->reload)
             state.libraryScene->reload(&state, state.libraryContext);
+        state.reloadCount++;
     }
     state.libraryPath = path;
     return true;
@@ -1242,6 +2165,206 @@ BAIL:
     return false;
 }
 
+// MARK: Threads
+
+#if defined(LURK_POSIX)
+typedef pthread_t lurkThread;
+typedef pthread_mutex_t lurkMutex;
+typedef pthread_cond_t lurkCondition;
+
+static bool ThreadCreate(lurkThread *thread, void*(*func)(void*)) {
+    return !pthread_create(thread, NULL, func, NULL);
+}
+
+static void ThreadJoin(lurkThread *thread) {
+    pthread_join(*thread, NULL);
+}
+
+#define MutexInit(M) pthread_mutex_init((M), NULL)
+#define MutexDestroy(M) pthread_mutex_destroy(M)
+#define MutexLock(M) pthread_mutex_lock(M)
+#define MutexUnlock(M) pthread_mutex_unlock(M)
+#define ConditionInit(C) pthread_cond_init((C), NULL)
+#define ConditionDestroy(C) pthread_cond_destroy(C)
+#define ConditionWait(C, M) pthread_cond_wait((C), (M))
+#define ConditionBroadcast(C) pthread_cond_broadcast(C)
+#else
+typedef HANDLE lurkThread;
+typedef CRITICAL_SECTION lurkMutex;
+typedef CONDITION_VARIABLE lurkCondition;
+
+static DWORD WINAPI Win32ThreadProc(LPVOID func) {
+    ((void*(*)(void*))func)(NULL);
+    return 0;
+}
+
+static bool ThreadCreate(lurkThread *thread, void*(*func)(void*)) {
+    *thread = CreateThread(NULL, 0, Win32ThreadProc, (LPVOID)func, 0, NULL);
+    return *thread != NULL;
+}
+
+static void ThreadJoin(lurkThread *thread) {
+    WaitForSingleObject(*thread, INFINITE);
+    CloseHandle(*thread);
+}
+
+#define MutexInit(M) InitializeCriticalSection(M)
+#define MutexDestroy(M) DeleteCriticalSection(M)
+#define MutexLock(M) EnterCriticalSection(M)
+#define MutexUnlock(M) LeaveCriticalSection(M)
+#define ConditionInit(C) InitializeConditionVariable(C)
+#define ConditionDestroy(C)
+#define ConditionWait(C, M) SleepConditionVariableCS((C), (M), INFINITE)
+#define ConditionBroadcast(C) WakeAllConditionVariable(C)
+#endif
+
+// MARK: Frame pipeline
+
+// With `maxFrameLatency` set the scene runs on a record thread. It records frame
+// N+1 into `state.commandBuffer` while the main thread replays frame N from
+// `state.renderBuffer` and submits it. The buffers are swapped between frames,
+// which is also the only time the main thread touches scene-visible state
+// (window events, the texture map, frame stats, reloading the library). The
+// program and the bench host share it, each with their own `record` (run on the
+// record thread) and renderer (see PipelineFrame). The entry points are inline
+// as the other tools don't pipeline.
+static struct {
+    lurkThread thread;
+    lurkMutex lock;
+    lurkCondition cond;
+    bool running;
+    bool recording;
+    void (*record)(void);
+} pipeline;
+
+static void* RecordThread(void *arg) {
+    for (;;) {
+        MutexLock(&pipeline.lock);
+        while (pipeline.running && !pipeline.recording)
+            ConditionWait(&pipeline.cond, &pipeline.lock);
+        if (!pipeline.running) {
+            MutexUnlock(&pipeline.lock);
+            break;
+        }
+        MutexUnlock(&pipeline.lock);
+
+        pipeline.record();
+
+        MutexLock(&pipeline.lock);
+        pipeline.recording = false;
+        ConditionBroadcast(&pipeline.cond);
+        MutexUnlock(&pipeline.lock);
+    }
+    return NULL;
+}
+
+static inline void KickRecord(void) {
+    MutexLock(&pipeline.lock);
+    pipeline.recording = true;
+    ConditionBroadcast(&pipeline.cond);
+    MutexUnlock(&pipeline.lock);
+}
+
+static inline void WaitForRecord(void) {
+    MutexLock(&pipeline.lock);
+    while (pipeline.recording)
+        ConditionWait(&pipeline.cond, &pipeline.lock);
+    MutexUnlock(&pipeline.lock);
+}
+
+// Frames are recorded on the main thread instead when it can't be started
+static inline bool StartPipeline(void (*record)(void)) {
+    MutexInit(&pipeline.lock);
+    ConditionInit(&pipeline.cond);
+    pipeline.running = true;
+    pipeline.recording = false;
+    pipeline.record = record;
+    if (ThreadCreate(&pipeline.thread, RecordThread))
+        return true;
+    fprintf(stderr, "[THREAD ERROR] Failed to start the record thread, frames won't be pipelined\n");
+    pipeline.running = false;
+    ConditionDestroy(&pipeline.cond);
+    MutexDestroy(&pipeline.lock);
+    state.maxFrameLatency = 0;
+    return false;
+}
+
+static inline void StopPipeline(void) {
+    WaitForRecord();
+    MutexLock(&pipeline.lock);
+    pipeline.running = false;
+    ConditionBroadcast(&pipeline.cond);
+    MutexUnlock(&pipeline.lock);
+    ThreadJoin(&pipeline.thread);
+    ConditionDestroy(&pipeline.cond);
+    MutexDestroy(&pipeline.lock);
+}
+
+static inline void SwapCommandBuffers(void) {
+    lurkCommandBuffer tmp = state.commandBuffer;
+    state.commandBuffer = state.renderBuffer;
+    state.renderBuffer = tmp;
+    CollectSubmitted(&state.renderBuffer);
+}
+
+// What the main thread measures while it renders, kept out of lurkState until
+// the swap. The overlay reads them from here too, along with the record
+// thread's own stats as of that swap.
+static struct {
+    double frameTime, recordTime, renderTime; // milliseconds
+    int drawCalls, fixedUpdates;
+    int gpCommands, gpVertices, culledPrimitives;
+    float resolutionScale;
+} frameStats;
+
+// Only while the record thread is idle
+static inline void PublishFrameStats(void) {
+    state.frameTime = frameStats.frameTime;
+    state.renderTime = frameStats.renderTime;
+    state.drawCalls = frameStats.drawCalls;
+    state.gpCommands = frameStats.gpCommands;
+    state.gpVertices = frameStats.gpVertices;
+    state.culledPrimitives = frameStats.culledPrimitives;
+    state.resolutionScale = frameStats.resolutionScale;
+    PublishReplayStats();
+    frameStats.recordTime = state.recordTime;
+    frameStats.fixedUpdates = state.fixedUpdates;
+}
+
+static inline void UpdateLibrary(void) {
+    lurkProfileBegin(&state, "ReloadLibrary");
+    if (state.nextScene) {
+        assert(ReloadLibrary(state.nextScene));
+        state.nextScene = NULL;
+    }
+#if !defined(LURK_DISABLE_HOTRELOAD)
+    else
+        assert(ReloadLibrary(state.libraryPath));
+#endif
+    lurkProfileEnd(&state);
+}
+
+// One pipelined frame, called once the record thread is idle (after
+// WaitForRecord). Swaps in the frame it just recorded, starts it on the next one
+// and replays the swapped frame with `render` in the meantime.
+static inline void PipelineFrame(void (*render)(lurkCommandBuffer*)) {
+    PublishFrameStats();
+    FlushPendingTextures();
+    SwapCommandBuffers();
+    if (state.nextScene || LibraryModified(state.libraryPath)) {
+        // The pending frame was recorded by the current library, so
+        // it has to be replayed before the library is unloaded
+        render(&state.renderBuffer);
+        UpdateLibrary();
+        KickRecord();
+    } else {
+        KickRecord();
+        render(&state.renderBuffer);
+    }
+}
+#endif
+
+#if !defined(LURK_SCENE) && !defined(LURK_HEADLESS)
 static void Usage(const char *name) {
     printf("  usage: %s [options]\n\n  options:\n", name);
     printf("\t  help (flag) -- Show this message\n");
@@ -1259,7 +2382,7 @@ static int LoadConfig(const char *path) {
 
     const struct json_attr_t config_attr[] = {
 #define X(NAME, TYPE, VAL, DEFAULT,DOCS) \
-        {(char*)#NAME, t_##TYPE, .addr.TYPE=&state.desc.VAL},
+        {(char*)NAME, t_##TYPE, .addr.TYPE=&state.VAL},
         SETTINGS
 #undef X
         {NULL}
@@ -1284,7 +2407,7 @@ static int ExportConfig(const char *path) {
     jim_object_begin(&jim);
 #define X(NAME, TYPE, VAL, DEFAULT, DOCS) \
     jim_member_key(&jim, NAME);           \
-    jim_##TYPE(&jim, state.desc.VAL);
+    jim_##TYPE(&jim, state.VAL);
     SETTINGS
 #undef X
     jim_object_end(&jim);
@@ -1338,10 +2461,10 @@ static int ParseArguments(int argc, char *argv[]) {
             Usage(name);                                                                \
             return 0;                                                                   \
         }                                                                               \
-        if (TYPE == 1)                                                                  \
-            state.desc.VAL = (int)atoi(tmp);                                            \
+        if (TYPE == integer)                                                            \
+            state.VAL = (int)atoi(tmp);                                                 \
         else                                                                            \
-            state.desc.VAL = sargs_boolean(NAME);                                       \
+            state.VAL = sargs_boolean(NAME);                                            \
     }
     SETTINGS
 #undef X
@@ -1472,6 +2595,28 @@ static void GamepadDeviceAttached(struct Gamepad_device* device, void* context)
 static void GamepadDeviceRemoved(struct Gamepad_device* device, void* context) {
 }
 
+// MARK: Frame pipeline
+
+#if !defined(LURK_MAX_QUEUED_EVENTS)
+#define LURK_MAX_QUEUED_EVENTS 64
+#endif
+
+// Events that arrive while the record thread is running, handled at the swap
+static struct {
+    sapp_event events[LURK_MAX_QUEUED_EVENTS];
+    int count;
+} queuedEvents;
+
+static void HandleEvent(const sapp_event *e);
+static void RecordPipelinedFrame(void);
+static void StartPacingLog(void);
+
+static void FlushQueuedEvents(void) {
+    for (int i = 0; i < queuedEvents.count; i++)
+        HandleEvent(&queuedEvents.events[i]);
+    queuedEvents.count = 0;
+}
+
 static void InitCallback(void) {
     sg_desc desc = (sg_desc) {
         // TODO: Add more configuration options for sg_desc
@@ -1479,7 +2624,13 @@ static void InitCallback(void) {
     };
     sg_setup(&desc);
     stm_setup();
-    sgp_desc desc_sgp = (sgp_desc) {};
+#if defined(LURK_ENABLE_PROFILER)
+    state.profiler.now = stm_now;
+#endif
+    sgp_desc desc_sgp = (sgp_desc) {
+        .max_vertices = state.maxVertices,
+        .max_commands = state.maxDrawCommands
+    };
     sgp_setup(&desc_sgp);
     assert(sg_isvalid() && sgp_is_valid());
 #if !defined(LURK_DISABLE_HOTRELOAD)
@@ -1501,41 +2652,10 @@ static void InitCallback(void) {
     state.windowHeight = sapp_height();
     state.clearColor = (sg_color){0.39f, 0.58f, 0.92f, 1.f};
 
-#if defined(LURK_MAC)
-    mach_timebase_info_data_t info;
-    mach_timebase_info(&info);
-    uint64_t frequency = info.denom;
-    frequency *= 1000000000L;
-    state.timerFrequency = frequency / info.numer;
-#elif defined(LURK_WINDOW)
-    LARGE_INTEGER frequency;
-    if (!QueryPerformanceFrequency(&frequency))
-        return 1000L;
-    state.timerFrequency = frequency.QuadPart;
-#else
+    // Frame times come from stm_now, which is in nanoseconds on every platform
     state.timerFrequency = 1000000000L;
-#endif
 
-    state.updateMultiplicity = 1;
-#if defined(LURK_UNLOCKFRAME_RATE)
-    state.unlockFramerate = 1;
-#else
-    state.unlockFramerate = 0;
-#endif
-    state.desiredFrameTime = state.timerFrequency * DEFAULT_TARGET_FPS;
-    state.fixedDeltaTime = 1.0 / DEFAULT_TARGET_FPS;
-    int64_t time60hz = state.timerFrequency / 60;
-    state.snapFrequencies[0] = time60hz;
-    state.snapFrequencies[1] = time60hz*2;
-    state.snapFrequencies[2] = time60hz*3;
-    state.snapFrequencies[3] = time60hz*4;
-    state.snapFrequencies[4] = (time60hz+1)/2;
-    state.snapFrequencies[5] = (time60hz+2)/3;
-    state.snapFrequencies[6] = (time60hz+3)/4;
-    state.maxVsyncError = state.timerFrequency * .0002;
-    for (int i = 0; i < 4; i++)
-        state.timeAverager[i] = state.desiredFrameTime;
-    state.resync = true;
+    UpdateTimestep(&state);
     state.prevFrameTime = stm_now();
     state.frameAccumulator = 0;
 
@@ -1544,19 +2664,97 @@ static void InitCallback(void) {
     state.nextScene = NULL;
     lurkSwapToScene(&state, LURK_FIRST_SCENE);
     assert(ReloadLibrary(state.nextScene));
+    state.nextScene = NULL;
+
+    if (state.maxFrameLatency < 0)
+        state.maxFrameLatency = 0;
+    if (state.maxFrameLatency > 1)
+        state.maxFrameLatency = 1;
+    if (state.maxFrameLatency)
+        StartPipeline(RecordPipelinedFrame);
+    StartCapture(state.captureFrames);
+    if (state.pacingLog)
+        StartPacingLog();
 }
 
-static void ProcessCommandQueue(void) {
-    while (state.commandQueue.front) {
-        lurkCommand *command = (lurkCommand*)state.commandQueue.front->data;
-        ProcessCommand(command);
-        FreeCommand(command);
-        ezStackEntry *head = ezStackShift(&state.commandQueue);
-        free(head);
+// MARK: Pacing
+
+// What the fixed timestep loop did with each frame, all times in milliseconds
+typedef struct {
+    double raw;     // measured since the last frame
+    double snapped; // after clamping and snapping to a vsync multiple
+    double delta;   // after averaging (and resyncing), what the accumulator was given
+    double alpha;   // render interpolation passed to `frame`
+    int fixedUpdates;
+    bool resync;
+} lurkPacingRecord;
+
+// The last LURK_PACING_HISTORY frames are always kept for the summary, every
+// frame is also written to DEFAULT_PACING_PATH when `pacingLog` is set
+static struct {
+    lurkPacingRecord records[LURK_PACING_HISTORY];
+    int count, index;
+    uint64_t frames;
+    int resyncs;
+    FILE *file;
+} pacing;
+
+static void StartPacingLog(void) {
+    if (!(pacing.file = fopen(DEFAULT_PACING_PATH, "w"))) {
+        fprintf(stderr, "[FILE ERROR] Failed to open \"%s\"\n", DEFAULT_PACING_PATH);
+        return;
     }
+    fprintf(pacing.file, "frame,raw,snapped,delta,alpha,fixedUpdates,resync\n");
+}
+
+static void RecordPacing(const lurkPacingRecord *record) {
+    pacing.records[pacing.index] = *record;
+    pacing.index = (pacing.index + 1) % LURK_PACING_HISTORY;
+    if (pacing.count < LURK_PACING_HISTORY)
+        pacing.count++;
+    pacing.resyncs += record->resync;
+    if (pacing.file)
+        fprintf(pacing.file, "%llu,%.4f,%.4f,%.4f,%.4f,%d,%d\n", (unsigned long long)pacing.frames,
+                record->raw, record->snapped, record->delta, record->alpha, record->fixedUpdates, record->resync);
+    pacing.frames++;
+}
+
+static int CompareDoubles(const void *a, const void *b) {
+    double da = *(const double*)a, db = *(const double*)b;
+    return da < db ? -1 : da > db;
+}
+
+#define LURK_PACING_FIELDS      \
+    X(raw, "raw delta")         \
+    X(snapped, "snapped delta") \
+    X(delta, "averaged delta")  \
+    X(alpha, "alpha")
+
+static void PrintPacingSummary(void) {
+    if (!pacing.count)
+        return;
+    int n = pacing.count;
+    double values[LURK_PACING_HISTORY];
+    printf("[PACING] last %d of %llu frames, target %.3f ms, %d resyncs in total\n",
+           n, (unsigned long long)pacing.frames, 1000.0 / state.tickRate, pacing.resyncs);
+#define PACING_PERCENTILE(P) values[(int)((P) * (n - 1) + .5)]
+#define X(FIELD, NAME)                                                              \
+    for (int i = 0; i < n; i++)                                                     \
+        values[i] = pacing.records[i].FIELD;                                        \
+    qsort(values, n, sizeof(double), CompareDoubles);                               \
+    printf("[PACING] %-14s p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f\n", NAME,     \
+           PACING_PERCENTILE(.5), PACING_PERCENTILE(.95), PACING_PERCENTILE(.99), values[n - 1]);
+    LURK_PACING_FIELDS
+#undef X
+    int updates[4] = {0}; // frames that ran 0, 1, 2 and 3+ fixed updates
+    for (int i = 0; i < n; i++)
+        updates[pacing.records[i].fixedUpdates < 3 ? pacing.records[i].fixedUpdates : 3]++;
+    printf("[PACING] fixed updates  0: %d  1: %d  2: %d  3+: %d\n", updates[0], updates[1], updates[2], updates[3]);
+#undef PACING_PERCENTILE
 }
 
 static void CallFixedUpdate(void) {
+    state.fixedUpdates++;
     if (state.libraryScene->fixedupdate)
         state.libraryScene->fixedupdate(&state, state.libraryContext, state.fixedDeltaTime);
 #if !defined(LURK_ECS_VARIABLE_TICK)
@@ -1572,38 +2770,20 @@ static void CallVarUpdate(float delta) {
 #endif
 }
 
-static void FrameCallback(void) {
-    if (state.fullscreen != state.fullscreenLast) {
-        sapp_toggle_fullscreen();
-        state.fullscreenLast = state.fullscreen;
-    }
-
-    if (state.cursorVisible != state.cursorVisibleLast) {
-        sapp_show_mouse(state.cursorVisible);
-        state.cursorVisibleLast = state.cursorVisible;
-    }
-
-    if (state.cursorLocked != state.cursorLockedLast) {
-        sapp_lock_mouse(state.cursorLocked);
-        state.cursorLockedLast = state.cursorLocked;
-    }
-
-    if (state.nextScene) {
-        assert(ReloadLibrary(state.nextScene));
-        state.nextScene = NULL;
-    } else
-#if !defined(LURK_DISABLE_HOTRELOAD)
-        assert(ReloadLibrary(state.libraryPath));
-#endif
-
-    if (state.libraryScene->preframe) {
-        state.libraryScene->preframe(&state, state.libraryContext);
-        ProcessCommandQueue();
-    }
+// Runs the scene for one frame, everything it draws is recorded into `state.commandBuffer`
+static void RecordFrame(void) {
+    uint64_t recordStart = stm_now();
+    lurkProfileBegin(&state, "RecordFrame");
+    state.fixedUpdates = 0;
+    if (state.libraryScene->preframe)
+        LURK_PROFILE(&state, "preframe")
+            state.libraryScene->preframe(&state, state.libraryContext);
 
     int64_t current_frame_time = stm_now();
     int64_t delta_time = current_frame_time - state.prevFrameTime;
     state.prevFrameTime = current_frame_time;
+    const double toMs = 1000.0 / state.timerFrequency;
+    lurkPacingRecord pacingRecord = {.raw = delta_time * toMs};
 
     if (delta_time > state.desiredFrameTime * 8)
         delta_time = state.desiredFrameTime;
@@ -1615,6 +2795,7 @@ static void FrameCallback(void) {
             delta_time = state.snapFrequencies[i];
             break;
         }
+    pacingRecord.snapped = delta_time * toMs;
 
     for (int i = 0; i < 3; ++i)
         state.timeAverager[i] = state.timeAverager[i + 1];
@@ -1631,9 +2812,12 @@ static void FrameCallback(void) {
         state.frameAccumulator = 0;
         delta_time = state.desiredFrameTime;
         state.resync = false;
+        pacingRecord.resync = true;
     }
+    pacingRecord.delta = delta_time * toMs;
 
     double render_time = 1.0;
+    lurkProfileBegin(&state, "update");
     if (state.unlockFramerate) {
         int64_t consumedDeltaTime = delta_time;
 
@@ -1655,31 +2839,663 @@ static void FrameCallback(void) {
                 CallVarUpdate(state.fixedDeltaTime);
                 state.frameAccumulator -= state.desiredFrameTime;
             }
+    lurkProfileEnd(&state);
 
-    sgp_begin(state.windowWidth, state.windowHeight);
     if (state.libraryScene->frame)
-        state.libraryScene->frame(&state, state.libraryContext, render_time);
-    ProcessCommandQueue();
+        LURK_PROFILE(&state, "frame")
+            state.libraryScene->frame(&state, state.libraryContext, render_time);
 
-    state.pass_action.colors[0].clear_value = state.clearColor;
-    sg_begin_default_pass(&state.pass_action, state.windowWidth, state.windowHeight);
+    state.modifiers = 0;
+    state.mouse.scroll.x = 0.f;
+    state.mouse.scroll.y = 0.f;
+    lurkProfileEnd(&state);
+    pacingRecord.alpha = render_time;
+    pacingRecord.fixedUpdates = state.fixedUpdates;
+    RecordPacing(&pacingRecord);
+    state.recordTime = stm_ms(stm_since(recordStart));
+}
+
+// What the record thread runs, postframe goes with the frame it follows
+static void RecordPipelinedFrame(void) {
+    RecordFrame();
+    if (state.libraryScene->postframe)
+        LURK_PROFILE(&state, "postframe")
+            state.libraryScene->postframe(&state, state.libraryContext);
+}
+
+// MARK: Idle
+
+#if !defined(LURK_IDLE_SETTLE_FRAMES)
+#define LURK_IDLE_SETTLE_FRAMES 1 // frames drawn after the last change before going idle
+#endif
+
+#if !defined(LURK_IDLE_MAX_CATCHUP)
+#define LURK_IDLE_MAX_CATCHUP 4 // ticks of idle time caught up on waking, under the 8 that resync
+#endif
+
+// On Metal nothing is presented when a frame never calls sg_commit, and a WebGL
+// canvas keeps showing its last frame until it's drawn to again, so there a
+// skipped frame leaves the swapchain alone. On GL and D3D11 sokol_app swaps
+// after every frame callback whether anything was drawn or not. There the
+// window's pass goes into `target` while idle mode is on, and every frame
+// copies it to the swapchain. Skipped frames only do the copy, which is one
+// textured rect.
+#if defined(SOKOL_METAL) || defined(LURK_EMSCRIPTEN)
+#define LURK_IDLE_SKIPS_PRESENT
+#endif
+
+static struct {
+    lurkRenderTarget target;
+    sg_pass_action copy;
+    int settle;        // frames left to draw before going idle
+    int w, h;          // size of the last frame drawn
+    uint64_t wakeTime; // stm_now ticks, 0 when no redraw is scheduled
+} idle = {
+    .settle = LURK_IDLE_SETTLE_FRAMES,
+    .copy.colors[0].load_action = SG_LOADACTION_DONTCARE
+};
+
+// Frames are never skipped with the pipeline running
+static bool KeepFrame(void) {
+#if defined(LURK_IDLE_SKIPS_PRESENT)
+    return false;
+#else
+    return state.idleMode && !pipeline.running;
+#endif
+}
+
+// Starts the pass that ends up in the window, `action` is what it would have
+// used as the default pass
+static void BeginWindowPass(const sg_pass_action *action) {
+    if (!KeepFrame()) {
+        DestroyRenderTarget(&idle.target);
+        sg_begin_default_pass(action, state.windowWidth, state.windowHeight);
+        return;
+    }
+    if (idle.target.w != state.windowWidth || idle.target.h != state.windowHeight) {
+        DestroyRenderTarget(&idle.target);
+        MakeRenderTarget(&idle.target, state.windowWidth, state.windowHeight);
+    }
+    sg_begin_pass(idle.target.pass, action);
+}
+
+// Copies the kept frame to the swapchain, sokol_gp has to be between frames
+static void PresentIdleFrame(void) {
+    sgp_begin(state.windowWidth, state.windowHeight);
+    sg_begin_default_pass(&idle.copy, state.windowWidth, state.windowHeight);
+    DrawRenderTarget(&idle.target, idle.target.w, idle.target.h,
+                     (sgp_rect){0.f, 0.f, (float)state.windowWidth, (float)state.windowHeight});
     sgp_flush();
     sgp_end();
     sg_end_pass();
+}
+
+static void WakeFromIdle(void) {
+    idle.settle = LURK_IDLE_SETTLE_FRAMES;
+}
+
+static void ScheduleRedraw(void) {
+    if (state.redrawDelay <= 0.0)
+        return;
+    uint64_t wakeTime = stm_now() + (uint64_t)(state.redrawDelay * 1e9);
+    if (!idle.wakeTime || wakeTime < idle.wakeTime)
+        idle.wakeTime = wakeTime;
+    state.redrawDelay = 0.0;
+}
+
+// Whether this frame has to be drawn
+static bool IdleRedraw(bool changed) {
+    ScheduleRedraw();
+    if (idle.wakeTime && stm_now() >= idle.wakeTime) {
+        idle.wakeTime = 0;
+        changed = true;
+    }
+    if (changed || state.redrawRequested || !state.idleMode || capture.file)
+        WakeFromIdle();
+    state.redrawRequested = false;
+    // The window changed size since the last frame, or nothing has been kept to show yet
+    if (idle.w != state.windowWidth || idle.h != state.windowHeight)
+        WakeFromIdle();
+#if !defined(LURK_IDLE_SKIPS_PRESENT)
+    if (idle.target.w != state.windowWidth || idle.target.h != state.windowHeight)
+        WakeFromIdle();
+#endif
+    if (idle.settle) {
+        idle.settle--;
+        idle.w = state.windowWidth;
+        idle.h = state.windowHeight;
+        return true;
+    }
+
+    // Fixed updates don't run while idle, the time is added to the accumulator
+    // instead and caught up on waking, up to LURK_IDLE_MAX_CATCHUP ticks of it
+    int64_t now = stm_now();
+    state.frameAccumulator += now - state.prevFrameTime;
+    if (state.frameAccumulator > state.desiredFrameTime * LURK_IDLE_MAX_CATCHUP)
+        state.frameAccumulator = state.desiredFrameTime * LURK_IDLE_MAX_CATCHUP;
+    state.prevFrameTime = now;
+#if !defined(LURK_IDLE_SKIPS_PRESENT)
+    PresentIdleFrame();
     sg_commit();
+    // Without vsync presenting the same frame again doesn't wait on anything
+    if (!state.desc.swap_interval) {
+#if defined(LURK_WINDOWS)
+        Sleep((DWORD)(state.desiredFrameTime / 1000000));
+#else
+        usleep((useconds_t)(state.desiredFrameTime / 1000));
+#endif
+    }
+#endif
+    return false;
+}
 
-    state.modifiers = 0;
-    state.mouse.scroll.x = 0.f;
-    state.mouse.scroll.y = 0.f;
+// MARK: Virtual resolution
 
-    if (state.libraryScene->postframe)
-        state.libraryScene->postframe(&state, state.libraryContext);
+// The scene draws into a target the size of the virtual resolution, which is
+// then scaled up to the window with nearest filtering, centred with black
+// borders. Dynamic resolution is ignored while this is on.
+static struct {
+    lurkRenderTarget target;
+    sg_pass_action border;
+} screen = {
+    .border.colors[0] = {
+        .load_action = SG_LOADACTION_CLEAR,
+        .clear_value = {0.f, 0.f, 0.f, 1.f}
+    }
+};
+
+static bool VirtualResolution(void) {
+    return state.virtualWidth > 0 && state.virtualHeight > 0;
 }
 
-static void EventCallback(const sapp_event* e) {
+// Where the virtual screen goes in the window
+static sgp_rect VirtualRect(void) {
+    float sx = (float)state.windowWidth / state.virtualWidth;
+    float sy = (float)state.windowHeight / state.virtualHeight;
+    float scale = sx < sy ? sx : sy;
+    // Windows smaller than the virtual resolution can't fit a whole multiple
+    if (state.integerScale && scale >= 1.f)
+        scale = floorf(scale);
+    float w = state.virtualWidth * scale, h = state.virtualHeight * scale;
+    return (sgp_rect){floorf((state.windowWidth - w) / 2.f), floorf((state.windowHeight - h) / 2.f), w, h};
+}
+
+static void WindowToVirtual(float *x, float *y) {
+    sgp_rect rect = VirtualRect();
+    *x = floorf((*x - rect.x) * state.virtualWidth / rect.w);
+    *y = floorf((*y - rect.y) * state.virtualHeight / rect.h);
+}
+
+static void SubmitVirtualFrame(void) {
+    if (screen.target.w != state.virtualWidth || screen.target.h != state.virtualHeight) {
+        DestroyRenderTarget(&screen.target);
+        MakeRenderTarget(&screen.target, state.virtualWidth, state.virtualHeight);
+    }
+    sg_begin_pass(screen.target.pass, &state.pass_action);
+    LURK_PROFILE(&state, "sgp_flush")
+        FlushCommands();
+    sgp_end();
+    sg_end_pass();
+
+    sgp_begin(state.windowWidth, state.windowHeight);
+    BeginWindowPass(&screen.border);
+    DrawRenderTarget(&screen.target, screen.target.w, screen.target.h, VirtualRect());
+}
+
+// MARK: Dynamic resolution
+
+#if !defined(LURK_RESOLUTION_SAMPLE_FRAMES)
+#define LURK_RESOLUTION_SAMPLE_FRAMES 30 // frames averaged before the scale is changed
+#endif
+
+#if !defined(LURK_RESOLUTION_PROBE_WAIT)
+#define LURK_RESOLUTION_PROBE_WAIT 4 // samples in budget before trying a higher scale
+#endif
+
+#if !defined(LURK_RESOLUTION_MAX_PROBE_WAIT)
+#define LURK_RESOLUTION_MAX_PROBE_WAIT 64 // the wait doubles each time a higher scale doesn't hold
+#endif
+
+#define LURK_RESOLUTION_STEP .05f
+
+// The scene still records in window coordinates, sokol_gp's vertices come out
+// in clip space so only viewport and scissor commands need scaling when
+// they're flushed into the smaller target. The target is made at the largest
+// scale so changing the scale never reallocates it, only resizing the window does.
+static struct {
+    lurkRenderTarget target;
+    sg_sampler sampler;
+    double frameTime;
+    int frames;
+    int calm;   // samples in budget since the scale last changed
+    int wait;   // samples in budget before trying a higher scale
+    bool probe; // the last change was a step up without measured headroom
+    int w, h;   // this frame
+} resolution;
+
+// Milliseconds a frame has at `targetFrameRate`
+static double FrameBudget(void) {
+    return 1000.0 / (state.targetFrameRate > 0 ? state.targetFrameRate : DEFAULT_TARGET_FRAME_RATE);
+}
+
+static float ResolutionScaleLimit(int percent) {
+    float scale = percent / 100.f;
+    return scale < .1f ? .1f : scale > 1.f ? 1.f : scale;
+}
+
+// A frame that misses the budget is usually stuck waiting on the GPU, so a scale
+// that fits can only be told from one that barely does with vsync off. With it
+// on, every frame in budget takes the same time and the controller has to try
+// the next step up to find out. Each time that fails it waits twice as long.
+static void UpdateResolutionScale(void) {
+    const double budget = FrameBudget();
+    float minScale = ResolutionScaleLimit(state.minResolutionScale);
+    float maxScale = ResolutionScaleLimit(state.maxResolutionScale);
+    if (minScale > maxScale)
+        minScale = maxScale;
+    if (!resolution.wait)
+        resolution.wait = LURK_RESOLUTION_PROBE_WAIT;
+    // Hitches (reloads, loading, waking from idle) aren't something a lower resolution fixes
+    if (frameStats.frameTime < budget * 4) {
+        resolution.frameTime += frameStats.frameTime;
+        resolution.frames++;
+    }
+
+    float scale = frameStats.resolutionScale > 0.f ? frameStats.resolutionScale : maxScale;
+    if (resolution.frames >= LURK_RESOLUTION_SAMPLE_FRAMES) {
+        double average = resolution.frameTime / resolution.frames;
+        double slack = budget * state.resolutionHysteresis / 100.0;
+        bool probe = resolution.probe;
+        resolution.frameTime = 0.0;
+        resolution.frames = 0;
+        resolution.probe = false;
+        if (average > budget + slack) {
+            if (probe && resolution.wait < LURK_RESOLUTION_MAX_PROBE_WAIT)
+                resolution.wait *= 2;
+            // Fill cost goes with the pixel count, the square of the scale
+            float next = scale * sqrtf((float)(budget / average));
+            scale = next < scale - LURK_RESOLUTION_STEP ? next : scale - LURK_RESOLUTION_STEP;
+            resolution.calm = 0;
+        } else if (average < budget - slack) {
+            scale += LURK_RESOLUTION_STEP;
+            resolution.calm = 0;
+        } else if (++resolution.calm >= resolution.wait && scale < maxScale) {
+            scale += LURK_RESOLUTION_STEP;
+            resolution.calm = 0;
+            resolution.probe = true;
+        }
+    }
+    frameStats.resolutionScale = scale < minScale ? minScale : scale > maxScale ? maxScale : scale;
+
+    int w = (int)(state.windowWidth * maxScale + .5f);
+    int h = (int)(state.windowHeight * maxScale + .5f);
+    if (resolution.target.w != w || resolution.target.h != h) {
+        DestroyRenderTarget(&resolution.target);
+        MakeRenderTarget(&resolution.target, w, h);
+    }
+    if (resolution.sampler.id == SG_INVALID_ID)
+        resolution.sampler = sg_make_sampler(&(sg_sampler_desc) {
+            .min_filter = SG_FILTER_LINEAR,
+            .mag_filter = SG_FILTER_LINEAR,
+            .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+            .wrap_v = SG_WRAP_CLAMP_TO_EDGE
+        });
+    resolution.w = (int)(state.windowWidth * frameStats.resolutionScale + .5f);
+    resolution.h = (int)(state.windowHeight * frameStats.resolutionScale + .5f);
+    if (resolution.w > w)
+        resolution.w = w;
+    if (resolution.h > h)
+        resolution.h = h;
+}
+
+// Flushes the frame into the scaled target, then starts the default pass and
+// stretches the target over it. Anything drawn after goes on at full resolution.
+static void SubmitScaledFrame(void) {
+    sg_begin_pass(resolution.target.pass, &state.pass_action);
+    sg_apply_viewport(0, 0, resolution.w, resolution.h, true);
+    sg_apply_scissor_rect(0, 0, resolution.w, resolution.h, true);
+    LURK_PROFILE(&state, "sgp_flush")
+        FlushScaledCommands((float)resolution.w / state.windowWidth, (float)resolution.h / state.windowHeight);
+    sgp_end();
+    sg_end_pass();
+
+    sgp_begin(state.windowWidth, state.windowHeight);
+    BeginWindowPass(&state.pass_action);
+    sgp_set_sampler(0, resolution.sampler);
+    DrawRenderTarget(&resolution.target, resolution.w, resolution.h,
+                     (sgp_rect){0.f, 0.f, (float)state.windowWidth, (float)state.windowHeight});
+    sgp_reset_sampler(0);
+}
+
+// MARK: Overlay
+
+#if !defined(LURK_OVERLAY_HISTORY)
+#define LURK_OVERLAY_HISTORY 120 // frames shown in the frame time graph
+#endif
+
+#if !defined(LURK_OVERLAY_SCALE)
+#define LURK_OVERLAY_SCALE 2 // size of a font pixel, in pixels
+#endif
+
+#define LURK_OVERLAY_MAX_GLYPHS 512
+
+// 3x5 font, one row of 3 bits per byte (top to bottom, the high bit is the left column)
+#define LURK_OVERLAY_GLYPHS                                           \
+    X(' ', 0, 0, 0, 0, 0) X('0', 7, 5, 5, 5, 7) X('1', 2, 6, 2, 2, 7) \
+    X('2', 7, 1, 7, 4, 7) X('3', 7, 1, 7, 1, 7) X('4', 5, 5, 7, 1, 1) \
+    X('5', 7, 4, 7, 1, 7) X('6', 7, 4, 7, 5, 7) X('7', 7, 1, 1, 1, 1) \
+    X('8', 7, 5, 7, 5, 7) X('9', 7, 5, 7, 1, 7) X('.', 0, 0, 0, 0, 2) \
+    X(':', 0, 2, 0, 2, 0) X('/', 1, 1, 2, 4, 4) X('-', 0, 0, 7, 0, 0) \
+    X('A', 2, 5, 7, 5, 5) X('B', 6, 5, 6, 5, 6) X('C', 3, 4, 4, 4, 3) \
+    X('D', 6, 5, 5, 5, 6) X('E', 7, 4, 6, 4, 7) X('F', 7, 4, 6, 4, 4) \
+    X('G', 3, 4, 5, 5, 3) X('H', 5, 5, 7, 5, 5) X('I', 7, 2, 2, 2, 7) \
+    X('J', 1, 1, 1, 5, 2) X('K', 5, 5, 6, 5, 5) X('L', 4, 4, 4, 4, 7) \
+    X('M', 5, 7, 7, 5, 5) X('N', 6, 5, 5, 5, 5) X('O', 2, 5, 5, 5, 2) \
+    X('P', 6, 5, 6, 4, 4) X('Q', 2, 5, 5, 6, 3) X('R', 6, 5, 6, 5, 5) \
+    X('S', 3, 4, 2, 1, 6) X('T', 7, 2, 2, 2, 2) X('U', 5, 5, 5, 5, 7) \
+    X('V', 5, 5, 5, 5, 2) X('W', 5, 5, 7, 7, 5) X('X', 5, 5, 2, 5, 5) \
+    X('Y', 5, 5, 2, 2, 2) X('Z', 7, 1, 2, 4, 7)
+
+static const char overlayCharacters[] = {
+#define X(C, R0, R1, R2, R3, R4) C,
+    LURK_OVERLAY_GLYPHS
+#undef X
+};
+
+static const unsigned char overlayGlyphs[][5] = {
+#define X(C, R0, R1, R2, R3, R4) {R0, R1, R2, R3, R4},
+    LURK_OVERLAY_GLYPHS
+#undef X
+};
+
+#define LURK_OVERLAY_GLYPH_COUNT ((int)sizeof(overlayCharacters))
+
+// The overlay goes straight to sokol_gp after the scene has been replayed, it
+// never touches the command buffer. Counters are read before it draws anything
+// and the time it takes is left out of `renderTime`.
+static struct {
+    sg_image font;
+    float frameTimes[LURK_OVERLAY_HISTORY];
+    int frameIndex;
+    sgp_textured_rect glyphs[LURK_OVERLAY_MAX_GLYPHS];
+    int glyphCount;
+    uint64_t time;
+} overlay;
+
+static void MakeOverlayFont(void) {
+    int pixels[LURK_OVERLAY_GLYPH_COUNT * 3 * 5];
+    int w = LURK_OVERLAY_GLYPH_COUNT * 3;
+    for (int i = 0; i < LURK_OVERLAY_GLYPH_COUNT; i++)
+        for (int y = 0; y < 5; y++)
+            for (int x = 0; x < 3; x++)
+                pixels[y * w + i * 3 + x] = overlayGlyphs[i][y] & (4 >> x) ? 0xFFFFFFFF : 0;
+    // Made here rather than with NewTexture so it isn't counted in textureMemory
+    overlay.font = sg_make_image(&(sg_image_desc) {
+        .width = w,
+        .height = 5,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .data.subimage[0][0] = SG_RANGE(pixels)
+    });
+}
+
+static void OverlayText(float x, float y, const char *fmt, ...) {
+    char text[64];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    for (const char *c = text; *c && overlay.glyphCount < LURK_OVERLAY_MAX_GLYPHS; c++, x += 4 * LURK_OVERLAY_SCALE) {
+        int glyph = 0;
+        for (int i = 0; i < LURK_OVERLAY_GLYPH_COUNT; i++)
+            if (overlayCharacters[i] == toupper(*c)) {
+                glyph = i;
+                break;
+            }
+        if (!glyph)
+            continue;
+        overlay.glyphs[overlay.glyphCount++] = (sgp_textured_rect) {
+            .dst = {x, y, 3 * LURK_OVERLAY_SCALE, 5 * LURK_OVERLAY_SCALE},
+            .src = {glyph * 3, 0, 3, 5}
+        };
+    }
+}
+
+static void DrawOverlay(void) {
+    if (overlay.font.id == SG_INVALID_ID)
+        MakeOverlayFont();
+    overlay.frameTimes[overlay.frameIndex] = frameStats.frameTime;
+    overlay.frameIndex = (overlay.frameIndex + 1) % LURK_OVERLAY_HISTORY;
+
+    const float lineHeight = 7 * LURK_OVERLAY_SCALE;
+    const float graphHeight = 60.f;
+    // Against the display's frame, not the tick rate, the graph shows whole frames
+    const float displayBudget = (float)FrameBudget();
+    const float graphScale = graphHeight / (2.f * displayBudget); // two frames tall
+    float x = 8.f, y = 8.f;
+    overlay.glyphCount = 0;
+    OverlayText(x, y, "FRAME %.2f MS  RECORD %.2f  RENDER %.2f", frameStats.frameTime, frameStats.recordTime, frameStats.renderTime);
+    OverlayText(x, y += lineHeight, "FIXED UPDATES %d", frameStats.fixedUpdates);
+    OverlayText(x, y += lineHeight, "COMMANDS %d", replayStats.commandCount);
+    OverlayText(x, y += lineHeight, "SGP COMMANDS %d/%d", frameStats.gpCommands, state.maxDrawCommands);
+    OverlayText(x, y += lineHeight, "SGP VERTICES %d/%d  CULLED %d", frameStats.gpVertices, state.maxVertices, frameStats.culledPrimitives);
+    OverlayText(x, y += lineHeight, "DRAW CALLS %d  MERGED %d", frameStats.drawCalls,
+                replayStats.drawCommands > frameStats.drawCalls ? replayStats.drawCommands - frameStats.drawCalls : 0);
+    OverlayText(x, y += lineHeight, "TEXTURES %.2f MB", state.textureMemory / (1024.f * 1024.f));
+    OverlayText(x, y += lineHeight, "RELOADS %d", state.reloadCount);
+    if (state.dynamicResolution)
+        OverlayText(x, y += lineHeight, "RESOLUTION %dX%d", resolution.w, resolution.h);
+    y += lineHeight + LURK_OVERLAY_SCALE;
+
+    sgp_rect bars[2][LURK_OVERLAY_HISTORY]; // under and over budget
+    int barCount[2] = {0, 0};
+    for (int i = 0; i < LURK_OVERLAY_HISTORY; i++) {
+        float time = overlay.frameTimes[(overlay.frameIndex + i) % LURK_OVERLAY_HISTORY];
+        float height = time * graphScale;
+        if (height > graphHeight)
+            height = graphHeight;
+        int over = time > displayBudget + .5f;
+        bars[over][barCount[over]++] = (sgp_rect){x + i * 2.f, y + graphHeight - height, 2.f, height};
+    }
+    float width = LURK_OVERLAY_HISTORY * 2.f;
+    if (width < 48 * 4 * LURK_OVERLAY_SCALE)
+        width = 48 * 4 * LURK_OVERLAY_SCALE;
+
+    // Not sgp_reset_state, it asserts when the default pipeline is bound
+    sgp_reset_viewport();
+    sgp_reset_scissor();
+    sgp_reset_project();
+    sgp_reset_transform();
+    sgp_reset_pipeline();
+    sgp_reset_image(0);
+    sgp_reset_sampler(0);
+    sgp_set_blend_mode(SGP_BLENDMODE_BLEND);
+    sgp_set_color(0.f, 0.f, 0.f, .6f);
+    sgp_draw_filled_rect(x - 4.f, 4.f, width + 8.f, y + graphHeight);
+    sgp_set_color(.3f, .9f, .3f, 1.f);
+    sgp_draw_filled_rects(bars[0], barCount[0]);
+    sgp_set_color(.9f, .3f, .3f, 1.f);
+    sgp_draw_filled_rects(bars[1], barCount[1]);
+    sgp_set_color(1.f, 1.f, 1.f, .5f);
+    sgp_draw_filled_rect(x, y + graphHeight - graphHeight / 2.f, LURK_OVERLAY_HISTORY * 2.f, 1.f); // budget
+    sgp_set_color(1.f, 1.f, 1.f, 1.f);
+    sgp_set_image(0, overlay.font);
+    sgp_draw_textured_rects(0, overlay.glyphs, overlay.glyphCount);
+}
+
+static void SubmitFrame(void) {
+    state.pass_action.colors[0].clear_value = state.clearColor;
+    frameStats.drawCalls = CountDrawCalls() + targets.drawCalls + sprites.drawCalls;
+    targets.drawCalls = 0;
+    sprites.drawCalls = 0;
+    frameStats.gpCommands = _sgp.cur_command;
+    frameStats.gpVertices = _sgp.cur_vertex;
+    frameStats.culledPrimitives = sgp_query_culled();
+    if (!state.dynamicResolution || VirtualResolution()) {
+        frameStats.resolutionScale = 1.f;
+        DestroyRenderTarget(&resolution.target);
+    }
+    if (!VirtualResolution())
+        DestroyRenderTarget(&screen.target);
+
+    if (VirtualResolution())
+        SubmitVirtualFrame();
+    else if (state.dynamicResolution) {
+        UpdateResolutionScale();
+        SubmitScaledFrame();
+    } else
+        BeginWindowPass(&state.pass_action);
+    overlay.time = 0;
+    if (state.overlay) {
+        uint64_t overlayStart = stm_now();
+        LURK_PROFILE(&state, "overlay")
+            DrawOverlay();
+        overlay.time = stm_since(overlayStart);
+    }
+    LURK_PROFILE(&state, "sgp_flush")
+        FlushCommands();
+    sgp_end();
+    sg_end_pass();
+    if (KeepFrame())
+        PresentIdleFrame();
+    LURK_PROFILE(&state, "sg_commit")
+        sg_commit();
+}
+
+// Replays a recorded frame into sokol_gp and submits it
+static void RenderFrame(lurkCommandBuffer *buffer) {
+    uint64_t renderStart = stm_now();
+    lurkProfileBegin(&state, "RenderFrame");
+    int width, height;
+    lurkWindowSize(&state, &width, &height);
+    sgp_begin(width, height);
+    LURK_PROFILE(&state, "ProcessCommandBuffer")
+        ProcessCommandBuffer(buffer);
+    SubmitFrame();
+    lurkProfileEnd(&state);
+    frameStats.renderTime = stm_ms(stm_since(renderStart) - overlay.time);
+}
+
+// Whether a buffer waiting to be replayed with the next frame has to go before
+// the frame's own commands. Other threads only ever push onto the list, so it
+// can be walked from the head without taking it.
+static bool BackgroundSubmitted(void) {
+    for (lurkCommandBuffer *b = __atomic_load_n(&state.submitted, __ATOMIC_ACQUIRE); b; b = b->next)
+        if (b->key < 0)
+            return true;
+    return false;
+}
+
+// Immediate mode replays commands as they're recorded, so the frame's buffer
+// never sees them. These count them for replayStats instead.
+static struct {
+    int drawCommands, commandCount;
+} immediateStats;
+
+#define X(NAME, RECORDER, PARAMS, VALUES, FIELDS, REPLAY)                \
+    static void Immediate##NAME(const void *payload) {                   \
+        immediateStats.drawCommands += IsDrawCommand(lurkCommand##NAME); \
+        immediateStats.commandCount++;                                   \
+        Replay##NAME(payload);                                           \
+    }
+LURK_COMMANDS
+#undef X
+
+static void (*ImmediateCommandTable[lurkCommandCount])(const void*) = {
+#define X(NAME, RECORDER, PARAMS, VALUES, FIELDS, REPLAY) [lurkCommand##NAME] = Immediate##NAME,
+    LURK_COMMANDS
+#undef X
+};
+
+// Immediate mode, the scene draws straight into sokol_gp while it runs. Only
+// buffers submitted from other threads are left to replay after, so a frame
+// that starts with a negative key buffer waiting is recorded instead.
+static void DrawFrame(void) {
+    int width, height;
+    lurkWindowSize(&state, &width, &height);
+    sgp_begin(width, height);
+    immediateStats.drawCommands = 0;
+    immediateStats.commandCount = 0;
+    state.immediate = ImmediateCommandTable;
+    RecordFrame();
+    state.immediate = NULL;
+    uint64_t renderStart = stm_now();
+    lurkProfileBegin(&state, "RenderFrame");
+    LURK_PROFILE(&state, "ProcessCommandBuffer")
+        ProcessCommandBuffer(&state.commandBuffer);
+    replayStats.drawCommands += immediateStats.drawCommands;
+    replayStats.commandCount += immediateStats.commandCount;
+    SubmitFrame();
+    lurkProfileEnd(&state);
+    frameStats.renderTime = stm_ms(stm_since(renderStart) - overlay.time);
+}
+
+static void FrameCallback(void) {
+    static uint64_t lastFrame = 0;
+    frameStats.frameTime = stm_ms(stm_laptime(&lastFrame));
+    lurkProfileBegin(&state, "FrameCallback");
+
+    LURK_PROFILE(&state, "gamepad")
+        Gamepad_processEvents();
+
+    if (state.fullscreen != state.fullscreenLast) {
+        sapp_toggle_fullscreen();
+        state.fullscreenLast = state.fullscreen;
+    }
+
+    if (state.cursorVisible != state.cursorVisibleLast) {
+        sapp_show_mouse(state.cursorVisible);
+        state.cursorVisibleLast = state.cursorVisible;
+    }
+
+    if (state.cursorLocked != state.cursorLockedLast) {
+        sapp_lock_mouse(state.cursorLocked);
+        state.cursorLockedLast = state.cursorLocked;
+    }
+
+    if (!pipeline.running) {
+        bool changed = pendingTexturesCount > 0 || state.nextScene;
+        int reloadCount = state.reloadCount;
+        FlushPendingTextures();
+        UpdateLibrary();
+        if (!IdleRedraw(changed || state.reloadCount != reloadCount)) {
+            lurkProfileEnd(&state);
+            return;
+        }
+        PublishFrameStats();
+        if (state.immediateMode && !state.sortDraws && !capture.file && !BackgroundSubmitted())
+            DrawFrame();
+        else {
+            RecordFrame();
+            RenderFrame(&state.commandBuffer);
+        }
+        if (state.libraryScene->postframe)
+            LURK_PROFILE(&state, "postframe")
+                state.libraryScene->postframe(&state, state.libraryContext);
+        lurkProfileEnd(&state);
+        return;
+    }
+
+    LURK_PROFILE(&state, "WaitForRecord")
+        WaitForRecord();
+    FlushQueuedEvents();
+    PipelineFrame(RenderFrame);
+    lurkProfileEnd(&state);
+}
+
+static void HandleEvent(const sapp_event* e) {
     switch (e->type) {
     case SAPP_EVENTTYPE_KEY_DOWN:
     case SAPP_EVENTTYPE_KEY_UP:
+        if (e->type == SAPP_EVENTTYPE_KEY_DOWN && e->key_code == DEFAULT_CAPTURE_KEY && !e->key_repeat)
+            StartCapture(DEFAULT_CAPTURE_LENGTH);
+        if (e->type == SAPP_EVENTTYPE_KEY_DOWN && e->key_code == DEFAULT_OVERLAY_KEY && !e->key_repeat)
+            state.overlay = !state.overlay;
+        if (e->type == SAPP_EVENTTYPE_KEY_DOWN && e->key_code == DEFAULT_PACING_KEY && !e->key_repeat)
+            PrintPacingSummary();
+#if defined(LURK_ENABLE_PROFILER)
+        if (e->type == SAPP_EVENTTYPE_KEY_DOWN && e->key_code == DEFAULT_PROFILE_KEY && !e->key_repeat)
+            lurkProfileDump(&state, DEFAULT_PROFILE_PATH);
+#endif
         state.keyboard[e->key_code].down = e->type == SAPP_EVENTTYPE_KEY_DOWN;
         state.keyboard[e->key_code].timestamp = stm_now();
         state.modifiers = e->modifiers;
@@ -1694,11 +3510,15 @@ static void EventCallback(const sapp_event* e) {
         state.mouse.scroll.x = e->scroll_x;
         state.mouse.scroll.y = e->scroll_y;
         return;
-    case SAPP_EVENTTYPE_MOUSE_MOVE:
+    case SAPP_EVENTTYPE_MOUSE_MOVE: {
         memcpy(&state.mouse.lastPosition, &state.mouse.position, 2 * sizeof(int));
-        state.mouse.position.x = e->mouse_x;
-        state.mouse.position.y = e->mouse_y;
+        float x = e->mouse_x, y = e->mouse_y;
+        if (VirtualResolution())
+            WindowToVirtual(&x, &y);
+        state.mouse.position.x = x;
+        state.mouse.position.y = y;
         return;
+    }
     case SAPP_EVENTTYPE_CLIPBOARD_PASTED: {
         state.clipboard[0] = '\0';
         const char *buffer = sapp_get_clipboard_string();
@@ -1720,11 +3540,66 @@ static void EventCallback(const sapp_event* e) {
         state.libraryScene->event(&state, state.libraryContext, e->type);
 }
 
+static void EventCallback(const sapp_event* e) {
+    WakeFromIdle();
+    if (pipeline.running) {
+        MutexLock(&pipeline.lock);
+        bool recording = pipeline.recording;
+        MutexUnlock(&pipeline.lock);
+        if (recording) {
+            if (queuedEvents.count < LURK_MAX_QUEUED_EVENTS) {
+                queuedEvents.events[queuedEvents.count++] = *e;
+                return;
+            }
+            WaitForRecord();
+        }
+        FlushQueuedEvents();
+    }
+    HandleEvent(e);
+}
+
 static void CleanupCallback(void) {
     state.running = false;
+    if (pipeline.running) {
+        StopPipeline();
+        FlushQueuedEvents();
+    }
     if (state.libraryScene->deinit)
         state.libraryScene->deinit(&state, state.libraryContext);
     ezEcsFreeWorld(&state.world);
+    if (state.commandBuffer.data)
+        free(state.commandBuffer.data);
+    if (state.renderBuffer.data)
+        free(state.renderBuffer.data);
+    if (pendingTextures)
+        free(pendingTextures);
+    if (capture.file)
+        fclose(capture.file);
+    if (capture.textures)
+        free(capture.textures);
+    if (sorter.draws) {
+        free(sorter.draws);
+        free(sorter.order);
+    }
+    if (overlay.font.id != SG_INVALID_ID)
+        sg_destroy_image(overlay.font);
+    DestroyRenderTarget(&resolution.target);
+    DestroyRenderTarget(&screen.target);
+    DestroyRenderTarget(&idle.target);
+    DestroySprites();
+    if (resolution.sampler.id != SG_INVALID_ID)
+        sg_destroy_sampler(resolution.sampler);
+    if (pacing.file) {
+        fclose(pacing.file);
+        PrintPacingSummary();
+    }
+#if defined(LURK_ENABLE_PROFILER)
+    lurkProfileDump(&state, DEFAULT_PROFILE_PATH);
+    for (struct lurkProfileRing *ring = state.profiler.rings, *next; ring; ring = next) {
+        next = ring->next;
+        free(ring);
+    }
+#endif
 #if !defined(LURK_DISABLE_HOTRELOAD)
     dmon_deinit();
 #endif
@@ -1793,10 +3668,11 @@ void lurkSwapToScene(lurkState *state, const char *name) {
 }
 
 void lurkWindowSize(lurkState *state, int *width, int *height) {
+    bool virtual = state->virtualWidth > 0 && state->virtualHeight > 0;
     if (width)
-        *width = state->windowWidth;
+        *width = virtual ? state->virtualWidth : state->windowWidth;
     if (height)
-        *height = state->windowHeight;
+        *height = virtual ? state->virtualHeight : state->windowHeight;
 }
 
 int lurkIsWindowFullscreen(lurkState *state) {
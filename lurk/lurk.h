@@ -101,8 +101,16 @@ typedef enum bool {
 #endif
 
 #include "sokol_gfx.h"
+#if defined(LURK_HEADLESS) && defined(SOKOL_IMPL)
+// Headless builds (benchmarks, tools) have no window, only take the declarations
+#undef SOKOL_IMPL
 #include "sokol_app.h"
 #include "sokol_glue.h"
+#define SOKOL_IMPL
+#else
+#include "sokol_app.h"
+#include "sokol_glue.h"
+#endif
 #if defined(LURK_SCENE) && defined(SOKOL_IMPL)
 #undef SOKOL_IMPL
 #endif
@@ -162,23 +170,157 @@ typedef enum bool {
 #define LURK_DISABLE_HOTRELOAD
 #endif
 
+#if !defined(DEFAULT_COMMAND_BUFFER_SIZE)
+#define DEFAULT_COMMAND_BUFFER_SIZE 65536 // initial size (in bytes), grows as needed
+#endif
+
 #if !defined(DEFAULT_TARGET_FPS)
 #define DEFAULT_TARGET_FPS 60.f
 #endif
 
-#define SETTINGS                                                                                 \
-    X("width", integer, width, DEFAULT_WINDOW_WIDTH, "Set window width")                         \
-    X("height", integer, height, DEFAULT_WINDOW_HEIGHT, "Set window height")                     \
-    X("sampleCount", integer, sample_count, 4, "Set the MSAA sample count of the   framebuffer") \
-    X("swapInterval", integer, swap_interval, 1, "Set the preferred swap interval")              \
-    X("highDPI", boolean, high_dpi, true, "Enable high-dpi compatability")                       \
-    X("fullscreen", boolean, fullscreen, false, "Set fullscreen")                                \
-    X("alpha", boolean, alpha, false, "Enable/disable alpha channel on framebuffers")            \
-    X("clipboard", boolean, enable_clipboard, false, "Enable clipboard support")                 \
-    X("clipboardSize", integer, clipboard_size, 1024, "Size of clipboard buffer (in bytes)")     \
-    X("drapAndDrop", boolean, enable_dragndrop, false, "Enable drag-and-drop files")             \
-    X("maxDroppedFiles", integer, max_dropped_files, 1, "Max number of dropped files")           \
-    X("maxDroppedFilesPathLength", integer, max_dropped_file_path_length, MAX_PATH, "Max path length for dropped files")
+#if !defined(DEFAULT_TARGET_FRAME_RATE)
+#define DEFAULT_TARGET_FRAME_RATE ((int)DEFAULT_TARGET_FPS) // frames per second the display is expected to show
+#endif
+
+#if !defined(DEFAULT_TICK_RATE)
+#define DEFAULT_TICK_RATE ((int)DEFAULT_TARGET_FPS) // fixed updates per second
+#endif
+
+#if !defined(DEFAULT_UPDATE_MULTIPLICITY)
+#define DEFAULT_UPDATE_MULTIPLICITY 1
+#endif
+
+#if !defined(DEFAULT_UNLOCK_FRAMERATE)
+#if defined(LURK_UNLOCKFRAME_RATE)
+#define DEFAULT_UNLOCK_FRAMERATE true
+#else
+#define DEFAULT_UNLOCK_FRAMERATE false
+#endif
+#endif
+
+#if !defined(DEFAULT_MAX_FRAME_LATENCY)
+#define DEFAULT_MAX_FRAME_LATENCY 0
+#endif
+
+// Immediate mode draws while the scene runs instead of recording the frame. It
+// skips the replay filter (redundant state commands and merged transform runs),
+// so draw-heavy frames can be slower: replay_bench measures 41.8 ns per
+// DrawFilledRect, against 30.4 ns recorded and replayed. Ignored with `sortDraws`
+// or `maxFrameLatency` set.
+#if !defined(DEFAULT_IMMEDIATE_MODE)
+#define DEFAULT_IMMEDIATE_MODE false
+#endif
+
+#if !defined(LURK_PROFILE_RING_SIZE)
+#define LURK_PROFILE_RING_SIZE 65536 // zone events kept per thread, the oldest are overwritten
+#endif
+
+#if !defined(LURK_PROFILE_NAME_LENGTH)
+#define LURK_PROFILE_NAME_LENGTH 24 // zone names are cut to fit (including the NUL)
+#endif
+
+#if !defined(DEFAULT_PROFILE_PATH)
+#define DEFAULT_PROFILE_PATH "lurk.trace.json"
+#endif
+
+#if !defined(DEFAULT_PROFILE_KEY)
+#define DEFAULT_PROFILE_KEY SAPP_KEYCODE_F11
+#endif
+
+#if !defined(DEFAULT_OVERLAY_KEY)
+#define DEFAULT_OVERLAY_KEY SAPP_KEYCODE_F10
+#endif
+
+#if !defined(LURK_PACING_HISTORY)
+#define LURK_PACING_HISTORY 1024 // frames covered by the pacing summary
+#endif
+
+#if !defined(DEFAULT_PACING_PATH)
+#define DEFAULT_PACING_PATH "lurk.pacing.csv"
+#endif
+
+#if !defined(DEFAULT_PACING_KEY)
+#define DEFAULT_PACING_KEY SAPP_KEYCODE_F9 // prints the pacing summary
+#endif
+
+#if !defined(DEFAULT_MIN_RESOLUTION_SCALE)
+#define DEFAULT_MIN_RESOLUTION_SCALE 50 // percent of the window size
+#endif
+
+#if !defined(DEFAULT_MAX_RESOLUTION_SCALE)
+#define DEFAULT_MAX_RESOLUTION_SCALE 100
+#endif
+
+#if !defined(DEFAULT_RESOLUTION_HYSTERESIS)
+#define DEFAULT_RESOLUTION_HYSTERESIS 10 // percent of the frame budget
+#endif
+
+#if !defined(DEFAULT_VIRTUAL_WIDTH)
+#define DEFAULT_VIRTUAL_WIDTH 0 // 0 draws at the window size
+#endif
+
+#if !defined(DEFAULT_VIRTUAL_HEIGHT)
+#define DEFAULT_VIRTUAL_HEIGHT 0
+#endif
+
+#if !defined(DEFAULT_MAX_VERTICES)
+#define DEFAULT_MAX_VERTICES 65536 // sokol_gp default
+#endif
+
+#if !defined(DEFAULT_MAX_DRAW_COMMANDS)
+#define DEFAULT_MAX_DRAW_COMMANDS 16384 // sokol_gp default
+#endif
+
+#if !defined(DEFAULT_MAX_SPRITES)
+#define DEFAULT_MAX_SPRITES 131072 // 40 bytes each, see lurkDrawSpriteBatch
+#endif
+
+#if !defined(DEFAULT_CAPTURE_PATH)
+#define DEFAULT_CAPTURE_PATH "lurk.capture"
+#endif
+
+#if !defined(DEFAULT_CAPTURE_KEY)
+#define DEFAULT_CAPTURE_KEY SAPP_KEYCODE_F12
+#endif
+
+#if !defined(DEFAULT_CAPTURE_LENGTH)
+#define DEFAULT_CAPTURE_LENGTH 60 // frames captured when DEFAULT_CAPTURE_KEY is pressed
+#endif
+
+#define SETTINGS                                                                                                                       \
+    X("width", integer, desc.width, DEFAULT_WINDOW_WIDTH, "Set window width")                                                          \
+    X("height", integer, desc.height, DEFAULT_WINDOW_HEIGHT, "Set window height")                                                      \
+    X("sampleCount", integer, desc.sample_count, 4, "Set the MSAA sample count of the   framebuffer")                                  \
+    X("swapInterval", integer, desc.swap_interval, 1, "Set the preferred swap interval")                                               \
+    X("highDPI", boolean, desc.high_dpi, true, "Enable high-dpi compatability")                                                        \
+    X("fullscreen", boolean, desc.fullscreen, false, "Set fullscreen")                                                                 \
+    X("alpha", boolean, desc.alpha, false, "Enable/disable alpha channel on framebuffers")                                             \
+    X("clipboard", boolean, desc.enable_clipboard, false, "Enable clipboard support")                                                  \
+    X("clipboardSize", integer, desc.clipboard_size, 1024, "Size of clipboard buffer (in bytes)")                                      \
+    X("drapAndDrop", boolean, desc.enable_dragndrop, false, "Enable drag-and-drop files")                                              \
+    X("maxDroppedFiles", integer, desc.max_dropped_files, 1, "Max number of dropped files")                                            \
+    X("maxDroppedFilesPathLength", integer, desc.max_dropped_file_path_length, MAX_PATH, "Max path length for dropped files")          \
+    X("maxFrameLatency", integer, maxFrameLatency, DEFAULT_MAX_FRAME_LATENCY, "Frames the renderer can lag behind the scene (0 or 1)") \
+    X("sortDraws", boolean, sortDraws, false, "Reorder draws in each layer by render state to reduce draw calls")                      \
+    X("immediateMode", boolean, immediateMode, DEFAULT_IMMEDIATE_MODE, "Draw without recording, skipping the redundancy filter and transform merging (can be slower on draw-heavy frames)") \
+    X("captureFrames", integer, captureFrames, 0, "Capture this many frames from startup to " DEFAULT_CAPTURE_PATH)                    \
+    X("maxVertices", integer, maxVertices, DEFAULT_MAX_VERTICES, "Vertices sokol_gp can draw in a frame")                              \
+    X("maxDrawCommands", integer, maxDrawCommands, DEFAULT_MAX_DRAW_COMMANDS, "Draw commands sokol_gp can queue in a frame")           \
+    X("maxSprites", integer, maxSprites, DEFAULT_MAX_SPRITES, "Sprites the sprite batches can draw in a frame")                        \
+    X("overlay", boolean, overlay, false, "Show frame stats on top of the scene (toggle with F10)")                                    \
+    X("pacingLog", boolean, pacingLog, false, "Write timestep records to " DEFAULT_PACING_PATH ", summary on exit")                    \
+    X("tickRate", integer, tickRate, DEFAULT_TICK_RATE, "Fixed updates per second")                                                    \
+    X("unlockFramerate", boolean, unlockFramerate, DEFAULT_UNLOCK_FRAMERATE, "Update every frame, interpolate between fixed updates")  \
+    X("updateMultiplicity", integer, updateMultiplicity, DEFAULT_UPDATE_MULTIPLICITY, "Fixed updates per batch (locked framerate)")    \
+    X("idle", boolean, idleMode, false, "Only draw after input, reloads, timers or lurkRequestRedraw (no latency)")                    \
+    X("targetFrameRate", integer, targetFrameRate, DEFAULT_TARGET_FRAME_RATE, "Frames per second dynamicResolution and the overlay aim for") \
+    X("dynamicResolution", boolean, dynamicResolution, false, "Scale the scene's resolution to hold targetFrameRate")                   \
+    X("minResolutionScale", integer, minResolutionScale, DEFAULT_MIN_RESOLUTION_SCALE, "Lowest dynamic resolution (%)")                \
+    X("maxResolutionScale", integer, maxResolutionScale, DEFAULT_MAX_RESOLUTION_SCALE, "Highest dynamic resolution (%)")               \
+    X("resolutionHysteresis", integer, resolutionHysteresis, DEFAULT_RESOLUTION_HYSTERESIS, "Frame time slack (%)")                    \
+    X("virtualWidth", integer, virtualWidth, DEFAULT_VIRTUAL_WIDTH, "Draw at this width and scale it up to the window")                \
+    X("virtualHeight", integer, virtualHeight, DEFAULT_VIRTUAL_HEIGHT, "Draw at this height (needs virtualWidth)")                     \
+    X("integerScale", boolean, integerScale, true, "Only scale the virtual resolution by whole numbers")
 
 #define LURK_CLIPBOARD_PASTED SAPP_EVENTTYPE_CLIPBOARD_PASTED
 #define LURK_WINDOW_FILES_DROPPED SAPP_EVENTTYPE_FILES_DROPPED
@@ -202,20 +344,63 @@ typedef sapp_event_type lurkEventType;
 #define LURK_CLIPBOARD_SIZE 8192 // sapp default
 #endif
 
+// Layout of the vertices sokol_gp writes, `color` is the lurkSetColor at the
+// time of the draw packed like LURK_SPRITE_COLOR. Color lives in the vertices
+// rather than a uniform so draws that only differ in color still batch.
 typedef struct lurkVertex {
     Vec2f position, texcoord;
-    Vec4f color;
+    uint32_t color;
 } lurkVertex;
 
 typedef struct lurkRect {
     float x, y, w, h;
 } lurkRect;
 
+// An offscreen pass that sokol_gp's pipelines can draw into, they're made for
+// the swapchain's formats and sample count so the target has to match them.
+// With MSAA the frame is resolved into `resolve` when the pass ends.
+typedef struct lurkRenderTarget {
+    sg_image color, resolve, depth;
+    sg_pass pass;
+    int w, h;
+    size_t memory;
+} lurkRenderTarget;
+
 typedef struct lurkTexture {
     sg_image internal;
     int w, h;
+    lurkRenderTarget *target; // NULL unless made with lurkCreateRenderTarget
+    bool dirty; // see lurkIsRenderTargetDirty
 } lurkTexture;
 
+typedef struct lurkCommandBuffer {
+    unsigned char *data;
+    size_t size, capacity;
+    int count;
+    // Buffers submitted to this frame, see lurkSubmitCommandBuffer
+    struct lurkCommandBuffer *submitted, *next;
+    int key, index;
+    bool pending;
+    bool retained; // recorded with lurkBeginCommandList, kept after replay
+} lurkCommandBuffer;
+
+typedef lurkCommandBuffer lurkCommandList;
+
+// Packs a color for lurkSpriteBatch, each channel is 0-255
+#define LURK_SPRITE_COLOR(R, G, B, A) \
+    ((uint32_t)(R) | (uint32_t)(G) << 8 | (uint32_t)(B) << 16 | (uint32_t)(A) << 24)
+
+// One array per sprite attribute, see lurkDrawSpriteBatch
+typedef struct lurkSpriteBatch {
+    sgp_vec2 *position; // centre, in pixels
+    sgp_vec2 *scale; // times the size of `src`, negative flips
+    float *rotation; // radians, around the centre
+    sgp_rect *src; // source rect, in texture pixels
+    uint32_t *color; // LURK_SPRITE_COLOR, multiplied with the texture
+    int *layer; // drawn in ascending order
+    int count, capacity;
+} lurkSpriteBatch;
+
 typedef struct lurkScene lurkScene;
 typedef struct lurkContext lurkContext;
 
@@ -234,7 +419,8 @@ typedef struct lurkState {
     imap_node_t *textureMap;
     int textureMapCapacity;
     int textureMapCount;
-    ezStack commandQueue;
+    lurkCommandBuffer commandBuffer, renderBuffer;
+    lurkCommandBuffer *submitted; // not yet moved onto a frame, see lurkSubmitCommandBuffer
     sg_color clearColor;
 
     uint64_t timerFrequency;
@@ -245,9 +431,47 @@ typedef struct lurkState {
     int64_t maxVsyncError;
     int64_t frameAccumulator;
     double fixedDeltaTime;
+    int tickRate;
     bool resync;
     bool unlockFramerate;
     int updateMultiplicity;
+    int maxFrameLatency;
+    bool sortDraws;
+    bool immediateMode;
+    int captureFrames;
+    int maxVertices, maxDrawCommands; // sokol_gp buffer sizes, see sgp_desc
+    int maxSprites; // see lurkDrawSpriteBatch
+    // Set by the host while draws can go straight to sokol_gp, see `immediateMode`
+    // and lurkSubmitCommandBuffer for the frames that are recorded anyway
+    void (*const *immediate)(const void *payload);
+    double frameTime, recordTime, renderTime; // last frame, in milliseconds
+    int drawCalls; // last frame
+    int drawCommands; // draw commands replayed last frame, sokol_gp merges them into drawCalls
+    int commandCount; // commands recorded for the last frame, including submitted buffers
+    int fixedUpdates; // fixed updates run in the last frame
+    int gpCommands, gpVertices; // sokol_gp buffer use in the last frame, see maxDrawCommands and maxVertices
+    int culledPrimitives; // rects, triangles, lines and points dropped off-screen before their vertices were written, last frame
+    size_t textureMemory; // bytes, all live textures
+    int reloadCount; // times the scene library has been reloaded
+    bool overlay;
+    bool pacingLog;
+    bool idleMode;
+    bool redrawRequested; // see lurkRequestRedraw
+    double redrawDelay;   // seconds, see lurkRequestRedrawAfter
+    int targetFrameRate; // the display's, not the tick rate, see dynamicResolution
+    bool dynamicResolution;
+    int minResolutionScale, maxResolutionScale, resolutionHysteresis; // percent
+    float resolutionScale; // the scene is drawn at the window size times this, see dynamicResolution
+    int virtualWidth, virtualHeight; // see lurkWindowSize
+    bool integerScale;
+    struct {
+        struct lurkProfileRing *rings; // one per thread that has opened a zone
+        uint64_t (*now)(void);         // the host's clock, zones are dropped until it's set
+    } profiler; // see LURK_ENABLE_PROFILER
+    struct {
+        int redundant;  // state commands that didn't change anything
+        int transforms; // transform commands merged into the one before them
+    } filtered; // last frame
 
     bool running;
     bool mouseHidden;
@@ -298,6 +522,9 @@ struct lurkScene {
 
 EXPORT void lurkSwapToScene(lurkState *state, const char *name);
 
+// The size scenes draw at, this is the virtual resolution when `virtualWidth` and
+// `virtualHeight` are set. Mouse positions are in the same space, they can be
+// outside of it when the cursor is over the borders around the scaled image.
 EXPORT void lurkWindowSize(lurkState *state, int* width, int* height);
 EXPORT int lurkIsWindowFullscreen(lurkState *state);
 EXPORT void lurkToggleFullscreen(lurkState *state);
@@ -318,9 +545,130 @@ EXPORT void lurkMouseScroll(lurkState *state, float *dx, float *dy);
 #define LURK_TEST_MODIFIER(STATE, ...) (lurkAnyKeysDown((STATE),  N_ARGS(__VA_ARGS__), __VA_ARGS__))
 EXPORT bool lurkTestKeyboardModifiers(lurkState *state, int count, ...);
 
+// Draw calls made on a thread between lurkBeginCommandBuffer and lurkEndCommandBuffer
+// are recorded into `buffer` instead of the frame. Each thread records into its own
+// buffer, so no locking is needed while recording. Submitted buffers are replayed
+// after the frame's own commands, ordered by `key` then by order of submission. A
+// negative `key` replays before the frame's own commands instead. A buffer goes to
+// the frame being recorded when it's submitted, or to the next one if that frame's
+// callbacks have already returned. Buffers belong to lurk until the frame they went
+// to has been rendered (one frame later when `maxFrameLatency` is 1) and are emptied
+// after. A zeroed lurkCommandBuffer is ready to use, release its memory with
+// lurkFreeCommandBuffer.
+//
+// With `immediateMode` the frame's own draws reach sokol_gp while the scene runs.
+// A frame that starts with a negative key buffer already submitted is recorded as
+// usual instead, but one submitted while the frame is running can only replay
+// after whatever the scene has drawn by then.
+EXPORT void lurkBeginCommandBuffer(lurkState *state, lurkCommandBuffer *buffer);
+EXPORT void lurkEndCommandBuffer(lurkState *state);
+EXPORT void lurkSubmitCommandBuffer(lurkState *state, lurkCommandBuffer *buffer, int key);
+EXPORT void lurkFreeCommandBuffer(lurkCommandBuffer *buffer);
+
+// Draw calls made between lurkBeginCommandList and lurkEndCommandList are stored
+// in `list` instead of being drawn, lurkCallCommandList then replays the whole
+// list as a single command, as many times as needed. Lists are meant to be
+// recorded once (in `init` or `reload`), arrays are always copied into them
+// (even by the NoCopy functions) and textures are resolved when recorded.
+// Beginning a list again replaces its contents, don't re-record or free a list
+// that was called in a frame that may still be rendering.
+EXPORT void lurkBeginCommandList(lurkState *state, lurkCommandList *list);
+EXPORT void lurkEndCommandList(lurkState *state);
+EXPORT void lurkCallCommandList(lurkState *state, lurkCommandList *list);
+// Same as lurkCallCommandList, with `transform` applied on top of the current transform
+EXPORT void lurkCallCommandListTransformed(lurkState *state, lurkCommandList *list, sgp_mat2x3 transform);
+EXPORT void lurkFreeCommandList(lurkCommandList *list);
+
+// Profiling zones, only built when LURK_ENABLE_PROFILER is defined (in config.h)
+// and compiled away to nothing otherwise. Zones nest and are recorded per thread,
+// scenes and the host share one timeline. lurkProfileDump writes what's been
+// recorded so far as a Chrome trace (open it in chrome://tracing or Perfetto),
+// the host dumps to DEFAULT_PROFILE_PATH when DEFAULT_PROFILE_KEY is pressed and
+// again on exit. Only the last LURK_PROFILE_RING_SIZE events of each thread are
+// kept, dumping while other threads are recording may catch a torn event.
+#if defined(LURK_ENABLE_PROFILER)
+EXPORT void lurkProfileBegin(lurkState *state, const char *name);
+EXPORT void lurkProfileEnd(lurkState *state);
+EXPORT bool lurkProfileDump(lurkState *state, const char *path);
+// Profiles the statement or block that follows, don't `return` or `break` out of it
+#define LURK_PROFILE(STATE, NAME) \
+    for (int _lurkZone = (lurkProfileBegin((STATE), (NAME)), 1); _lurkZone; _lurkZone = (lurkProfileEnd(STATE), 0))
+#else
+#define lurkProfileBegin(STATE, NAME) ((void)0)
+#define lurkProfileEnd(STATE) ((void)0)
+#define lurkProfileDump(STATE, PATH) (false)
+#define LURK_PROFILE(STATE, NAME)
+#endif
+
+// The fixed timestep can be changed at any time, see `tickRate`, `unlockFramerate`
+// and `updateMultiplicity` in SETTINGS. Changing any of them resyncs the loop,
+// the next frame starts with an empty accumulator.
+EXPORT void lurkSetTickRate(lurkState *state, int hz);
+EXPORT void lurkSetUnlockFramerate(lurkState *state, bool unlocked);
+EXPORT void lurkSetUpdateMultiplicity(lurkState *state, int multiplicity);
+
+// With `idle` set, frames are only drawn after input, a reload, a texture
+// arriving or one of these. Scenes that animate should request the next frame
+// from `frame`. Fixed updates don't run while idle, on waking up to
+// LURK_IDLE_MAX_CATCHUP ticks of the idle time are caught up and the rest is
+// dropped. On GL and D3D11 the last frame is kept in a render target the size
+// of the window and copied to it on the frames that aren't drawn, on Metal and
+// WebGL those frames aren't presented at all.
+EXPORT void lurkRequestRedraw(lurkState *state);
+EXPORT void lurkRequestRedrawAfter(lurkState *state, double seconds);
+
 EXPORT uint64_t lurkFindTexture(lurkState *state, const char *name);
 EXPORT void lurkCreateTexture(lurkState *state, const char *name, ezImage *image);
 
+// Render targets are textures that can be drawn into. They're created the same
+// way as textures, lurkFindTexture returns -1 until the frame after creation.
+// Draws between lurkBeginRenderTarget and lurkEndRenderTarget go into the
+// target (cleared to transparent first) in target pixels, not the frame, and
+// the target can be used with lurkSetImage like any other texture after. Targets
+// keep their contents between frames, so a static layer only has to be drawn
+// again once it changes:
+//
+//     if (lurkIsRenderTargetDirty(state, layer)) {
+//         lurkBeginRenderTarget(state, layer);
+//         ... draw the layer ...
+//         lurkEndRenderTarget(state);
+//     }
+//     lurkSetImage(state, layer, 0);
+//     lurkDrawTexturedRect(state, 0, dst, src);
+//
+// New targets start dirty, beginning a target clears the flag and
+// lurkInvalidateRenderTarget sets it again. Targets can be nested.
+EXPORT void lurkCreateRenderTarget(lurkState *state, const char *name, int w, int h);
+EXPORT void lurkBeginRenderTarget(lurkState *state, uint64_t target_id);
+EXPORT void lurkEndRenderTarget(lurkState *state);
+EXPORT bool lurkIsRenderTargetDirty(lurkState *state, uint64_t target_id);
+EXPORT void lurkInvalidateRenderTarget(lurkState *state, uint64_t target_id);
+
+// Sprite batches draw a lot of sprites with the texture in channel 0 as a single
+// instanced draw call. Each attribute has its own array, which is uploaded to
+// the GPU as it is, filling in the arrays is all the work left per sprite:
+//
+//     int i = lurkAddSprites(&batch, 1);
+//     batch.position[i] = (sgp_vec2){x, y};
+//     batch.src[i] = (sgp_rect){0.f, 0.f, 16.f, 16.f};
+//     ...
+//     lurkSetImage(state, texture, 0);
+//     lurkDrawSpriteBatch(state, &batch);
+//
+// lurkAddSprites returns the index of the first new sprite. New sprites are
+// unscaled, unrotated, white and on layer 0, `position` and `src` have to be
+// filled in. Sprites are drawn with the current transform, blend mode and
+// sampler (not the current color), in ascending `layer` and in order inside a
+// layer. Like the NoCopy functions, the batch is only read once the frame is
+// rendered and must stay unchanged until the frame it was drawn in has been
+// rendered (one frame later when `maxFrameLatency` is 1), batches drawn into
+// command lists are copied. `maxSprites` is shared by every batch drawn in a frame, sortDraws
+// doesn't move draws across a batch. A zeroed lurkSpriteBatch is ready to use.
+EXPORT int lurkAddSprites(lurkSpriteBatch *batch, int count);
+EXPORT void lurkClearSpriteBatch(lurkSpriteBatch *batch);
+EXPORT void lurkFreeSpriteBatch(lurkSpriteBatch *batch);
+EXPORT void lurkDrawSpriteBatch(lurkState *state, lurkSpriteBatch *batch);
+
 EXPORT void lurkProject(lurkState* state, float left, float right, float top, float bottom);
 EXPORT void lurkResetProject(lurkState* state);
 EXPORT void lurkPushTransform(lurkState* state);
@@ -331,6 +679,7 @@ EXPORT void lurkRotate(lurkState* state, float theta);
 EXPORT void lurkRotateAt(lurkState* state, float theta, float x, float y);
 EXPORT void lurkScale(lurkState* state, float sx, float sy);
 EXPORT void lurkScaleAt(lurkState* state, float sx, float sy, float x, float y);
+EXPORT void lurkMultiplyTransform(lurkState* state, sgp_mat2x3 matrix);
 EXPORT void lurkResetPipeline(lurkState* state);
 EXPORT void lurkSetUniform(lurkState* state, void* data, int size);
 EXPORT void lurkResetUniform(lurkState* state);
@@ -348,6 +697,14 @@ EXPORT void lurkScissor(lurkState* state, int x, int y, int w, int h);
 EXPORT void lurkResetScissor(lurkState* state);
 EXPORT void lurkResetState(lurkState* state);
 EXPORT void lurkClear(lurkState* state);
+// Draws recorded after lurkSetLayer belong to `layer` (0 at the start of each frame).
+// When `sortDraws` is enabled, layers are drawn in ascending order and the draws
+// inside a layer are grouped by pipeline, texture, blend mode and uniform, so
+// they batch into fewer draw calls (color is per vertex and never splits them).
+// Order inside a layer is only kept between draws with the same state, put
+// anything that must overlap in order on its own layer. Clear, viewport and
+// scissor changes flush the draws queued so far.
+EXPORT void lurkSetLayer(lurkState* state, int layer);
 EXPORT void lurkDrawPoints(lurkState* state, sgp_point* points, int count);
 EXPORT void lurkDrawPoint(lurkState* state, float x, float y);
 EXPORT void lurkDrawLines(lurkState* state, sgp_line* lines, int count);
@@ -360,6 +717,17 @@ EXPORT void lurkDrawFilledRects(lurkState* state, sgp_rect* rects, int count);
 EXPORT void lurkDrawFilledRect(lurkState* state, float x, float y, float w, float h);
 EXPORT void lurkDrawTexturedRects(lurkState* state, int channel, sgp_textured_rect* rects, int count);
 EXPORT void lurkDrawTexturedRect(lurkState* state, int channel, sgp_rect dest_rect, sgp_rect src_rect);
+// The array draw functions above copy the array, so it can be freed or reused
+// as soon as they return. These variants skip the copy and keep the pointer,
+// the array must stay valid (and unchanged) until the frame it was drawn in has
+// been rendered (one frame later when `maxFrameLatency` is 1).
+EXPORT void lurkDrawPointsNoCopy(lurkState* state, sgp_point* points, int count);
+EXPORT void lurkDrawLinesNoCopy(lurkState* state, sgp_line* lines, int count);
+EXPORT void lurkDrawLinesStripNoCopy(lurkState* state, sgp_point* points, int count);
+EXPORT void lurkDrawFilledTrianglesNoCopy(lurkState* state, sgp_triangle* triangles, int count);
+EXPORT void lurkDrawFilledTrianglesStripNoCopy(lurkState* state, sgp_point* points, int count);
+EXPORT void lurkDrawFilledRectsNoCopy(lurkState* state, sgp_rect* rects, int count);
+EXPORT void lurkDrawTexturedRectsNoCopy(lurkState* state, int channel, sgp_textured_rect* rects, int count);
 
 extern lurkState state;
 
@@ -5,6 +5,11 @@
 #define LURK_FIRST_SCENE "test"
 #define LURK_ASSETS_PATH "scenes/assets"
 
-#define LURK_SCENES \
-    X("test")       \
-    X("example")
+#define LURK_SCENES     \
+    X("test")           \
+    X("example")        \
+    X("stress_sprites") \
+    X("stress_rects")   \
+    X("stress_lines")   \
+    X("stress_blend")   \
+    X("stress_batch")
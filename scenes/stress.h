@@ -0,0 +1,139 @@
+/* stress.h -- https://github.com/takeiteasy/lurk
+
+ Shared ramp for the stress scenes. Each scene draws `count` objects a frame,
+ the ramp keeps doubling `count` while the CPU cost of a frame (recording +
+ rendering) stays inside the budget for `STRESS_TARGET_FPS`, then bisects
+ between the last count that fit and the first that didn't. Every step is
+ printed as it's measured and the final count is printed once it's found.
+ Counts never go past what fits in the sokol_gp buffers, raise `maxVertices`
+ and `maxDrawCommands` to push past that (or build the bench host with
+ `-DDEFAULT_MAX_VERTICES=... -DDEFAULT_MAX_DRAW_COMMANDS=...`). Scenes that
+ draw with sprite batches are limited by `maxSprites` instead.
+
+ Run a stress scene in the program or with `./build/bench [scene] 2000`. */
+
+#ifndef STRESS_HEADER
+#define STRESS_HEADER
+#include "lurk.h"
+#include <math.h>
+
+#if !defined(STRESS_TARGET_FPS)
+#define STRESS_TARGET_FPS 60
+#endif
+#define STRESS_BUDGET (1000.0 / STRESS_TARGET_FPS) // ms
+
+#if !defined(STRESS_WARMUP_FRAMES)
+#define STRESS_WARMUP_FRAMES 10
+#endif
+
+#if !defined(STRESS_SAMPLE_FRAMES)
+#define STRESS_SAMPLE_FRAMES 30
+#endif
+
+#if !defined(STRESS_PRECISION)
+#define STRESS_PRECISION 20 // stop when the range is within 1/N of the best count
+#endif
+
+#if !defined(STRESS_HEADROOM)
+#define STRESS_HEADROOM 64 // vertices and commands left for clears and the like
+#endif
+
+typedef struct {
+    const char *name;
+    int vertices, commands; // sokol_gp buffer space each object takes
+    int count; // objects to draw this frame
+    int best;  // most objects that fit in the budget
+    int limit; // fewest objects that didn't, 0 until one hasn't
+    int frames;
+    double cost;
+    bool done;
+} Stress;
+
+// Most objects the sokol_gp buffers can hold in a frame
+static int StressCapacity(Stress *stress, lurkState *state) {
+    if (!stress->vertices)
+        return state->maxSprites;
+    int capacity = (state->maxVertices - STRESS_HEADROOM) / stress->vertices;
+    if (stress->commands && (state->maxDrawCommands - STRESS_HEADROOM) / stress->commands < capacity)
+        capacity = (state->maxDrawCommands - STRESS_HEADROOM) / stress->commands;
+    return capacity > 1 ? capacity : 1;
+}
+
+// `vertices` and `commands` are how much each object adds to the sokol_gp
+// buffers, `commands` is 0 when consecutive objects batch into one draw and
+// `vertices` is 0 when they're drawn with a sprite batch
+static Stress StressBegin(lurkState *state, const char *name, int start, int vertices, int commands) {
+    Stress result = {
+        .name = name,
+        .vertices = vertices > 0 ? vertices : 0,
+        .commands = commands
+    };
+    int capacity = StressCapacity(&result, state);
+    result.count = start < 1 ? 1 : start > capacity ? capacity : start;
+    printf("[STRESS] %s: ramping from %d (at most %d) to find the most that fit %.3f ms (%dhz)\n",
+           name, result.count, capacity, STRESS_BUDGET, STRESS_TARGET_FPS);
+    return result;
+}
+
+// Call once a frame before drawing, returns how many objects to draw. The cost
+// of the frame before is what gets measured, so changing count costs a few
+// warmup frames before sampling starts again.
+static int StressStep(Stress *stress, lurkState *state) {
+    if (stress->done)
+        return stress->count;
+    if (++stress->frames > STRESS_WARMUP_FRAMES)
+        stress->cost += state->recordTime + state->renderTime;
+    if (stress->frames < STRESS_WARMUP_FRAMES + STRESS_SAMPLE_FRAMES)
+        return stress->count;
+
+    double cost = stress->cost / STRESS_SAMPLE_FRAMES;
+    bool fits = cost < STRESS_BUDGET;
+    printf("[STRESS] %s: %d, %.3f ms, %d draw calls%s\n",
+           stress->name, stress->count, cost, state->drawCalls, fits ? "" : " (over budget)");
+    if (fits)
+        stress->best = stress->count;
+    else
+        stress->limit = stress->count;
+    stress->frames = 0;
+    stress->cost = 0.0;
+
+    if (!stress->limit) {
+        int capacity = StressCapacity(stress, state);
+        if (stress->count < capacity) {
+            stress->count = stress->count < capacity / 2 ? stress->count * 2 : capacity;
+            return stress->count;
+        }
+        printf("[STRESS] %s: %d sustained at %dhz, limited by maxVertices/maxDrawCommands/maxSprites\n",
+               stress->name, stress->best, STRESS_TARGET_FPS);
+        stress->done = true;
+        return stress->count;
+    }
+    int precision = stress->best / STRESS_PRECISION;
+    if (stress->limit - stress->best <= (precision > 1 ? precision : 1)) {
+        printf("[STRESS] %s: %d sustained at %dhz\n", stress->name, stress->best, STRESS_TARGET_FPS);
+        stress->done = true;
+        stress->count = stress->best;
+    } else
+        stress->count = stress->best + (stress->limit - stress->best) / 2;
+    return stress->count;
+}
+
+// Grows `*array` to hold at least `count` items of `size` bytes, returns the
+// old capacity so the caller can initialise the new items
+static int StressReserve(void **array, int *capacity, int count, size_t size) {
+    int old = *capacity;
+    if (count <= old)
+        return old;
+    int next = old ? old : 256;
+    while (next < count)
+        next *= 2;
+    *array = realloc(*array, next * size);
+    *capacity = next;
+    return old;
+}
+
+static float StressRandom(float min, float max) {
+    return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+#endif // STRESS_HEADER
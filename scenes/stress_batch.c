@@ -0,0 +1,111 @@
+#include "stress.h"
+
+// Bunnymark again, with every sprite drawn by one lurkDrawSpriteBatch
+
+#define SPRITE_SIZE 32.f
+#define SPRITE_TEXTURE_SIZE 32
+#define SPRITE_GRAVITY 980.f
+
+struct lurkContext {
+    Stress stress;
+    sgp_vec2 *position, *velocity;
+    int capacity;
+    // The batch drawn last frame may still be rendering, so they take turns
+    lurkSpriteBatch batches[2];
+    int current;
+    ezImage image; // kept until the texture has been created
+    uint64_t texture;
+};
+
+static lurkContext* init(lurkState *state) {
+    lurkContext *result = calloc(1, sizeof(struct lurkContext));
+    result->stress = StressBegin(state, "batch", 1000, 0, 0);
+    // A white circle, the texture is created once this frame has been rendered
+    int size = SPRITE_TEXTURE_SIZE;
+    result->image = (ezImage) {
+        .w = size,
+        .h = size,
+        .buf = malloc(size * size * sizeof(int))
+    };
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++) {
+            int dx = 2 * x - size + 1, dy = 2 * y - size + 1;
+            result->image.buf[y * size + x] = dx * dx + dy * dy < size * size ? 0xFFFFFFFF : 0;
+        }
+    lurkCreateTexture(state, "stress_batch", &result->image);
+    result->texture = -1L;
+    return result;
+}
+
+static void deinit(lurkState *state, lurkContext *context) {
+    lurkFreeSpriteBatch(&context->batches[0]);
+    lurkFreeSpriteBatch(&context->batches[1]);
+    free(context->position);
+    free(context->velocity);
+    free(context->image.buf);
+    free(context);
+}
+
+static void preframe(lurkState *state, lurkContext *context) {
+    int count = StressStep(&context->stress, state);
+    int capacity = context->capacity;
+    StressReserve((void**)&context->velocity, &capacity, count, sizeof(sgp_vec2));
+    int old = StressReserve((void**)&context->position, &context->capacity, count, sizeof(sgp_vec2));
+    for (int i = old; i < context->capacity; i++) {
+        context->position[i] = (sgp_vec2){
+            StressRandom(SPRITE_SIZE / 2.f, state->windowWidth - SPRITE_SIZE / 2.f),
+            StressRandom(SPRITE_SIZE / 2.f, state->windowHeight / 2.f)
+        };
+        context->velocity[i] = (sgp_vec2){StressRandom(-250.f, 250.f), StressRandom(-250.f, 0.f)};
+    }
+}
+
+static bool update(lurkState *state, lurkContext *context, float delta) {
+    float min = SPRITE_SIZE / 2.f;
+    float maxX = state->windowWidth - SPRITE_SIZE / 2.f;
+    float maxY = state->windowHeight - SPRITE_SIZE / 2.f;
+    for (int i = 0; i < context->stress.count; i++) {
+        sgp_vec2 *position = &context->position[i], *velocity = &context->velocity[i];
+        velocity->y += SPRITE_GRAVITY * delta;
+        position->x += velocity->x * delta;
+        position->y += velocity->y * delta;
+        if (position->x < min || position->x > maxX) {
+            velocity->x = -velocity->x;
+            position->x = position->x < min ? min : maxX;
+        }
+        if (position->y > maxY) {
+            velocity->y = -velocity->y * .85f;
+            position->y = maxY;
+        } else if (position->y < min) {
+            velocity->y = 0.f;
+            position->y = min;
+        }
+    }
+    return true;
+}
+
+static void frame(lurkState *state, lurkContext *context, float delta) {
+    lurkSetColor(state, .39f, .58f, .92f, 1.f);
+    lurkClear(state);
+    lurkResetColor(state);
+    if (context->texture == -1L && (context->texture = lurkFindTexture(state, "stress_batch")) == -1L)
+        return;
+    lurkSpriteBatch *batch = &context->batches[context->current ^= 1];
+    int count = context->stress.count;
+    lurkClearSpriteBatch(batch);
+    lurkAddSprites(batch, count);
+    memcpy(batch->position, context->position, count * sizeof(sgp_vec2));
+    for (int i = 0; i < count; i++)
+        batch->src[i] = (sgp_rect){0.f, 0.f, SPRITE_TEXTURE_SIZE, SPRITE_TEXTURE_SIZE};
+    lurkSetImage(state, context->texture, 0);
+    lurkDrawSpriteBatch(state, batch);
+    lurkResetImage(state, 0);
+}
+
+EXPORT const lurkScene scene = {
+    .init = init,
+    .deinit = deinit,
+    .preframe = preframe,
+    .update = update,
+    .frame = frame
+};
@@ -0,0 +1,74 @@
+#include "stress.h"
+
+// Rects that each change color and blend mode, nothing batches unless `sortDraws` is on,
+// which groups them into one draw per blend mode (color is per vertex)
+
+#define BLEND_SIZE 24.f
+#define BLEND_MODES 3
+
+static const sgp_blend_mode modes[BLEND_MODES] = {
+    SGP_BLENDMODE_BLEND,
+    SGP_BLENDMODE_ADD,
+    SGP_BLENDMODE_MUL
+};
+
+typedef struct {
+    float x, y, hue;
+} Blob;
+
+struct lurkContext {
+    Stress stress;
+    Blob *blobs;
+    int capacity;
+    float time;
+};
+
+static lurkContext* init(lurkState *state) {
+    lurkContext *result = calloc(1, sizeof(struct lurkContext));
+    // 4 vertices a rect, plus room for the copies sokol_gp makes when it merges a draw past others
+    result->stress = StressBegin(state, "color + blend changes", 1000, 5, 1);
+    return result;
+}
+
+static void deinit(lurkState *state, lurkContext *context) {
+    free(context->blobs);
+    free(context);
+}
+
+static void preframe(lurkState *state, lurkContext *context) {
+    int count = StressStep(&context->stress, state);
+    int old = StressReserve((void**)&context->blobs, &context->capacity, count, sizeof(Blob));
+    for (int i = old; i < context->capacity; i++)
+        context->blobs[i] = (Blob) {
+            .x = StressRandom(0.f, state->windowWidth - BLEND_SIZE),
+            .y = StressRandom(0.f, state->windowHeight - BLEND_SIZE),
+            .hue = StressRandom(0.f, 6.2831853f)
+        };
+}
+
+static bool update(lurkState *state, lurkContext *context, float delta) {
+    context->time += delta;
+    return true;
+}
+
+static void frame(lurkState *state, lurkContext *context, float delta) {
+    lurkSetColor(state, .2f, .2f, .2f, 1.f);
+    lurkClear(state);
+    for (int i = 0; i < context->stress.count; i++) {
+        Blob *blob = &context->blobs[i];
+        float hue = blob->hue + context->time;
+        lurkSetBlendMode(state, modes[i % BLEND_MODES]);
+        lurkSetColor(state, .5f + .5f * sinf(hue), .5f + .5f * sinf(hue + 2.094f), .5f + .5f * sinf(hue + 4.189f), .75f);
+        lurkDrawFilledRect(state, blob->x, blob->y, BLEND_SIZE, BLEND_SIZE);
+    }
+    lurkResetBlendMode(state);
+    lurkResetColor(state);
+}
+
+EXPORT const lurkScene scene = {
+    .init = init,
+    .deinit = deinit,
+    .preframe = preframe,
+    .update = update,
+    .frame = frame
+};
@@ -0,0 +1,60 @@
+#include "stress.h"
+
+// Long waving line strips, `count` is the number of strips of LINE_POINTS points
+
+#define LINE_POINTS 256
+
+struct lurkContext {
+    Stress stress;
+    float *phases;
+    int capacity;
+    float time;
+    sgp_point points[LINE_POINTS];
+};
+
+static lurkContext* init(lurkState *state) {
+    lurkContext *result = calloc(1, sizeof(struct lurkContext));
+    result->stress = StressBegin(state, "line strips (256 points)", 16, LINE_POINTS, 1);
+    return result;
+}
+
+static void deinit(lurkState *state, lurkContext *context) {
+    free(context->phases);
+    free(context);
+}
+
+static void preframe(lurkState *state, lurkContext *context) {
+    int count = StressStep(&context->stress, state);
+    int old = StressReserve((void**)&context->phases, &context->capacity, count, sizeof(float));
+    for (int i = old; i < context->capacity; i++)
+        context->phases[i] = StressRandom(0.f, 6.2831853f);
+}
+
+static bool update(lurkState *state, lurkContext *context, float delta) {
+    context->time += delta;
+    return true;
+}
+
+static void frame(lurkState *state, lurkContext *context, float delta) {
+    lurkSetColor(state, .1f, .1f, .1f, 1.f);
+    lurkClear(state);
+    lurkSetColor(state, 0.f, 1.f, .5f, 1.f);
+    float step = (float)state->windowWidth / (LINE_POINTS - 1);
+    float amplitude = state->windowHeight / 4.f;
+    for (int i = 0; i < context->stress.count; i++) {
+        float phase = context->phases[i] + context->time;
+        float y = state->windowHeight * ((float)i / context->stress.count);
+        for (int j = 0; j < LINE_POINTS; j++)
+            context->points[j] = (sgp_point){j * step, y + sinf(phase + j * .05f) * amplitude};
+        lurkDrawLinesStrip(state, context->points, LINE_POINTS);
+    }
+    lurkResetColor(state);
+}
+
+EXPORT const lurkScene scene = {
+    .init = init,
+    .deinit = deinit,
+    .preframe = preframe,
+    .update = update,
+    .frame = frame
+};
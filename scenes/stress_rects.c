@@ -0,0 +1,74 @@
+#include "stress.h"
+
+// Bouncing filled rects in a single color, drawn one lurkDrawFilledRect at a time
+
+#define RECT_SIZE 16.f
+
+typedef struct {
+    float x, y, vx, vy;
+} Rect;
+
+struct lurkContext {
+    Stress stress;
+    Rect *rects;
+    int capacity;
+};
+
+static lurkContext* init(lurkState *state) {
+    lurkContext *result = calloc(1, sizeof(struct lurkContext));
+    result->stress = StressBegin(state, "rects", 1000, 4, 0);
+    return result;
+}
+
+static void deinit(lurkState *state, lurkContext *context) {
+    free(context->rects);
+    free(context);
+}
+
+static void preframe(lurkState *state, lurkContext *context) {
+    int count = StressStep(&context->stress, state);
+    int old = StressReserve((void**)&context->rects, &context->capacity, count, sizeof(Rect));
+    for (int i = old; i < context->capacity; i++)
+        context->rects[i] = (Rect) {
+            .x = StressRandom(0.f, state->windowWidth - RECT_SIZE),
+            .y = StressRandom(0.f, state->windowHeight - RECT_SIZE),
+            .vx = StressRandom(-200.f, 200.f),
+            .vy = StressRandom(-200.f, 200.f)
+        };
+}
+
+static bool update(lurkState *state, lurkContext *context, float delta) {
+    float maxX = state->windowWidth - RECT_SIZE;
+    float maxY = state->windowHeight - RECT_SIZE;
+    for (int i = 0; i < context->stress.count; i++) {
+        Rect *rect = &context->rects[i];
+        rect->x += rect->vx * delta;
+        rect->y += rect->vy * delta;
+        if (rect->x < 0.f || rect->x > maxX) {
+            rect->vx = -rect->vx;
+            rect->x = rect->x < 0.f ? 0.f : maxX;
+        }
+        if (rect->y < 0.f || rect->y > maxY) {
+            rect->vy = -rect->vy;
+            rect->y = rect->y < 0.f ? 0.f : maxY;
+        }
+    }
+    return true;
+}
+
+static void frame(lurkState *state, lurkContext *context, float delta) {
+    lurkSetColor(state, .1f, .1f, .1f, 1.f);
+    lurkClear(state);
+    lurkSetColor(state, 1.f, .5f, 0.f, 1.f);
+    for (int i = 0; i < context->stress.count; i++)
+        lurkDrawFilledRect(state, context->rects[i].x, context->rects[i].y, RECT_SIZE, RECT_SIZE);
+    lurkResetColor(state);
+}
+
+EXPORT const lurkScene scene = {
+    .init = init,
+    .deinit = deinit,
+    .preframe = preframe,
+    .update = update,
+    .frame = frame
+};
@@ -0,0 +1,102 @@
+#include "stress.h"
+
+// Bunnymark, bouncing textured sprites drawn one lurkDrawTexturedRect at a time
+
+#define SPRITE_SIZE 32.f
+#define SPRITE_TEXTURE_SIZE 32
+#define SPRITE_GRAVITY 980.f
+
+typedef struct {
+    float x, y, vx, vy;
+} Sprite;
+
+struct lurkContext {
+    Stress stress;
+    Sprite *sprites;
+    int capacity;
+    ezImage image; // kept until the texture has been created
+    uint64_t texture;
+};
+
+static lurkContext* init(lurkState *state) {
+    lurkContext *result = calloc(1, sizeof(struct lurkContext));
+    result->stress = StressBegin(state, "sprites", 1000, 4, 0);
+    // A white circle, the texture is created once this frame has been rendered
+    int size = SPRITE_TEXTURE_SIZE;
+    result->image = (ezImage) {
+        .w = size,
+        .h = size,
+        .buf = malloc(size * size * sizeof(int))
+    };
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++) {
+            int dx = 2 * x - size + 1, dy = 2 * y - size + 1;
+            result->image.buf[y * size + x] = dx * dx + dy * dy < size * size ? 0xFFFFFFFF : 0;
+        }
+    lurkCreateTexture(state, "stress_sprite", &result->image);
+    result->texture = -1L;
+    return result;
+}
+
+static void deinit(lurkState *state, lurkContext *context) {
+    free(context->sprites);
+    free(context->image.buf);
+    free(context);
+}
+
+static void preframe(lurkState *state, lurkContext *context) {
+    int count = StressStep(&context->stress, state);
+    int old = StressReserve((void**)&context->sprites, &context->capacity, count, sizeof(Sprite));
+    for (int i = old; i < context->capacity; i++)
+        context->sprites[i] = (Sprite) {
+            .x = StressRandom(0.f, state->windowWidth - SPRITE_SIZE),
+            .y = StressRandom(0.f, state->windowHeight / 2.f),
+            .vx = StressRandom(-250.f, 250.f),
+            .vy = StressRandom(-250.f, 0.f)
+        };
+}
+
+static bool update(lurkState *state, lurkContext *context, float delta) {
+    float maxX = state->windowWidth - SPRITE_SIZE;
+    float maxY = state->windowHeight - SPRITE_SIZE;
+    for (int i = 0; i < context->stress.count; i++) {
+        Sprite *sprite = &context->sprites[i];
+        sprite->vy += SPRITE_GRAVITY * delta;
+        sprite->x += sprite->vx * delta;
+        sprite->y += sprite->vy * delta;
+        if (sprite->x < 0.f || sprite->x > maxX) {
+            sprite->vx = -sprite->vx;
+            sprite->x = sprite->x < 0.f ? 0.f : maxX;
+        }
+        if (sprite->y > maxY) {
+            sprite->vy = -sprite->vy * .85f;
+            sprite->y = maxY;
+        } else if (sprite->y < 0.f) {
+            sprite->vy = 0.f;
+            sprite->y = 0.f;
+        }
+    }
+    return true;
+}
+
+static void frame(lurkState *state, lurkContext *context, float delta) {
+    lurkSetColor(state, .39f, .58f, .92f, 1.f);
+    lurkClear(state);
+    lurkResetColor(state);
+    if (context->texture == -1L && (context->texture = lurkFindTexture(state, "stress_sprite")) == -1L)
+        return;
+    lurkSetImage(state, context->texture, 0);
+    for (int i = 0; i < context->stress.count; i++)
+        lurkDrawTexturedRect(state, 0,
+                             (sgp_rect){context->sprites[i].x, context->sprites[i].y, SPRITE_SIZE, SPRITE_SIZE},
+                             (sgp_rect){0.f, 0.f, SPRITE_TEXTURE_SIZE, SPRITE_TEXTURE_SIZE});
+    lurkResetImage(state, 0);
+}
+
+EXPORT const lurkScene scene = {
+    .init = init,
+    .deinit = deinit,
+    .preframe = preframe,
+    .update = update,
+    .frame = frame
+};
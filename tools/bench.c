@@ -0,0 +1,305 @@
+/* bench.c -- https://github.com/takeiteasy/lurk
+
+ Windowless benchmark host. Loads a scene library, runs it for a fixed number
+ of frames as fast as possible (one fixed update and one update per frame, at
+ `tickRate`) and writes per-frame CPU timings to JSON, in nanoseconds.
+
+ Build with `make bench` and run
+ `./build/bench [scene] [frames] [output.json] [pipelined]`. `scene` is either a
+ path to a library or a scene name like `lurkSwapToScene` takes, timings go to
+ stdout when no output path is given (or it's `-`). Built with
+ LURK_ENABLE_PROFILER the zones are also written to DEFAULT_PROFILE_PATH.
+
+ With `pipelined` (or `maxFrameLatency` set to 1) the scene records on a second
+ thread while the frame before is replayed, like the program does. `wall` is
+ the time each frame took end to end, compare it between the two modes to see
+ how much of the recording is hidden behind the replay. */
+
+#include "headless.h"
+
+#define BENCH_DEFAULT_FRAMES 1000
+
+// All times are in nanoseconds, jim_float can't write small fractions
+typedef struct {
+    uint64_t preframe, fixedupdate, update, frame, postframe;
+    uint64_t record;  // all of the above, the scene records its commands in them
+    uint64_t process; // ProcessCommandBuffer
+    uint64_t flush;   // FlushCommands
+    uint64_t wall;    // the whole frame, recording overlaps the frame before's replay when pipelined
+    int commands;
+    size_t bytes;
+    size_t uploadBytes; // vertices and sprite arrays appended to GPU buffers
+    int culled; // primitives sokol_gp dropped off-screen
+    int drawCalls;
+} BenchFrame;
+
+#define BENCH_TIMINGS  \
+    X(preframe)        \
+    X(fixedupdate)     \
+    X(update)          \
+    X(frame)           \
+    X(postframe)       \
+    X(record)          \
+    X(process)         \
+    X(flush)           \
+    X(wall)
+
+#define BENCH_CALLBACK(FRAME, NAME, ...)                                       \
+    if (state.libraryScene->NAME) {                                            \
+        uint64_t start = stm_now();                                            \
+        state.libraryScene->NAME(&state, state.libraryContext, ##__VA_ARGS__); \
+        (FRAME)->NAME = (uint64_t)stm_ns(stm_since(start));                    \
+    }
+
+// Bytes appended to a stream buffer since the frame started
+static size_t AppendedBytes(sg_buffer buffer) {
+    if (buffer.id == SG_INVALID_ID)
+        return 0;
+    sg_buffer_info info = sg_query_buffer_info(buffer);
+    return info.append_frame_index == _sg.frame_index ? (size_t)info.append_pos : 0;
+}
+
+// Runs the scene's callbacks, recording a frame into `state.commandBuffer`
+static void RecordFrame(BenchFrame *frame) {
+    lurkProfileBegin(&state, "RecordFrame");
+    BENCH_CALLBACK(frame, preframe);
+    BENCH_CALLBACK(frame, fixedupdate, state.fixedDeltaTime);
+    ezEcsStep(state.world);
+    BENCH_CALLBACK(frame, update, state.fixedDeltaTime);
+    BENCH_CALLBACK(frame, frame, 1.0);
+    BENCH_CALLBACK(frame, postframe);
+    lurkProfileEnd(&state);
+    frame->record = frame->preframe + frame->fixedupdate + frame->update + frame->frame + frame->postframe;
+    state.recordTime = frame->record / 1e6;
+    frame->commands = state.commandBuffer.count;
+    frame->bytes = state.commandBuffer.size;
+}
+
+// Replays a recorded frame and submits it
+static void RenderFrame(BenchFrame *frame, lurkCommandBuffer *buffer) {
+    lurkProfileBegin(&state, "RenderFrame");
+    sgp_begin(state.windowWidth, state.windowHeight);
+    uint64_t start = stm_now();
+    LURK_PROFILE(&state, "ProcessCommandBuffer")
+        ProcessCommandBuffer(buffer);
+    frame->process = (uint64_t)stm_ns(stm_since(start));
+
+    state.pass_action.colors[0].clear_value = state.clearColor;
+    sg_begin_default_pass(&state.pass_action, state.windowWidth, state.windowHeight);
+    frame->drawCalls = CountDrawCalls() + targets.drawCalls + sprites.drawCalls;
+    targets.drawCalls = 0;
+    sprites.drawCalls = 0;
+    start = stm_now();
+    LURK_PROFILE(&state, "sgp_flush")
+        FlushCommands();
+    frame->flush = (uint64_t)stm_ns(stm_since(start));
+    frame->uploadBytes = AppendedBytes(_sgp.vertex_buf) + AppendedBytes(sprites.buffer);
+    frame->culled = sgp_query_culled();
+    frameStats.renderTime = (frame->process + frame->flush) / 1e6;
+    frameStats.drawCalls = frame->drawCalls;
+    frameStats.gpCommands = _sgp.cur_command;
+    frameStats.gpVertices = _sgp.cur_vertex;
+    frameStats.culledPrimitives = frame->culled;
+    frameStats.resolutionScale = 1.f;
+    sgp_end();
+    sg_end_pass();
+    sg_commit();
+    lurkProfileEnd(&state);
+}
+
+// False when the scene the last frame switched to couldn't be loaded.
+// ReloadLibrary skips a path it can't stat, so no scene loaded is a failure too.
+static bool SwitchScene(void) {
+    if (!state.nextScene)
+        return true;
+    if (!ReloadLibrary(state.nextScene) || !state.libraryScene) {
+        fprintf(stderr, "[FILE ERROR] Failed to load scene \"%s\"\n", state.nextScene);
+        return false;
+    }
+    state.nextScene = NULL;
+    return true;
+}
+
+static bool RunFrame(BenchFrame *frame) {
+    uint64_t start = stm_now();
+    FlushPendingTextures();
+    if (!SwitchScene())
+        return false;
+    RecordFrame(frame);
+    RenderFrame(frame, &state.commandBuffer);
+    PublishFrameStats();
+    frame->wall = (uint64_t)stm_ns(stm_since(start));
+    frameStats.frameTime = frame->wall / 1e6;
+    return true;
+}
+
+// The frames the record thread and the main thread are each on when pipelined
+static struct {
+    BenchFrame *frames;
+    int count, recorded, rendered;
+} bench;
+
+static void RecordNextFrame(void) {
+    // Nothing left to record once the last frame has been
+    if (bench.recorded < bench.count)
+        RecordFrame(&bench.frames[bench.recorded++]);
+}
+
+static void RenderNextFrame(lurkCommandBuffer *buffer) {
+    RenderFrame(&bench.frames[bench.rendered++], buffer);
+}
+
+// Runs the program's pipelined frame: frame i+1 records while frame i replays,
+// and the buffers are swapped in between. False when the record thread couldn't
+// be started, nothing has run then.
+static bool RunPipelined(BenchFrame *frames, int count) {
+    bench.frames = frames;
+    bench.count = count;
+    if (!StartPipeline(RecordNextFrame))
+        return false;
+    FlushPendingTextures();
+    KickRecord();
+    WaitForRecord();
+    for (int i = 0; i < count; i++) {
+        uint64_t start = stm_now();
+        PipelineFrame(RenderNextFrame);
+        LURK_PROFILE(&state, "WaitForRecord")
+            WaitForRecord();
+        frames[i].wall = (uint64_t)stm_ns(stm_since(start));
+        frameStats.frameTime = frames[i].wall / 1e6;
+    }
+    StopPipeline();
+    return true;
+}
+
+static void WriteFrame(Jim *jim, const BenchFrame *frame) {
+    jim_object_begin(jim);
+#define X(NAME)                 \
+    jim_member_key(jim, #NAME); \
+    jim_integer(jim, (long long)frame->NAME);
+    BENCH_TIMINGS
+#undef X
+    jim_member_key(jim, "commands");
+    jim_integer(jim, frame->commands);
+    jim_member_key(jim, "bytes");
+    jim_integer(jim, (long long)frame->bytes);
+    jim_member_key(jim, "uploadBytes");
+    jim_integer(jim, (long long)frame->uploadBytes);
+    jim_member_key(jim, "culled");
+    jim_integer(jim, frame->culled);
+    jim_member_key(jim, "drawCalls");
+    jim_integer(jim, frame->drawCalls);
+    jim_object_end(jim);
+}
+
+static void WriteResults(FILE *file, const char *scene, bool pipelined, BenchFrame *frames, int count) {
+    BenchFrame average = {0};
+    uint64_t commands = 0, bytes = 0, uploadBytes = 0, culled = 0, drawCalls = 0;
+    for (int i = 0; i < count; i++) {
+#define X(NAME) average.NAME += frames[i].NAME;
+        BENCH_TIMINGS
+#undef X
+        commands += frames[i].commands;
+        bytes += frames[i].bytes;
+        uploadBytes += frames[i].uploadBytes;
+        culled += frames[i].culled;
+        drawCalls += frames[i].drawCalls;
+    }
+#define X(NAME) average.NAME /= count;
+    BENCH_TIMINGS
+#undef X
+    average.commands = (int)(commands / count);
+    average.bytes = (size_t)(bytes / count);
+    average.uploadBytes = (size_t)(uploadBytes / count);
+    average.culled = (int)(culled / count);
+    average.drawCalls = (int)(drawCalls / count);
+
+    Jim jim = {
+        .sink = file,
+        .write = (Jim_Write)fwrite
+    };
+    jim_object_begin(&jim);
+    jim_member_key(&jim, "scene");
+    jim_string(&jim, scene);
+    jim_member_key(&jim, "width");
+    jim_integer(&jim, state.windowWidth);
+    jim_member_key(&jim, "height");
+    jim_integer(&jim, state.windowHeight);
+    jim_member_key(&jim, "pipelined");
+    jim_bool(&jim, pipelined);
+    jim_member_key(&jim, "frameCount");
+    jim_integer(&jim, count);
+    jim_member_key(&jim, "average");
+    WriteFrame(&jim, &average);
+    jim_member_key(&jim, "frames");
+    jim_array_begin(&jim);
+    for (int i = 0; i < count; i++)
+        WriteFrame(&jim, &frames[i]);
+    jim_array_end(&jim);
+    jim_object_end(&jim);
+    fputc('\n', file);
+}
+
+int main(int argc, char *argv[]) {
+    int frameCount = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_FRAMES;
+    if (argc < 2 || frameCount < 1) {
+        printf("  usage: %s [scene] [frames] [output.json] [pipelined]\n", argv[0]);
+        return 1;
+    }
+    bool pipelined = state.maxFrameLatency > 0 || (argc > 4 && !strcmp(argv[4], "pipelined"));
+
+    SetupHeadless((sgp_desc) {
+        .max_vertices = state.maxVertices,
+        .max_commands = state.maxDrawCommands
+    });
+#if defined(LURK_ENABLE_PROFILER)
+    state.profiler.now = stm_now;
+#endif
+
+    state.textureMapCapacity = 1;
+    state.textureMapCount = 0;
+    state.textureMap = imap_ensure(NULL, 1);
+    state.windowWidth = DEFAULT_WINDOW_WIDTH;
+    state.windowHeight = DEFAULT_WINDOW_HEIGHT;
+    state.clearColor = (sg_color){0.39f, 0.58f, 0.92f, 1.f};
+    state.timerFrequency = 1000000000L;
+    UpdateTimestep(&state);
+    state.world = ezEcsNewWorld();
+    state.running = true;
+
+    lurkSwapToScene(&state, argv[1]);
+    if (!SwitchScene())
+        return 1;
+
+    // A scene switch the scene asks for mid-run is picked up like the program
+    // does, only failing to load one stops the run early
+    BenchFrame *frames = calloc(frameCount, sizeof(BenchFrame));
+    if (pipelined && !RunPipelined(frames, frameCount))
+        pipelined = false;
+    if (!pipelined)
+        for (int i = 0; i < frameCount; i++)
+            if (!RunFrame(&frames[i]))
+                return 1;
+
+    FILE *file = stdout;
+    if (argc > 3 && strcmp(argv[3], "-") && !(file = fopen(argv[3], "w"))) {
+        fprintf(stderr, "[FILE ERROR] Failed to open \"%s\"\n", argv[3]);
+        return 1;
+    }
+    WriteResults(file, state.libraryPath, pipelined, frames, frameCount);
+    if (file != stdout)
+        fclose(file);
+#if defined(LURK_ENABLE_PROFILER)
+    lurkProfileDump(&state, DEFAULT_PROFILE_PATH);
+#endif
+
+    state.running = false;
+    if (state.libraryScene->deinit)
+        state.libraryScene->deinit(&state, state.libraryContext);
+    dlclose(state.libraryHandle);
+    ezEcsFreeWorld(&state.world);
+    free(frames);
+    free(state.renderBuffer.data);
+    ShutdownHeadless();
+    return 0;
+}
@@ -0,0 +1,250 @@
+/* capture_replay.c -- https://github.com/takeiteasy/lurk
+
+ Plays back a frame capture (see `captureFrames` in lurk.h) through the lurk
+ replay path, without the scene that recorded it. Every texture the capture
+ references is replaced by a blank texture of the same size. Prints how long
+ each frame took to replay.
+
+ Build with `make capture-replay` and run
+ `./build/capture_replay [capture] [loops] [sort]` */
+
+#include "headless.h"
+
+static unsigned char* ReadCapture(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "[FILE ERROR] No file exists at \"%s\"\n", path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *data = malloc(*size);
+    if (fread(data, 1, *size, file) != *size) {
+        fprintf(stderr, "[FILE ERROR] Failed to read \"%s\"\n", path);
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+static struct {
+    uint64_t id;
+    lurkTexture *texture;
+} *textures = NULL;
+static int textureCount = 0;
+
+static sg_image FindCaptureTexture(uint64_t id) {
+    for (int i = 0; i < textureCount; i++)
+        if (textures[i].id == id)
+            return textures[i].texture->internal;
+    return (sg_image){SG_INVALID_ID};
+}
+
+static void AddCaptureTexture(const lurkCaptureTextureData *data) {
+    textures = realloc(textures, (textureCount + 1) * sizeof(*textures));
+    textures[textureCount].id = data->id;
+    textures[textureCount++].texture = EmptyTexture(data->w, data->h);
+}
+
+static void AppendCommand(lurkCommandBuffer *buffer, const lurkCommand *command) {
+    if (buffer->size + command->size > buffer->capacity)
+        GrowCommandBuffer(buffer, command->size);
+    lurkCommand *copy = (lurkCommand*)(buffer->data + buffer->size);
+    memcpy(copy, command, command->size);
+    // Texture handles are only valid in the session that recorded them
+    if (copy->type == lurkCommandSetImage) {
+        lurkSetImageData *data = CommandData(copy);
+        data->image = FindCaptureTexture(data->texture);
+    }
+    buffer->size += command->size;
+    buffer->count++;
+}
+
+// The dummy backend reports no image limits, so texture records are checked
+// against a fixed size instead, one every desktop backend supports
+#define CAPTURE_MAX_TEXTURE_SIZE 8192
+
+// Smallest payload of each command, arrays and uniforms follow it inline
+static const size_t payloadSizes[lurkCommandCount] = {
+#define X(NAME, RECORDER, PARAMS, VALUES, FIELDS, REPLAY) [lurkCommand##NAME] = sizeof(lurk##NAME##Data),
+    LURK_COMMANDS
+#undef X
+};
+
+#define CHECK_ARRAY(NAME, TYPE, FIELD)                                               \
+    case lurkCommand##NAME: {                                                       \
+        const lurk##NAME##Data *data = CommandData(command);                        \
+        return !data->FIELD && data->count >= 0 &&                                  \
+               (size_t)data->count <= (payloadSize - sizeof(*data)) / sizeof(TYPE); \
+    }
+
+#define CHECK_CHANNEL(NAME)                                               \
+    case lurkCommand##NAME: {                                            \
+        const lurk##NAME##Data *data = CommandData(command);             \
+        return data->channel >= 0 && data->channel < SGP_TEXTURE_SLOTS; \
+    }
+
+// Render targets begun and not ended yet in the frame being read
+static int openTargets = 0;
+
+// Captures are read from disk, so each command is checked before it's queued.
+// Arrays have to be inline and commands that point into the recording
+// session's memory are never captured.
+static bool ValidCommand(lurkCommand *command) {
+    if (command->type >= lurkCommandCount)
+        return false;
+    size_t payloadSize = command->size - sizeof(lurkCommand);
+    if (payloadSize < payloadSizes[command->type])
+        return false;
+    switch (command->type) {
+        CHECK_ARRAY(DrawPoints, sgp_point, points)
+        CHECK_ARRAY(DrawLines, sgp_line, lines)
+        CHECK_ARRAY(DrawLinesStrip, sgp_point, points)
+        CHECK_ARRAY(DrawFilledTriangles, sgp_triangle, triangles)
+        CHECK_ARRAY(DrawFilledTrianglesStrip, sgp_point, points)
+        CHECK_ARRAY(DrawFilledRects, sgp_rect, rects)
+        case lurkCommandSetImage: {
+            // Every texture is declared before the commands that use it, and
+            // sokol_gp's default pipeline only samples the first channel
+            const lurkSetImageData *data = CommandData(command);
+            return data->channel == 0 && FindCaptureTexture(data->texture).id != SG_INVALID_ID;
+        }
+        CHECK_CHANNEL(UnsetImage)
+        CHECK_CHANNEL(ResetImage)
+        CHECK_CHANNEL(ResetSampler)
+        CHECK_CHANNEL(DrawTexturedRect)
+        case lurkCommandDrawTexturedRects: {
+            const lurkDrawTexturedRectsData *data = CommandData(command);
+            return !data->rects && data->count >= 0 && data->channel >= 0 && data->channel < SGP_TEXTURE_SLOTS &&
+                   (size_t)data->count <= (payloadSize - sizeof(*data)) / sizeof(sgp_textured_rect);
+        }
+        case lurkCommandSetBlendMode: {
+            const lurkSetBlendModeData *data = CommandData(command);
+            return data->blend_mode >= 0 && data->blend_mode < _SGP_BLENDMODE_NUM;
+        }
+        case lurkCommandDrawSpriteBatch: {
+            const lurkDrawSpriteBatchData *data = CommandData(command);
+            return !data->batch && data->count >= 0 &&
+                   (size_t)data->count <= (payloadSize - sizeof(*data)) / SpriteBatchSize(1);
+        }
+        case lurkCommandBeginRenderTarget: {
+            // Draws into targets are dropped on replay, but they're still
+            // batched in a nested sokol_gp frame the size of the target
+            const lurkBeginRenderTargetData *data = CommandData(command);
+            return data->w > 0 && data->h > 0 && ++openTargets <= LURK_MAX_RENDER_TARGET_DEPTH;
+        }
+        case lurkCommandEndRenderTarget:
+            return openTargets-- > 0;
+        // Uniforms need a custom pipeline and replay only has the default one,
+        // sgp_reset_state resets them too
+        case lurkCommandSetUniform:
+        case lurkCommandResetUniform:
+        case lurkCommandResetState:
+        case lurkCommandCreateTexture:
+        case lurkCommandCreateRenderTarget:
+        case lurkCommandCallCommandList:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Queues every frame in the capture and replays it at each frame end. Returns
+// false if a record is malformed, the frames before it have been replayed.
+static bool ReplayCapture(const char *path, unsigned char *data, size_t size, bool first, double *total, int *frames) {
+    size_t offset = sizeof(lurkCaptureHeader);
+    while (offset + sizeof(lurkCommand) <= size) {
+        lurkCommand *command = (lurkCommand*)(data + offset);
+        if (command->size < sizeof(lurkCommand) || command->size > size - offset ||
+            LURK_COMMAND_ALIGN(command->size) != command->size) {
+            fprintf(stderr, "[FILE ERROR] \"%s\" has a bad record size at byte %zu\n", path, offset);
+            return false;
+        }
+        switch (command->type) {
+            case lurkCaptureTexture: {
+                const lurkCaptureTextureData *texture = CommandData(command);
+                int maxSize = CAPTURE_MAX_TEXTURE_SIZE;
+                if (command->size - sizeof(lurkCommand) < sizeof(lurkCaptureTextureData) ||
+                    texture->w <= 0 || texture->h <= 0 || texture->w > maxSize || texture->h > maxSize) {
+                    fprintf(stderr, "[FILE ERROR] \"%s\" has a bad texture record at byte %zu\n", path, offset);
+                    return false;
+                }
+                if (first)
+                    AddCaptureTexture(texture);
+                break;
+            }
+            case lurkCaptureFrameEnd: {
+                // Targets left open end with the frame
+                openTargets = 0;
+                int commands = state.commandBuffer.count;
+                sgp_begin(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+                uint64_t start = stm_now();
+                ProcessCommandBuffer(&state.commandBuffer);
+                double elapsed = stm_ms(stm_since(start));
+                int drawCalls = CountDrawCalls() + sprites.drawCalls;
+                sprites.drawCalls = 0;
+                EndHeadlessFrame();
+                if (first)
+                    printf("%-8d %12d %12d %12.3f\n", *frames, commands, drawCalls, elapsed);
+                *total += elapsed;
+                (*frames)++;
+                break;
+            }
+            default:
+                if (!ValidCommand(command)) {
+                    fprintf(stderr, "[FILE ERROR] \"%s\" has a bad command (type %u) at byte %zu\n", path, command->type, offset);
+                    return false;
+                }
+                AppendCommand(&state.commandBuffer, command);
+                break;
+        }
+        offset += command->size;
+    }
+    return true;
+}
+
+int main(int argc, const char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : DEFAULT_CAPTURE_PATH;
+    int loops = argc > 2 ? atoi(argv[2]) : 1;
+    state.sortDraws = argc > 3 && !strcmp(argv[3], "sort");
+    if (loops < 1) {
+        fprintf(stderr, "usage: %s [capture] [loops > 0] [sort]\n", argv[0]);
+        return 1;
+    }
+
+    size_t size = 0;
+    unsigned char *data = ReadCapture(path, &size);
+    if (!data)
+        return 1;
+    lurkCaptureHeader *header = (lurkCaptureHeader*)data;
+    if (size < sizeof(lurkCaptureHeader) || header->magic != LURK_CAPTURE_MAGIC) {
+        fprintf(stderr, "[FILE ERROR] \"%s\" isn't a lurk capture\n", path);
+        free(data);
+        return 1;
+    }
+    if (header->version != LURK_CAPTURE_VERSION || header->commandCount != lurkCommandCount) {
+        fprintf(stderr, "[FILE ERROR] \"%s\" was captured by a different version of lurk\n", path);
+        free(data);
+        return 1;
+    }
+
+    SetupHeadless((sgp_desc){0});
+
+    printf("%-8s %12s %12s %12s\n", "frame", "commands", "draw calls", "replay (ms)");
+    double total = 0.0;
+    int frames = 0;
+    bool valid = true;
+    for (int loop = 0; valid && loop < loops; loop++)
+        valid = ReplayCapture(path, data, size, !loop, &total, &frames);
+    if (frames)
+        printf("%d frames, %.3f ms average\n", frames, total / frames);
+
+    for (int i = 0; i < textureCount; i++)
+        DestroyTexture(textures[i].texture);
+    free(textures);
+    free(data);
+    ShutdownHeadless();
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+/* cull_bench.c -- https://github.com/takeiteasy/lurk
+
+ Measures what per-primitive culling saves when most of a large array of
+ textured rects or triangles is off-screen. Each array is drawn with one
+ command, first with every primitive on screen, then spread over an area 25
+ times the window so only 1 in 25 can be seen.
+
+ Build with `make cull-bench` and run `./build/cull_bench [primitives]` */
+
+#include "headless.h"
+
+#define BENCH_FRAMES 100
+#define BENCH_SPREAD 5 // windows across and down the primitives are spread over when mostly off-screen
+
+static sgp_textured_rect *rects = NULL;
+static sgp_triangle *triangles = NULL;
+
+static void FillPrimitives(int count, int spread) {
+    srand(1);
+    float w = (float)(DEFAULT_WINDOW_WIDTH * spread), h = (float)(DEFAULT_WINDOW_HEIGHT * spread);
+    // the window sits in the middle of the area
+    float ox = -(float)(DEFAULT_WINDOW_WIDTH * (spread / 2)), oy = -(float)(DEFAULT_WINDOW_HEIGHT * (spread / 2));
+    for (int i = 0; i < count; i++) {
+        float x = ox + (float)rand() / (float)RAND_MAX * (w - 16.f);
+        float y = oy + (float)rand() / (float)RAND_MAX * (h - 16.f);
+        rects[i] = (sgp_textured_rect){{x, y, 16.f, 16.f}, {0.f, 0.f, 32.f, 32.f}};
+        triangles[i] = (sgp_triangle){{x, y}, {x + 16.f, y}, {x, y + 16.f}};
+    }
+}
+
+static void RecordPrimitives(int count, bool textured) {
+    if (textured) {
+        lurkSetImage(&state, 1, 0);
+        lurkDrawTexturedRectsNoCopy(&state, 0, rects, count);
+        lurkResetImage(&state, 0);
+    } else
+        lurkDrawFilledTrianglesNoCopy(&state, triangles, count);
+}
+
+int main(int argc, const char *argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 50000;
+    assert(count > 0);
+
+    SetupHeadless((sgp_desc) {
+        .max_vertices = count * 4 + 64,
+        .max_commands = 64
+    });
+
+    lurkTexture *texture = AddBlankTexture(1, 32, 32);
+    rects = malloc(count * sizeof(sgp_textured_rect));
+    triangles = malloc(count * sizeof(sgp_triangle));
+
+    printf("%d primitives\n", count);
+    printf("%-10s %-10s %10s %10s %14s %12s\n", "primitive", "on screen", "vertices", "culled", "upload (KiB)", "replay (ms)");
+    for (int textured = 1; textured >= 0; textured--)
+        for (int spread = 1; spread <= BENCH_SPREAD; spread += BENCH_SPREAD - 1) {
+            FillPrimitives(count, spread);
+            uint64_t replayTime = 0;
+            uint32_t vertices = 0, culled = 0;
+            size_t upload = 0;
+            for (int i = 0; i < BENCH_FRAMES; i++) {
+                sgp_begin(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+                RecordPrimitives(count, textured);
+                uint64_t start = stm_now();
+                ProcessCommandBuffer(&state.commandBuffer);
+                replayTime += stm_since(start);
+                vertices = _sgp.cur_vertex - _sgp.state._base_vertex;
+                culled = sgp_query_culled();
+                EndHeadlessFrame();
+                upload = (size_t)sg_query_buffer_info(_sgp.vertex_buf).append_pos;
+            }
+            char visible[16] = "all";
+            if (spread > 1)
+                snprintf(visible, sizeof(visible), "1/%d", spread * spread);
+            printf("%-10s %-10s %10u %10u %14.1f %12.3f\n", textured ? "rects" : "triangles",
+                   visible, vertices, culled, upload / 1024.0, stm_ms(replayTime) / BENCH_FRAMES);
+        }
+
+    free(rects);
+    free(triangles);
+    DestroyTexture(texture);
+    ShutdownHeadless();
+    return 0;
+}
@@ -0,0 +1,53 @@
+/* headless.h -- https://github.com/takeiteasy/lurk
+
+ Shared by the tools in this folder that run lurk (transform_bench only
+ measures sokol_gp and includes it alone). They include lurk.c through this
+ header and run headless on the sokol dummy backend: no window, nothing is
+ shown and the GPU is never waited on, so only the CPU side of a frame is
+ measured. Not every tool uses every helper, so they're all inline. */
+
+#define SOKOL_DUMMY_BACKEND
+#define LURK_HEADLESS
+#include "lurk.c"
+
+// Starts sokol_gfx, sokol_time and sokol_gp, a zeroed `desc` takes sokol_gp's defaults
+static inline void SetupHeadless(sgp_desc desc) {
+    sg_setup(&(sg_desc){0});
+    stm_setup();
+    sgp_setup(&desc);
+    assert(sg_isvalid() && sgp_is_valid());
+}
+
+// Makes a blank texture that lurkSetImage finds under `id`
+static inline lurkTexture* AddBlankTexture(uint64_t id, int w, int h) {
+    lurkTexture *texture = EmptyTexture(w, h);
+    state.textureMap = imap_ensure(state.textureMap, 1);
+    imap_slot_t *slot = imap_assign(state.textureMap, id);
+    assert(slot);
+    imap_setval64(state.textureMap, slot, (uint64_t)texture);
+    return texture;
+}
+
+// Ends a frame started with sgp_begin, flushing it into the default pass and
+// submitting it. Textures created while it was replayed are added to the
+// texture map after, as the program does between frames. Returns how long the
+// flush took, in stm ticks.
+static inline uint64_t EndHeadlessFrame(void) {
+    sg_begin_default_pass(&state.pass_action, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+    uint64_t start = stm_now();
+    FlushCommands();
+    uint64_t flushTime = stm_since(start);
+    sgp_end();
+    sg_end_pass();
+    sg_commit();
+    FlushPendingTextures();
+    return flushTime;
+}
+
+// Textures added with AddBlankTexture are the caller's to destroy before this
+static inline void ShutdownHeadless(void) {
+    free(state.commandBuffer.data);
+    DestroySprites();
+    sgp_shutdown();
+    sg_shutdown();
+}
@@ -0,0 +1,121 @@
+/* replay_bench.c -- https://github.com/takeiteasy/lurk
+
+ Microbenchmark for the lurk command buffer. Records a batch of commands
+ through the public lurk API then times how long `ProcessCommandBuffer` takes
+ to replay them into sokol_gp, along with how many commands the replay
+ filter dropped per frame. The same commands are then timed in immediate
+ mode, where each call goes straight to sokol_gp.
+
+ Build with `make replay-bench` and run `./build/replay_bench [iterations]` */
+
+#include "headless.h"
+
+#define BENCH_COMMANDS 10000
+
+static void RecordSetColor(int i) {
+    lurkSetColor(&state, (float)(i & 1), 0.f, 0.f, 1.f);
+}
+
+static void RecordTranslate(int i) {
+    lurkTranslate(&state, 1.f, (float)i);
+}
+
+static void RecordDrawFilledRect(int i) {
+    lurkDrawFilledRect(&state, (float)(i % 64), (float)(i / 64), 1.f, 1.f);
+}
+
+static void RecordMixed(int i) {
+    switch (i % 4) {
+        case 0:
+            lurkPushTransform(&state);
+            break;
+        case 1:
+            lurkTranslate(&state, (float)(i % 64), (float)(i / 64));
+            break;
+        case 2:
+            lurkDrawFilledRect(&state, 0.f, 0.f, 1.f, 1.f);
+            break;
+        case 3:
+            lurkPopTransform(&state);
+            break;
+    }
+}
+
+static void RecordTransformRun(int i) {
+    switch (i % 4) {
+        case 0:
+            lurkTranslate(&state, 1.f, 0.f);
+            break;
+        case 1:
+            lurkRotate(&state, .01f);
+            break;
+        case 2:
+            lurkScale(&state, 1.f, 1.f);
+            break;
+        case 3:
+            lurkDrawFilledRect(&state, 0.f, 0.f, 1.f, 1.f);
+            break;
+    }
+}
+
+static void RecordRedundant(int i) {
+    if (i % 2)
+        lurkSetColor(&state, 1.f, 0.f, 0.f, 1.f);
+    else
+        lurkDrawFilledRect(&state, (float)(i % 64), (float)(i / 64), 1.f, 1.f);
+}
+
+static struct {
+    const char *name;
+    void(*record)(int);
+} benchmarks[] = {
+    {"SetColor", RecordSetColor},
+    {"Translate", RecordTranslate},
+    {"DrawFilledRect", RecordDrawFilledRect},
+    {"Mixed", RecordMixed},
+    {"TransformRun", RecordTransformRun},
+    {"Redundant", RecordRedundant}
+};
+
+int main(int argc, const char *argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 100;
+    assert(iterations > 0);
+
+    SetupHeadless((sgp_desc){0});
+
+    printf("%-16s %12s %12s %12s %15s\n", "command", "record (ns)", "replay (ns)", "filtered", "immediate (ns)");
+    for (int b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++) {
+        uint64_t recordTime = 0, replayTime = 0, immediateTime = 0;
+        int filtered = 0;
+        for (int i = 0; i < iterations; i++) {
+            sgp_begin(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+            uint64_t start = stm_now();
+            for (int j = 0; j < BENCH_COMMANDS; j++)
+                benchmarks[b].record(j);
+            recordTime += stm_since(start);
+            start = stm_now();
+            ProcessCommandBuffer(&state.commandBuffer);
+            replayTime += stm_since(start);
+            filtered = replayStats.redundant + replayStats.transforms;
+            EndHeadlessFrame();
+
+            sgp_begin(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+            state.immediate = ReplayCommandTable;
+            start = stm_now();
+            for (int j = 0; j < BENCH_COMMANDS; j++)
+                benchmarks[b].record(j);
+            immediateTime += stm_since(start);
+            state.immediate = NULL;
+            EndHeadlessFrame();
+        }
+        double commands = (double)iterations * BENCH_COMMANDS;
+        printf("%-16s %12.2f %12.2f %12d %15.2f\n", benchmarks[b].name,
+               stm_ns(recordTime) / commands,
+               stm_ns(replayTime) / commands,
+               filtered,
+               stm_ns(immediateTime) / commands);
+    }
+
+    ShutdownHeadless();
+    return 0;
+}
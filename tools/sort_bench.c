@@ -0,0 +1,71 @@
+/* sort_bench.c -- https://github.com/takeiteasy/lurk
+
+ Counts the sokol_gp draw calls made for a frame of overlapping sprites that
+ use a mix of textures and tints, with and without `sortDraws`.
+
+ Build with `make sort-bench` and run `./build/sort_bench [sprites] [textures] [layers]` */
+
+#include "headless.h"
+
+#define BENCH_FRAMES 100
+#define BENCH_MAX_TEXTURES 64
+
+static const float tints[4][4] = {
+    {1.f, 1.f, 1.f, 1.f},
+    {1.f, .5f, .5f, 1.f},
+    {.5f, 1.f, .5f, 1.f},
+    {.5f, .5f, 1.f, 1.f}
+};
+
+static void RecordSprites(int sprites, int textures, int layers) {
+    srand(1);
+    for (int i = 0; i < sprites; i++) {
+        int texture = rand() % textures;
+        const float *tint = tints[rand() % 4];
+        float x = (float)(rand() % (DEFAULT_WINDOW_WIDTH - 32));
+        float y = (float)(rand() % (DEFAULT_WINDOW_HEIGHT - 32));
+        lurkSetLayer(&state, i * layers / sprites);
+        lurkSetImage(&state, texture + 1, 0);
+        lurkSetColor(&state, tint[0], tint[1], tint[2], tint[3]);
+        lurkDrawTexturedRect(&state, 0, (sgp_rect){x, y, 32.f, 32.f}, (sgp_rect){0.f, 0.f, 32.f, 32.f});
+    }
+    lurkResetImage(&state, 0);
+    lurkResetColor(&state);
+}
+
+int main(int argc, const char *argv[]) {
+    int sprites = argc > 1 ? atoi(argv[1]) : 2000;
+    int textures = argc > 2 ? atoi(argv[2]) : 8;
+    int layers = argc > 3 ? atoi(argv[3]) : 1;
+    assert(sprites > 0 && textures > 0 && textures <= BENCH_MAX_TEXTURES && layers > 0);
+
+    SetupHeadless((sgp_desc){0});
+
+    lurkTexture *spriteTextures[BENCH_MAX_TEXTURES];
+    for (int i = 0; i < textures; i++)
+        spriteTextures[i] = AddBlankTexture(i + 1, 32, 32);
+
+    printf("%d sprites, %d textures, %d layers\n", sprites, textures, layers);
+    printf("%-10s %12s %12s\n", "mode", "draw calls", "replay (ms)");
+    for (int sorted = 0; sorted < 2; sorted++) {
+        state.sortDraws = sorted;
+        uint64_t replayTime = 0;
+        int drawCalls = 0;
+        for (int i = 0; i < BENCH_FRAMES; i++) {
+            sgp_begin(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+            RecordSprites(sprites, textures, layers);
+            uint64_t start = stm_now();
+            ProcessCommandBuffer(&state.commandBuffer);
+            replayTime += stm_since(start);
+            drawCalls = CountDrawCalls();
+            EndHeadlessFrame();
+        }
+        printf("%-10s %12d %12.3f\n", sorted ? "sorted" : "unsorted", drawCalls,
+               stm_ms(replayTime) / BENCH_FRAMES);
+    }
+
+    for (int i = 0; i < textures; i++)
+        DestroyTexture(spriteTextures[i]);
+    ShutdownHeadless();
+    return 0;
+}
@@ -0,0 +1,87 @@
+/* transform_bench.c -- https://github.com/takeiteasy/lurk
+
+ Microbenchmark for the sokol_gp vertex transform kernels. Times every kernel
+ built for this target that the CPU supports, transforming and bounding batches
+ of 10k to 1M vertices in place, and checks each one against the scalar
+ kernel. The kernel sokol_gp picks at runtime is marked with a `*`.
+
+ Build with `make transform-bench` and run `./build/transform_bench [iterations]` */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <assert.h>
+// Only sokol_gp is measured, so lurk isn't included
+#define SOKOL_IMPL
+#define SOKOL_DUMMY_BACKEND
+#include "sokol_gfx.h"
+#include "sokol_time.h"
+#include "sokol_gp.h"
+
+static const uint32_t batchSizes[] = {10000, 100000, 1000000};
+
+// Near identity so the positions stay bounded over the iterations
+static const sgp_mat2x3 rotation = {{
+    {0.99999f, -0.00447f, 0.5f},
+    {0.00447f, 0.99999f, -0.5f}
+}};
+
+static void FillVertices(_sgp_vertex *vertices, uint32_t count) {
+    srand(1);
+    for (uint32_t i = 0; i < count; i++)
+        vertices[i] = (_sgp_vertex) {
+            .position = {(float)(rand() % 2000) - 1000.f, (float)(rand() % 2000) - 1000.f}
+        };
+}
+
+// Transforms a fresh copy once and compares positions and bounds to the scalar kernel
+static bool MatchesScalar(_sgp_transform_func transform, _sgp_vertex *vertices, _sgp_vertex *expected, uint32_t count) {
+    _sgp_region region = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+    _sgp_region expectedRegion = region;
+    FillVertices(vertices, count);
+    FillVertices(expected, count);
+    transform(&rotation, vertices, count, &region);
+    _sgp_transform_vertices_scalar(&rotation, expected, count, &expectedRegion);
+    return !memcmp(vertices, expected, count * sizeof(_sgp_vertex)) &&
+           !memcmp(&region, &expectedRegion, sizeof(_sgp_region));
+}
+
+int main(int argc, const char *argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 100;
+    assert(iterations > 0);
+    stm_setup();
+
+    uint32_t largest = batchSizes[sizeof(batchSizes) / sizeof(batchSizes[0]) - 1];
+    _sgp_vertex *vertices = malloc(largest * sizeof(_sgp_vertex));
+    _sgp_vertex *expected = malloc(largest * sizeof(_sgp_vertex));
+    _sgp_transform_kernel selected = _sgp_select_transform_kernel();
+    int kernelCount = sizeof(_sgp_transform_kernels) / sizeof(_sgp_transform_kernels[0]);
+
+    printf("%-8s %10s %12s %12s %10s %8s\n", "kernel", "vertices", "ns/vertex", "Mvertices/s", "speedup", "matches");
+    for (int b = 0; b < sizeof(batchSizes) / sizeof(batchSizes[0]); b++) {
+        uint32_t count = batchSizes[b];
+        double scalarTime = 0.0;
+        for (int k = kernelCount - 1; k >= 0; k--) {
+            const _sgp_transform_kernel *kernel = &_sgp_transform_kernels[k];
+            if (kernel->supported && !kernel->supported())
+                continue;
+            bool matches = MatchesScalar(kernel->transform, vertices, expected, count);
+            FillVertices(vertices, count);
+            _sgp_region region = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+            uint64_t start = stm_now();
+            for (int i = 0; i < iterations; i++)
+                kernel->transform(&rotation, vertices, count, &region);
+            double elapsed = stm_ns(stm_since(start)) / iterations;
+            if (!kernel->supported && !strcmp(kernel->name, "scalar"))
+                scalarTime = elapsed;
+            printf("%-7s%c %10u %12.3f %12.1f %9.2fx %8s\n", kernel->name,
+                   kernel->transform == selected.transform ? '*' : ' ', count, elapsed / count,
+                   count / elapsed * 1e3, scalarTime / elapsed, matches ? "yes" : "NO");
+        }
+    }
+
+    free(vertices);
+    free(expected);
+    return 0;
+}
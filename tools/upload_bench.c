@@ -0,0 +1,67 @@
+/* upload_bench.c -- https://github.com/takeiteasy/lurk
+
+ Measures the vertex bytes sokol_gp uploads for a frame of textured and filled
+ rects, drawn as 6 vertices per rect and through the shared quad index buffer
+ (4 vertices per rect).
+
+ Build with `make upload-bench` and run `./build/upload_bench [rects]` */
+
+#include "headless.h"
+
+#define BENCH_FRAMES 100
+
+static void RecordRects(int rects) {
+    srand(1);
+    lurkSetImage(&state, 1, 0);
+    for (int i = 0; i < rects; i++) {
+        float x = (float)(rand() % (DEFAULT_WINDOW_WIDTH - 32));
+        float y = (float)(rand() % (DEFAULT_WINDOW_HEIGHT - 32));
+        lurkSetColor(&state, (float)(i % 4) / 4.f, 1.f, 1.f, 1.f);
+        if (i % 2)
+            lurkDrawTexturedRect(&state, 0, (sgp_rect){x, y, 32.f, 32.f}, (sgp_rect){0.f, 0.f, 32.f, 32.f});
+        else
+            lurkDrawFilledRect(&state, x, y, 32.f, 32.f);
+    }
+    lurkResetImage(&state, 0);
+    lurkResetColor(&state);
+}
+
+int main(int argc, const char *argv[]) {
+    int rects = argc > 1 ? atoi(argv[1]) : 10000;
+    assert(rects > 0);
+
+    SetupHeadless((sgp_desc) {
+        .max_vertices = rects * 6 + 64,
+        .max_commands = rects + 64
+    });
+
+    lurkTexture *texture = AddBlankTexture(1, 32, 32);
+
+    // Hiding the index buffer makes sokol_gp fall back to 6 vertices per rect
+    sg_buffer quadIndices = _sgp.quad_index_buf;
+    printf("%d rects\n", rects);
+    printf("%-10s %12s %14s %12s %12s\n", "mode", "vertices", "upload (KiB)", "replay (ms)", "flush (ms)");
+    for (int indexed = 0; indexed < 2; indexed++) {
+        _sgp.quad_index_buf = indexed ? quadIndices : (sg_buffer){SG_INVALID_ID};
+        uint64_t replayTime = 0, flushTime = 0;
+        uint32_t vertices = 0;
+        size_t upload = 0;
+        for (int i = 0; i < BENCH_FRAMES; i++) {
+            sgp_begin(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+            RecordRects(rects);
+            uint64_t start = stm_now();
+            ProcessCommandBuffer(&state.commandBuffer);
+            replayTime += stm_since(start);
+            vertices = _sgp.cur_vertex - _sgp.state._base_vertex;
+            flushTime += EndHeadlessFrame();
+            upload = (size_t)sg_query_buffer_info(_sgp.vertex_buf).append_pos;
+        }
+        printf("%-10s %12u %14.1f %12.3f %12.3f\n", indexed ? "indexed" : "6 verts", vertices,
+               upload / 1024.0, stm_ms(replayTime) / BENCH_FRAMES, stm_ms(flushTime) / BENCH_FRAMES);
+    }
+    _sgp.quad_index_buf = quadIndices;
+
+    DestroyTexture(texture);
+    ShutdownHeadless();
+    return 0;
+}